@@ -71,7 +71,7 @@ AbstractEdgeShape::initFromEntity ( const Entity *e )
   Edge::initFromEntity ( e );
 
   /* src anchor */
-  attr_v = e->getValueOfAttribute ( ATTR_EDGE_SRC_STYLE );
+  attr_v = e->getValueOfAttribute ( NAME_EDGE_SRC_STYLE );
 
   if ( attr_v == NULL )
     this->srcAnchor = new AnchorLine ( this, ANCHOR_SRC );
@@ -93,14 +93,14 @@ AbstractEdgeShape::initFromEntity ( const Entity *e )
       std::cerr << "warning: anchor shape \'" << attr_v << "\' is invalid.\n";
     }
 
-  if ( (attr_v = e->getValueOfAttribute ( ATTR_EDGE_SRC_TEXT ) ) != NULL )
+  if ( (attr_v = e->getValueOfAttribute ( NAME_EDGE_SRC_TEXT ) ) != NULL )
     this->srcAnchor->setText ( attr_v );
 
-  ((AbstractNodeShape *) this->src)->registerAnchor ( this->srcAnchor, e->getValueOfAttribute(ATTR_EDGE_SRC_PORT) );
+  ((AbstractNodeShape *) this->src)->registerAnchor ( this->srcAnchor, e->getValueOfAttribute(NAME_EDGE_SRC_PORT) );
     
 
   /* dest anchor */
-  attr_v = e->getValueOfAttribute ( ATTR_EDGE_DEST_STYLE );
+  attr_v = e->getValueOfAttribute ( NAME_EDGE_DEST_STYLE );
 
   if ( attr_v == NULL )
     this->destAnchor = new AnchorArrow ( this, ANCHOR_DEST );
@@ -122,10 +122,10 @@ AbstractEdgeShape::initFromEntity ( const Entity *e )
       std::cerr << "warning: anchor shape \'" << attr_v << "\' is invalid.\n";
     }
 
-  if ( (attr_v = e->getValueOfAttribute ( ATTR_EDGE_DEST_TEXT ) ) != NULL )
+  if ( (attr_v = e->getValueOfAttribute ( NAME_EDGE_DEST_TEXT ) ) != NULL )
     this->destAnchor->setText ( attr_v );
 
-  ((AbstractNodeShape *) this->dest)->registerAnchor ( this->destAnchor, e->getValueOfAttribute(ATTR_EDGE_DEST_PORT) );
+  ((AbstractNodeShape *) this->dest)->registerAnchor ( this->destAnchor, e->getValueOfAttribute(NAME_EDGE_DEST_PORT) );
 
   /* hover pen */
   this->initHoverPen ( );
@@ -78,7 +78,7 @@ AbstractGroupShape::initFromEntity ( const Entity *e )
       this->height = 16.0;
     }
 
-  attr_v = e->getValueOfAttribute ( ATTR_GROUP_SHAPE );
+  attr_v = e->getValueOfAttribute ( NAME_GROUP_SHAPE );
 
   if ( attr_v == NULL )
     this->n_shape = GRP_NODE_SHAPE_RECTANGLE;
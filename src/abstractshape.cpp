@@ -74,6 +74,22 @@ AbstractShape::AbstractShape ( )
 }
 
 
+/*
+ * Color of an attribute: hexadecimal colors are parsed once by the
+ * attribute, only color names go through QColor's own parser.
+ */
+static inline QColor
+color_of_attribute ( const Attribute *a )
+{
+  unsigned int argb;
+
+  if ( a->getValueAsColor(&argb) )
+    return QColor::fromRgba ( argb );
+
+  return QColor ( a->getValue() );
+}
+
+
 /*
  * Initialize a shape's pen using an Entity object.
  */
@@ -84,13 +100,13 @@ AbstractShape::initPenFromEntity ( const Entity *e )
   Attribute *a;
 
   /* load pen color */
-  attr_v = e->getValueOfAttribute ( ATTR_PEN_COLOR );
+  a = e->getAttribute ( NAME_PEN_COLOR );
 
-  if ( attr_v != NULL )
-    this->pen.setColor ( QColor(attr_v) );
+  if ( a != NULL )
+    this->pen.setColor ( color_of_attribute(a) );
 
   /* load pen style */
-  attr_v = e->getValueOfAttribute ( ATTR_PEN_STYLE );
+  attr_v = e->getValueOfAttribute ( NAME_PEN_STYLE );
 
   if ( attr_v != NULL )
     {
@@ -109,7 +125,7 @@ AbstractShape::initPenFromEntity ( const Entity *e )
     }
 
   /* load pen width */
-  a = e->getAttribute ( ATTR_PEN_WIDTH );
+  a = e->getAttribute ( NAME_PEN_WIDTH );
 
   if ( a != NULL )
     this->pen.setWidth ( a->getValueAsInt() );
@@ -125,15 +141,16 @@ void
 AbstractShape::initBrushFromEntity ( const Entity *e )
 {
   const char *attr_v;
+  Attribute *a;
 
   /* load brush color */
-  attr_v = e->getValueOfAttribute ( ATTR_BRUSH_COLOR );
+  a = e->getAttribute ( NAME_BRUSH_COLOR );
 
-  if ( attr_v != NULL )
-    this->brush.setColor ( QColor(attr_v) );
+  if ( a != NULL )
+    this->brush.setColor ( color_of_attribute(a) );
 
   /* load brush style */
-  attr_v = e->getValueOfAttribute ( ATTR_BRUSH_STYLE );
+  attr_v = e->getValueOfAttribute ( NAME_BRUSH_STYLE );
 
   if ( attr_v != NULL )
     {
@@ -163,7 +180,7 @@ AbstractShape::initTextFromEntity ( const Entity *e )
   Attribute *a;
 
   /* load font style */
-  attr_v = e->getValueOfAttribute ( ATTR_FONT_STYLE );
+  attr_v = e->getValueOfAttribute ( NAME_FONT_STYLE );
 
   if ( attr_v != NULL )
     {
@@ -179,13 +196,13 @@ AbstractShape::initTextFromEntity ( const Entity *e )
     }
 
   /* load font size */
-  a = e->getAttribute ( ATTR_FONT_SIZE );
+  a = e->getAttribute ( NAME_FONT_SIZE );
 
   if ( a != NULL )
     this->font.setPointSize ( a->getValueAsInt() );
 
   /* load text */
-  attr_v = e->getValueOfAttribute ( ATTR_TEXT );
+  attr_v = e->getValueOfAttribute ( NAME_TEXT );
 
   if ( attr_v != NULL )
     {
@@ -199,10 +216,10 @@ AbstractShape::initTextFromEntity ( const Entity *e )
       this->text = new QGraphicsSimpleTextItem ( str, this );
 
       /* load font color */
-      attr_v = e->getValueOfAttribute ( ATTR_FONT_COLOR );
+      a = e->getAttribute ( NAME_FONT_COLOR );
 
-      if ( attr_v != NULL )
-        this->text->setBrush ( QBrush(QColor(attr_v)) );
+      if ( a != NULL )
+        this->text->setBrush ( QBrush(color_of_attribute(a)) );
 
       this->text->setFont ( this->font );
     }
@@ -87,7 +87,7 @@ AppKroket::openFile ( QString fname )
 void
 AppKroket::open ( )
 {
-  QStringList flist = QFileDialog::getOpenFileNames ( this, "Open Kroket File", "", "Krokets (*.kk)" );
+  QStringList flist = QFileDialog::getOpenFileNames ( this, "Open Kroket File", "", "Krokets (*.kk *.kkb)" );
   QStringList::Iterator fname;
 
   for ( fname=flist.begin(); fname!=flist.end(); ++fname )
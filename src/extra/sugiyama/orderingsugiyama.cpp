@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include "ordering-sugiyama.h"
+#include "crossing-counter.h"
 
 
 /*
@@ -258,71 +259,6 @@ OrderingSugiyama::applyToLayers ( QList<QList<Node *> > &layers )
     }
 }
 
-/*
- * Count the number of edge crossings between two nodes.
- * count_nb_crossings(a,b,s) != count_nb_crossings(b,a,s)
- * The function consider n1 is on the left side of n2.
- */
-static inline int
-count_nb_crossings ( const Node *n1,
-                     const Node *n2,
-                     QList<Node *> *upperLayer,
-                     QList<Node *> *lowerLayer )
-{
-  int ret = 0;
-  Node *p;
-
-  if ( upperLayer != NULL )
-    {
-      foreach ( p, n1->parents )
-        {
-          const int idx = p->grid_x - 1;
-
-          for ( int i=0; i<idx; ++i )
-            if ( n2->parents.contains((*upperLayer)[i]) )
-              ++ret;
-        }
-    }
-
-  if ( lowerLayer != NULL )
-    {
-      foreach ( p, n1->children )
-        {
-          const int idx = p->grid_x - 1;
-
-          for ( int i=0; i<idx; ++i )
-            if ( n2->children.contains((*lowerLayer)[i]) )
-              ++ret;
-        }
-    }
-
-  return ret;
-}
-
-
-/*
- * Count the number of edge crossings for all layers.
- */
-static int
-count_nb_crossings ( QList<QList<Node *> > &layers )
-{
-  int i, j, k;
-  int ret = 0;
-
-  for ( i=0; i<layers.size()-1; ++i )
-    {
-      QList<Node *> &l = layers[i];
-      QList<Node *> *l1 = &layers[i+1];
-
-      for ( j=0; j<l.size()-1; ++j )
-        for ( k=j+1; k<l.size(); ++k )
-          ret += count_nb_crossings ( l[j], l[k], NULL, l1 );
-    }
-
-  return ret;
-}
-
-
 /*
  * Assign an X coordinate to each node in order discovery
  */
@@ -410,5 +346,5 @@ OrderingSugiyama::applyToNodes ( QList<Node *> &nodes )
   /* apply sugiyama's algorithm to the layers */
   applyToLayers ( layers );
 
-  std::cout << "[su] " << count_nb_crossings(layers) << " edge crossings\n";
+  std::cout << "[su] " << CrossingCounter::countLayers(layers) << " edge crossings\n";
 }
@@ -0,0 +1,315 @@
+/*
+ * acyclic-greedy.cpp
+ *
+ * Implementation of the AcyclicGreedy class / greedy cycle removal algorithm.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "acyclic-greedy.h"
+
+
+/*
+ * The greedy cycle removal algorithm
+ *
+ * This is the heuristic of Eades, Lin and Smyth for the feedback arc
+ * set problem. The nodes are removed one by one from the graph:
+ * sinks go to the end of a sequence, sources to its start and, when
+ * there is neither, the node with the greatest outdegree-indegree
+ * goes to its start. The edges that go backward in the sequence form
+ * the feedback set: reversing them makes the graph acyclic.
+ *
+ * The nodes are kept in buckets indexed by outdegree-indegree, with
+ * two more buckets for the sinks and the sources, so each removal
+ * costs the degree of the removed node: O(N+E) time overall.
+ * Self loops are not cycles the layering cares about, they are ignored.
+ *
+ * The layering algorithms put the nodes at their distance from the
+ * entry points, which leaves some edges flat or upward even in an
+ * acyclic graph. pushBelowParents() then moves each node, in
+ * topological order, just below its deepest parent, so that the lazy
+ * layering finds no conflict to resolve and no edge is reversed again.
+ *
+ */
+
+
+#define SINKS 0
+#define SOURCES 1
+#define NONE -1
+
+
+/*
+ * Internal structure holding the buckets.
+ */
+typedef struct st_buckets
+{
+  qint32 *head;      /* first node of each bucket */
+  qint32 *next;      /* doubly linked nodes of a bucket */
+  qint32 *prev;
+  qint32 *bucket;    /* bucket of each node */
+  qint32 *outdeg;    /* degrees among the remaining nodes */
+  qint32 *indeg;
+  qint32 offset;     /* bucket of outdeg-indeg is 2+offset+outdeg-indeg */
+  qint32 max;        /* no node in the delta buckets above max */
+
+} Buckets ;
+
+
+/*
+ * Remove a node from its bucket.
+ */
+static inline void
+unlink_node ( Buckets &b,
+              const qint32 n )
+{
+  if ( b.prev[n] != NONE )
+    b.next[b.prev[n]] = b.next[n];
+  else
+    b.head[b.bucket[n]] = b.next[n];
+
+  if ( b.next[n] != NONE )
+    b.prev[b.next[n]] = b.prev[n];
+}
+
+
+/*
+ * Put a node in the bucket its degrees tell.
+ */
+static inline void
+link_node ( Buckets &b,
+            const qint32 n )
+{
+  qint32 k;
+
+  if ( b.outdeg[n] == 0 )
+    k = SINKS;
+  else if ( b.indeg[n] == 0 )
+    k = SOURCES;
+  else
+    {
+      k = 2 + b.offset + b.outdeg[n] - b.indeg[n];
+
+      if ( k > b.max )
+        b.max = k;
+    }
+
+  b.bucket[n] = k;
+  b.prev[n] = NONE;
+  b.next[n] = b.head[k];
+
+  if ( b.head[k] != NONE )
+    b.prev[b.head[k]] = n;
+
+  b.head[k] = n;
+}
+
+
+/*
+ * Rank the nodes of a graph snapshot so that few edges go from a node
+ * to a node of lower rank. The ranks are a permutation of 0..N-1.
+ */
+void
+AcyclicGreedy::applyToCsr ( const GraphCsr &g,
+                            qint32 *rank )
+{
+  Buckets b;
+  bool *removed;
+  qint32 i, j, n, k, first, last;
+
+  const qint32 N = g.size ( );
+
+  if ( N == 0 )
+    return;
+
+  /* degrees, without the self loops */
+  b.outdeg = new qint32 [ N ];
+  b.indeg = new qint32 [ N ];
+  b.offset = 0;
+
+  for ( i=0; i<N; ++i )
+    {
+      const qint32 *children = g.children ( i );
+      const qint32 *parents = g.parents ( i );
+
+      b.outdeg[i] = 0;
+      b.indeg[i] = 0;
+
+      for ( j=0; j<g.nbChildren(i); ++j )
+        if ( children[j] != i )
+          ++b.outdeg[i];
+
+      for ( j=0; j<g.nbParents(i); ++j )
+        if ( parents[j] != i )
+          ++b.indeg[i];
+
+      if ( b.indeg[i] > b.offset )
+        b.offset = b.indeg[i];
+    }
+
+  /* the delta buckets go from -offset to the greatest outdegree */
+  const qint32 nbBuckets = 2 + b.offset + g.edgesCount() + 1;
+
+  b.head = new qint32 [ nbBuckets ];
+  b.next = new qint32 [ N ];
+  b.prev = new qint32 [ N ];
+  b.bucket = new qint32 [ N ];
+  b.max = 1;
+  removed = new bool [ N ];
+
+  for ( k=0; k<nbBuckets; ++k )
+    b.head[k] = NONE;
+
+  /* in reverse, so that each bucket lists its nodes in index order */
+  for ( i=N-1; i>=0; --i )
+    {
+      removed[i] = false;
+      link_node ( b, i );
+    }
+
+  /* sinks go at the end of the sequence, the others at its start */
+  first = 0;
+  last = N - 1;
+
+  for ( k=0; k<N; ++k )
+    {
+      if ( b.head[SINKS] != NONE )
+        {
+          n = b.head[SINKS];
+          rank[n] = last--;
+        }
+      else
+        {
+          if ( b.head[SOURCES] != NONE )
+            n = b.head[SOURCES];
+          else
+            {
+              while ( b.head[b.max] == NONE )
+                --b.max;
+
+              n = b.head[b.max];
+            }
+
+          rank[n] = first++;
+        }
+
+      unlink_node ( b, n );
+      removed[n] = true;
+
+      /* the neighbours lose an edge */
+      const qint32 *children = g.children ( n );
+      const qint32 *parents = g.parents ( n );
+
+      for ( j=0; j<g.nbChildren(n); ++j )
+        {
+          i = children[j];
+
+          if ( ( i != n ) && ( !removed[i] ) )
+            {
+              unlink_node ( b, i );
+              --b.indeg[i];
+              link_node ( b, i );
+            }
+        }
+
+      for ( j=0; j<g.nbParents(n); ++j )
+        {
+          i = parents[j];
+
+          if ( ( i != n ) && ( !removed[i] ) )
+            {
+              unlink_node ( b, i );
+              --b.outdeg[i];
+              link_node ( b, i );
+            }
+        }
+    }
+
+  /* free memory */
+  delete [] b.outdeg;
+  delete [] b.indeg;
+  delete [] b.head;
+  delete [] b.next;
+  delete [] b.prev;
+  delete [] b.bucket;
+  delete [] removed;
+}
+
+
+/*
+ * Move each node of an acyclic graph snapshot below its parents,
+ * visiting the nodes in topological order. Nodes left on a cycle
+ * keep their layer.
+ */
+void
+AcyclicGreedy::pushBelowParents ( GraphCsr &g )
+{
+  qint32 *indeg;
+  qint32 *queue;
+  qint32 i, j, n, child, head, tail;
+
+  const qint32 N = g.size ( );
+
+  if ( N == 0 )
+    return;
+
+  indeg = new qint32 [ N ];
+  queue = new qint32 [ N ];
+
+  for ( i=0; i<N; ++i )
+    indeg[i] = 0;
+
+  for ( i=0; i<N; ++i )
+    {
+      const qint32 *children = g.children ( i );
+
+      for ( j=0; j<g.nbChildren(i); ++j )
+        if ( children[j] != i )
+          ++indeg[children[j]];
+    }
+
+  tail = 0;
+
+  for ( i=0; i<N; ++i )
+    if ( indeg[i] == 0 )
+      queue[tail++] = i;
+
+  for ( head=0; head<tail; ++head )
+    {
+      n = queue[head];
+
+      const qint32 *children = g.children ( n );
+
+      for ( j=0; j<g.nbChildren(n); ++j )
+        {
+          child = children[j];
+
+          if ( child == n )
+            continue;
+
+          if ( g.y[child] <= g.y[n] )
+            g.y[child] = g.y[n] + 1;
+
+          if ( --indeg[child] == 0 )
+            queue[tail++] = child;
+        }
+    }
+
+  /* free memory */
+  delete [] indeg;
+  delete [] queue;
+}
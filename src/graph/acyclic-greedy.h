@@ -0,0 +1,43 @@
+/*
+ * acyclic-greedy.h
+ *
+ * Declaration of the AcyclicGreedy class.
+ * It finds the edges to reverse so that a graph has no cycle.
+ * The algorithm is described in acyclic-greedy.cpp
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __ACYCLIC_GREEDY_H__
+#define __ACYCLIC_GREEDY_H__
+
+#include <QtCore>
+#include "graph-csr.h"
+
+
+class AcyclicGreedy
+{
+ public:
+  static void applyToCsr ( const GraphCsr &, qint32 * ); /* rank of each node, reverse the edges going to a lower rank */
+  static void pushBelowParents ( GraphCsr & );            /* once acyclic: no edge is left flat or upward by the layering */
+
+} ;
+
+
+#endif
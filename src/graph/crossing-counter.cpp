@@ -0,0 +1,387 @@
+/*
+ * crossing-counter.cpp
+ *
+ * Implementation of the CrossingCounter class.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <iostream>
+#include <string.h>
+#include <QtConcurrent>
+#include "crossing-counter.h"
+
+
+/*
+ * The accumulator tree crossing counter
+ *
+ * The edges between two layers are sorted by the position of their
+ * upper end, then by the position of their lower end. Two edges
+ * cross when their lower ends appear in the reverse order, so the
+ * number of crossings is the number of inversions of the sequence
+ * of lower positions. The inversions are counted by inserting the
+ * positions one by one in a complete binary tree whose leaves are
+ * the lower positions; each node accumulates the number of
+ * insertions below it (Barth, Juenger and Mutzel).
+ *
+ * This takes O(E log V) time for a bilayer, instead of comparing
+ * every pair of nodes of a layer.
+ *
+ * Each bilayer has its own sequence and tree buffers, so that the
+ * bilayers can be counted in parallel.
+ *
+ * For the swap of two adjacent nodes, the positions of their
+ * neighbours are sorted once per layer and the crossings of a
+ * pair are counted by merging the two sorted lists.
+ */
+
+
+/*
+ * Sort a small array of positions (insertion sort, the arrays
+ * are the neighbours of a single node).
+ */
+static inline void
+sort_positions ( quint32 *a,
+                 const qint32 n )
+{
+  qint32 i, j;
+  quint32 v;
+
+  for ( i=1; i<n; ++i )
+    {
+      v = a[i];
+
+      for ( j=i; ( j>0 ) && ( a[j-1] > v ); --j )
+        a[j] = a[j-1];
+
+      a[j] = v;
+    }
+}
+
+
+/*
+ * Number of pairs (i,j) such that b[j] < a[i], a and b being sorted.
+ */
+static inline unsigned int
+count_inversions ( const quint32 *a,
+                   const qint32 na,
+                   const quint32 *b,
+                   const qint32 nb )
+{
+  unsigned int ret = 0;
+  qint32 i, j = 0;
+
+  for ( i=0; i<na; ++i )
+    {
+      while ( ( j < nb ) && ( b[j] < a[i] ) )
+        ++j;
+
+      ret += j;
+    }
+
+  return ret;
+}
+
+
+/*
+ * Size of the accumulator tree for a layer of a given width.
+ */
+static inline qint32
+tree_size ( const qint32 width )
+{
+  qint32 first = 1;
+
+  while ( first < width )
+    first <<= 1;
+
+  return 2*first - 1;
+}
+
+
+/*
+ * Constructor
+ */
+CrossingCounter::CrossingCounter ( const GraphCsr &g )
+  : g(g)
+{
+  qint32 l, i;
+
+  const qint32 E = g.edgesCount ( );
+  const qint32 L = g.nbLayers ( );
+
+  this->seqOffsets = new qint32 [ L+1 ];
+  this->treeOffsets = new qint32 [ L+1 ];
+  this->counts = new quint64 [ L+1 ];
+
+  this->seqOffsets[0] = 0;
+  this->treeOffsets[0] = 0;
+
+  for ( l=0; l<L; ++l )
+    {
+      const qint32 *layer = g.layer ( l );
+
+      this->seqOffsets[l+1] = this->seqOffsets[l];
+
+      for ( i=0; i<g.layerSize(l); ++i )
+        this->seqOffsets[l+1] += g.nbChildren ( layer[i] );
+
+      this->treeOffsets[l+1] = this->treeOffsets[l] + ( ( l+1 < L ) ? tree_size ( g.layerSize(l+1) ) : 0 );
+    }
+
+  this->seq = new quint32 [ this->seqOffsets[L]+1 ];
+  this->tree = new quint32 [ this->treeOffsets[L]+1 ];
+  this->parentX = new quint32 [ E+1 ];
+  this->childX = new quint32 [ E+1 ];
+}
+
+
+/*
+ * Functor used to count the bilayers in parallel.
+ */
+class BilayerKernel
+{
+ public:
+  typedef void result_type;
+
+  BilayerKernel ( CrossingCounter *cc, quint64 *counts ) : cc(cc), counts(counts) { }
+
+  void operator() ( const qint32 &l ) const
+  {
+    counts[l] = cc->countBilayer ( l );
+  }
+
+ private:
+  CrossingCounter *cc;
+  quint64 *counts;
+} ;
+
+
+/*
+ * Count the inversions of a sequence of n positions in [0,width)
+ * using the accumulator tree.
+ */
+quint64
+CrossingCounter::accumulate ( const quint32 *seq,
+                              const qint32 n,
+                              const qint32 width,
+                              quint32 *tree )
+{
+  quint64 ret = 0;
+  qint32 k, index;
+
+  const qint32 size = tree_size ( width );
+  const qint32 first = size >> 1; /* index of the first leaf */
+
+  memset ( tree, 0, sizeof(quint32)*size );
+
+  for ( k=0; k<n; ++k )
+    {
+      index = seq[k] + first;
+      ++tree[index];
+
+      while ( index > 0 )
+        {
+          if ( index & 1 ) /* left child: the right sibling holds greater positions */
+            ret += tree[index+1];
+
+          index = (index - 1) >> 1;
+          ++tree[index];
+        }
+    }
+
+  return ret;
+}
+
+
+/*
+ * Count the crossings between the layer l and the layer l+1.
+ */
+quint64
+CrossingCounter::countBilayer ( const qint32 l )
+{
+  qint32 i, j, n, nb;
+
+  if ( l+1 >= g.nbLayers() )
+    return 0;
+
+  const qint32 *upper = g.layer ( l );
+  const qint32 size = g.layerSize ( l );
+  const quint32 lower_y = l + 1;
+  quint32 *s = this->seq + this->seqOffsets[l];
+
+  /* lower positions of the edges, ordered by upper then lower position */
+  n = 0;
+
+  for ( i=0; i<size; ++i )
+    {
+      const qint32 *children = g.children ( upper[i] );
+      const qint32 nbChildren = g.nbChildren ( upper[i] );
+
+      nb = 0;
+
+      for ( j=0; j<nbChildren; ++j )
+        if ( g.y[children[j]] == lower_y )
+          s[n+nb++] = g.x[children[j]] - 1;
+
+      sort_positions ( s+n, nb );
+      n += nb;
+    }
+
+  return accumulate ( s, n, g.layerSize(l+1), this->tree + this->treeOffsets[l] );
+}
+
+
+/*
+ * Count the crossings of all the layers.
+ */
+quint64
+CrossingCounter::countAll ( const bool parallel )
+{
+  qint32 l;
+  quint64 ret = 0;
+
+  if ( !parallel )
+    {
+      for ( l=0; l<g.nbLayers()-1; ++l )
+        ret += countBilayer ( l );
+
+      return ret;
+    }
+
+  QList<qint32> bilayers;
+
+  for ( l=0; l<g.nbLayers()-1; ++l )
+    bilayers.append ( l );
+
+  QtConcurrent::blockingMap ( bilayers, BilayerKernel(this,this->counts) );
+
+  foreach ( l, bilayers )
+    ret += this->counts[l];
+
+  return ret;
+}
+
+
+/*
+ * Sort the positions of the neighbours of the nodes of a layer.
+ * Moving the nodes of this layer does not change them, so they
+ * can be used by countPair() during a whole transpose sweep.
+ */
+void
+CrossingCounter::sortNeighbourPositions ( const qint32 l )
+{
+  qint32 i, j, n;
+
+  const qint32 *layer = g.layer ( l );
+
+  for ( i=0; i<g.layerSize(l); ++i )
+    {
+      n = layer[i];
+
+      const qint32 *parents = g.parents ( n );
+      const qint32 nbParents = g.nbParents ( n );
+      quint32 *px = this->parentX + g.parentOffset ( n );
+
+      for ( j=0; j<nbParents; ++j )
+        px[j] = g.x[parents[j]];
+
+      sort_positions ( px, nbParents );
+
+      const qint32 *children = g.children ( n );
+      const qint32 nbChildren = g.nbChildren ( n );
+      quint32 *cx = this->childX + g.childOffset ( n );
+
+      for ( j=0; j<nbChildren; ++j )
+        cx[j] = g.x[children[j]];
+
+      sort_positions ( cx, nbChildren );
+    }
+}
+
+
+/*
+ * Count the crossings between the edges of n1 and the edges of n2,
+ * n1 being on the left side of n2. countPair(a,b) != countPair(b,a)
+ * sortNeighbourPositions() must have been called for their layer.
+ */
+unsigned int
+CrossingCounter::countPair ( const qint32 n1,
+                             const qint32 n2 ) const
+{
+  return ( count_inversions ( this->parentX + g.parentOffset(n1), g.nbParents(n1),
+                              this->parentX + g.parentOffset(n2), g.nbParents(n2) ) +
+           count_inversions ( this->childX + g.childOffset(n1), g.nbChildren(n1),
+                              this->childX + g.childOffset(n2), g.nbChildren(n2) ) );
+}
+
+
+/*
+ * Count the crossings of layers of nodes, each layer being ordered
+ * by grid_x. Node tags are overwritten.
+ */
+quint64
+CrossingCounter::countLayers ( const QList<QList<Node *> > &layers )
+{
+  QVector<quint32> seq;
+  QVector<quint32> tree;
+  quint64 ret = 0;
+  qint32 i, j, n;
+
+  for ( i=0; i<layers.size()-1; ++i )
+    {
+      const QList<Node *> &upper = layers[i];
+      const QList<Node *> &lower = layers[i+1];
+
+      /* tags hold the positions in the lower layer */
+      for ( j=0; j<lower.size(); ++j )
+        lower[j]->tag = j;
+
+      seq.clear ( );
+
+      for ( j=0; j<upper.size(); ++j )
+        {
+          n = seq.size ( );
+
+          foreach ( Node *child, upper[j]->children )
+            if ( child->grid_y == (quint32)(i+1) )
+              seq.append ( child->tag );
+
+          sort_positions ( seq.data()+n, seq.size()-n );
+        }
+
+      tree.resize ( tree_size(lower.size()) );
+      ret += accumulate ( seq.data(), seq.size(), lower.size(), tree.data() );
+    }
+
+  return ret;
+}
+
+
+/*
+ * Destructor
+ */
+CrossingCounter::~CrossingCounter ( )
+{
+  delete [] this->seq;
+  delete [] this->tree;
+  delete [] this->seqOffsets;
+  delete [] this->treeOffsets;
+  delete [] this->counts;
+  delete [] this->parentX;
+  delete [] this->childX;
+}
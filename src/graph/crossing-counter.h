@@ -0,0 +1,65 @@
+/*
+ * crossing-counter.h
+ *
+ * Declaration of the CrossingCounter class.
+ * It counts the edge crossings of a layered graph.
+ * The algorithm is described in crossing-counter.cpp
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __CROSSING_COUNTER_H__
+#define __CROSSING_COUNTER_H__
+
+#include <QtCore>
+#include "node.h"
+#include "graph-csr.h"
+
+
+class CrossingCounter
+{
+ public:
+  CrossingCounter ( const GraphCsr & ); /* the layers of the snapshot must be built */
+  ~CrossingCounter ( );
+
+  quint64 countAll ( const bool parallel=false );  /* crossings of the whole graph */
+  quint64 countBilayer ( const qint32 );           /* crossings between a layer and the next one (thread safe) */
+
+  void sortNeighbourPositions ( const qint32 );    /* prepare countPair() for the nodes of a layer */
+  unsigned int countPair ( const qint32, const qint32 ) const; /* crossings of two nodes' edges, the first one on the left */
+
+  static quint64 countLayers ( const QList<QList<Node *> > & ); /* crossings of layers of nodes ordered by grid_x */
+
+ private:
+  static quint64 accumulate ( const quint32 *, const qint32, const qint32, quint32 * );
+
+  const GraphCsr &g;
+
+  quint32 *seq;              /* lower positions of the edges of each bilayer */
+  quint32 *tree;             /* accumulator tree of each bilayer */
+  qint32 *seqOffsets;        /* start of the buffers of each bilayer */
+  qint32 *treeOffsets;
+  quint64 *counts;           /* crossings of each bilayer */
+  quint32 *parentX;          /* sorted positions of the parents, indexed like the parents in the snapshot */
+  quint32 *childX;           /* sorted positions of the children */
+
+} ;
+
+
+#endif
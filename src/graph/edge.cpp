@@ -24,7 +24,7 @@
 #include "graph.h"
 
 
-static unsigned int counter = 0;
+static QAtomicInt counter ( 0 ); /* edges are also created by the layout thread */
 
 
 /*
@@ -36,7 +36,7 @@ Edge::Edge ( Node *src,
   this->src = src;
   this->dest = dest;
 
-  this->id.setNum ( counter++ );
+  this->id.setNum ( (unsigned int) counter.fetchAndAddRelaxed(1) );
   this->id.append ( "__edge" );
 
   this->reversed = false;
@@ -54,7 +54,7 @@ Edge::initFromEntity ( const Entity *e )
   const char *attr_v;
 
   /* load ID */
-  attr_v = e->getValueOfAttribute ( ATTR_EDGE_ID );
+  attr_v = e->getValueOfAttribute ( NAME_EDGE_ID );
 
   if ( attr_v != NULL )
     this->id = attr_v;
@@ -98,6 +98,7 @@ Edge::virtualize ( Graph *g )
     {
       virt = new Node ( g, true );
       virt->grid_y = last->src->grid_y + 1;
+      virt->subgraph_id = last->src->subgraph_id;
       g->addNode ( virt );
 
       e = new Edge ( virt, last->dest );
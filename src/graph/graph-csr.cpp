@@ -0,0 +1,272 @@
+/*
+ * graph-csr.cpp
+ *
+ * Implementation of the GraphCsr class.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <iostream>
+#include "graph-csr.h"
+
+
+/*
+ * The compressed sparse row snapshot
+ *
+ * The children (and parents) of all the nodes are stored in a
+ * single array of node indexes, the ones of node i starting at
+ * offset[i]. The order of the original lists is kept, since the
+ * median heuristics depend on it. Neighbours which are not part
+ * of the snapshot are ignored.
+ *
+ * The layers are stored the same way, so that an algorithm can
+ * work on contiguous arrays of indexes and coordinates instead
+ * of following pointers.
+ */
+
+
+/*
+ * Index of a node in a snapshot, -1 if it is not part of it.
+ */
+static inline qint32
+index_of ( Node * const *nodes,
+           const qint32 N,
+           const Node *n )
+{
+  const qint32 i = n->tag;
+
+  if ( ( i >= 0 ) && ( i < N ) && ( nodes[i] == n ) )
+    return i;
+
+  return -1;
+}
+
+
+/*
+ * Constructor
+ */
+GraphCsr::GraphCsr ( const QList<Node *> &list )
+{
+  qint32 i, k, idx;
+  Node *n;
+
+  this->nbNodes = list.size ( );
+  this->nbEdges = 0;
+  this->layersCount = 0;
+  this->maxWidth = 0;
+  this->layerOffsets = NULL;
+  this->layerNodes = NULL;
+
+  const qint32 N = this->nbNodes;
+
+  this->nodes = new Node * [ N ];
+  this->x = new quint32 [ N ];
+  this->y = new quint32 [ N ];
+  this->isVirtual = new bool [ N ];
+  this->childOffsets = new qint32 [ N+1 ];
+  this->parentOffsets = new qint32 [ N+1 ];
+
+  for ( i=0; i<N; ++i )
+    {
+      n = list[i];
+      n->tag = i;
+      this->nodes[i] = n;
+      this->isVirtual[i] = n->isVirtual;
+    }
+
+  this->loadCoordinates ( );
+
+  /* count the neighbours */
+  this->childOffsets[0] = 0;
+  this->parentOffsets[0] = 0;
+
+  for ( i=0; i<N; ++i )
+    {
+      n = this->nodes[i];
+      this->childOffsets[i+1] = this->childOffsets[i];
+      this->parentOffsets[i+1] = this->parentOffsets[i];
+
+      foreach ( Node *child, n->children )
+        if ( index_of(this->nodes,N,child) != -1 )
+          ++this->childOffsets[i+1];
+
+      foreach ( Node *parent, n->parents )
+        if ( index_of(this->nodes,N,parent) != -1 )
+          ++this->parentOffsets[i+1];
+    }
+
+  this->nbEdges = this->childOffsets[N];
+  this->childTargets = new qint32 [ this->childOffsets[N] + 1 ];
+  this->parentTargets = new qint32 [ this->parentOffsets[N] + 1 ];
+
+  /* fill the neighbours */
+  for ( i=0; i<N; ++i )
+    {
+      n = this->nodes[i];
+
+      k = this->childOffsets[i];
+
+      foreach ( Node *child, n->children )
+        if ( ( idx = index_of(this->nodes,N,child) ) != -1 )
+          this->childTargets[k++] = idx;
+
+      k = this->parentOffsets[i];
+
+      foreach ( Node *parent, n->parents )
+        if ( ( idx = index_of(this->nodes,N,parent) ) != -1 )
+          this->parentTargets[k++] = idx;
+    }
+}
+
+
+/*
+ * Read the grid coordinates of the nodes.
+ */
+void
+GraphCsr::loadCoordinates ( )
+{
+  qint32 i;
+
+  for ( i=0; i<this->nbNodes; ++i )
+    {
+      this->x[i] = this->nodes[i]->grid_x;
+      this->y[i] = this->nodes[i]->grid_y;
+    }
+}
+
+
+/*
+ * Write the grid coordinates back to the nodes.
+ */
+void
+GraphCsr::storeCoordinates ( ) const
+{
+  qint32 i;
+
+  for ( i=0; i<this->nbNodes; ++i )
+    {
+      this->nodes[i]->grid_x = this->x[i];
+      this->nodes[i]->grid_y = this->y[i];
+    }
+}
+
+
+/*
+ * Functor used to sort the nodes of a layer by X.
+ */
+class CompareX
+{
+ public:
+  CompareX ( const quint32 *x ) : x(x) { }
+
+  inline bool operator() ( const qint32 a, const qint32 b ) const
+  {
+    return ( x[a] < x[b] );
+  }
+
+ private:
+  const quint32 *x;
+} ;
+
+
+/*
+ * Group the nodes by Y coordinate (counting sort), then order
+ * each layer by X coordinate. Nodes with the same X keep the
+ * order of the snapshot.
+ */
+void
+GraphCsr::buildLayers ( )
+{
+  qint32 i, l;
+  qint32 *fill;
+
+  const qint32 N = this->nbNodes;
+
+  delete [] this->layerOffsets;
+  delete [] this->layerNodes;
+
+  this->layersCount = 0;
+  this->maxWidth = 0;
+
+  for ( i=0; i<N; ++i )
+    if ( (qint32) this->y[i] >= this->layersCount )
+      this->layersCount = this->y[i] + 1;
+
+  this->layerOffsets = new qint32 [ this->layersCount+1 ];
+  this->layerNodes = new qint32 [ N+1 ];
+  fill = new qint32 [ this->layersCount+1 ];
+
+  for ( l=0; l<=this->layersCount; ++l )
+    this->layerOffsets[l] = 0;
+
+  for ( i=0; i<N; ++i )
+    ++this->layerOffsets[this->y[i]+1];
+
+  for ( l=0; l<this->layersCount; ++l )
+    {
+      if ( this->layerOffsets[l+1] > this->maxWidth )
+        this->maxWidth = this->layerOffsets[l+1];
+
+      this->layerOffsets[l+1] += this->layerOffsets[l];
+      fill[l] = this->layerOffsets[l];
+    }
+
+  for ( i=0; i<N; ++i )
+    this->layerNodes[fill[this->y[i]]++] = i;
+
+  for ( l=0; l<this->layersCount; ++l )
+    qStableSort ( this->layer(l), this->layer(l)+this->layerSize(l), CompareX(this->x) );
+
+  delete [] fill;
+}
+
+
+/*
+ * Index of the first node that was added to the graph.
+ * It is used as the entry point of graphs without any.
+ */
+qint32
+GraphCsr::defaultEntry ( ) const
+{
+  qint32 i;
+  qint32 entry = 0;
+
+  for ( i=1; i<this->nbNodes; ++i )
+    if ( this->nodes[entry]->n_id > this->nodes[i]->n_id )
+      entry = i;
+
+  return entry;
+}
+
+
+/*
+ * Destructor
+ */
+GraphCsr::~GraphCsr ( )
+{
+  delete [] this->nodes;
+  delete [] this->x;
+  delete [] this->y;
+  delete [] this->isVirtual;
+  delete [] this->childOffsets;
+  delete [] this->childTargets;
+  delete [] this->parentOffsets;
+  delete [] this->parentTargets;
+  delete [] this->layerOffsets;
+  delete [] this->layerNodes;
+}
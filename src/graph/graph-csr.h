@@ -0,0 +1,83 @@
+/*
+ * graph-csr.h
+ *
+ * Declaration of the GraphCsr class.
+ * It is a compact, index based snapshot of the adjacency of a list
+ * of nodes, used by the layering, ordering and placing algorithms.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __GRAPH_CSR_H__
+#define __GRAPH_CSR_H__
+
+#include <QtCore>
+#include "node.h"
+
+
+class GraphCsr
+{
+ public:
+  GraphCsr ( const QList<Node *> & ); /* node tags are set to the node indexes */
+  ~GraphCsr ( );
+
+  void loadCoordinates ( );           /* read the grid coordinates of the nodes */
+  void storeCoordinates ( ) const;    /* write the grid coordinates back to the nodes */
+  void buildLayers ( );               /* group the nodes by Y, each layer ordered by X */
+  qint32 defaultEntry ( ) const;      /* index of the first node that was added to the graph */
+
+  inline qint32 size ( ) const { return nbNodes; }
+  inline qint32 edgesCount ( ) const { return nbEdges; }
+
+  inline qint32 nbChildren ( const qint32 i ) const { return childOffsets[i+1] - childOffsets[i]; }
+  inline const qint32 *children ( const qint32 i ) const { return childTargets + childOffsets[i]; }
+  inline qint32 nbParents ( const qint32 i ) const { return parentOffsets[i+1] - parentOffsets[i]; }
+  inline const qint32 *parents ( const qint32 i ) const { return parentTargets + parentOffsets[i]; }
+  inline qint32 childOffset ( const qint32 i ) const { return childOffsets[i]; }   /* position of the children of i in a per-edge array */
+  inline qint32 parentOffset ( const qint32 i ) const { return parentOffsets[i]; }
+
+  inline qint32 nbLayers ( ) const { return layersCount; }
+  inline qint32 layerSize ( const qint32 l ) const { return layerOffsets[l+1] - layerOffsets[l]; }
+  inline qint32 *layer ( const qint32 l ) const { return layerNodes + layerOffsets[l]; }
+  inline qint32 maxLayerSize ( ) const { return maxWidth; }
+
+ public:
+  Node **nodes;              /* index -> node */
+  quint32 *x;                /* grid X coordinate of each node */
+  quint32 *y;                /* grid Y coordinate of each node */
+  bool *isVirtual;
+
+ private:
+  qint32 nbNodes;
+  qint32 nbEdges;
+
+  qint32 *childOffsets;      /* children of i are childTargets[childOffsets[i] .. childOffsets[i+1]-1] */
+  qint32 *childTargets;
+  qint32 *parentOffsets;     /* same for the parents */
+  qint32 *parentTargets;
+
+  qint32 layersCount;
+  qint32 maxWidth;
+  qint32 *layerOffsets;      /* nodes of layer l are layerNodes[layerOffsets[l] .. layerOffsets[l+1]-1] */
+  qint32 *layerNodes;
+
+} ;
+
+
+#endif
@@ -19,26 +19,533 @@
  * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
 #include "graph.h"
+#include "synthetic-graph.h"
+
+
+#define NB_TOGGLES 8
+
+
+/*
+ * Milliseconds elapsed since start.
+ */
+static double
+elapsed_ms ( const struct timeval &start )
+{
+  struct timeval end;
+
+  gettimeofday ( &end, NULL );
+
+  return ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+}
+
+
+/*
+ * Collapse and expand some parts of a graph, as a user would do,
+ * and measure the relayout time with and without incremental layout.
+ */
+static void
+bench_relayout ( Graph *g,
+                 const char *name )
+{
+  struct timeval start;
+  QList<Node *> nodes_list;
+  QList<Node *> hidden;
+  double t_layout[2];
+  int i, mode;
+
+  g->feedListWithActiveNodes ( nodes_list );
+  std::cout << name << " (" << nodes_list.size() << " nodes, " << g->edges.size() << " edges)\n";
+
+  for ( mode=0; mode<2; ++mode )
+    {
+      g->setIncrementalLayout ( mode == 1 );
+      g->assignGridCoordinates ( );
+      t_layout[mode] = 0.0;
+      srand ( 11 );
+
+      for ( i=0; i<NB_TOGGLES; ++i )
+        {
+          Node *n = nodes_list[rand()%nodes_list.size()];
+
+          /* collapse: the children of a node vanish */
+          hidden = n->children;
+
+          foreach ( Node *child, hidden )
+            child->setActive ( false );
+
+          gettimeofday ( &start, NULL );
+          g->assignGridCoordinates ( );
+          t_layout[mode] += elapsed_ms ( start );
+
+          /* expand: they come back */
+          foreach ( Node *child, hidden )
+            child->setActive ( true );
+
+          gettimeofday ( &start, NULL );
+          g->assignGridCoordinates ( );
+          t_layout[mode] += elapsed_ms ( start );
+        }
+    }
+
+  std::cout << "full relayout        -> " << t_layout[0]/(2*NB_TOGGLES) << "ms\n";
+  std::cout << "incremental relayout -> " << t_layout[1]/(2*NB_TOGGLES) << "ms\n\n";
+}
+
+
+/*
+ * Layout a graph twice with the same seed and compare the coordinates.
+ * Returns true if they are identical.
+ */
+static bool
+check_reproducible ( Graph *g,
+                     const char *name )
+{
+  QList<Node *> nodes_list;
+  QList<quint32> x, y;
+  int i, nb_diff = 0;
+
+  g->setLayoutSeed ( 42 );
+  g->setIncrementalLayout ( false );
+
+  g->assignGridCoordinates ( );
+  g->feedListWithActiveNodes ( nodes_list );
+
+  foreach ( Node *n, nodes_list )
+    {
+      x.append ( n->grid_x );
+      y.append ( n->grid_y );
+    }
+
+  g->assignGridCoordinates ( );
+
+  for ( i=0; i<nodes_list.size(); ++i )
+    if ( ( nodes_list[i]->grid_x != x[i] ) || ( nodes_list[i]->grid_y != y[i] ) )
+      ++nb_diff;
+
+  std::cout << name << " (" << nodes_list.size() << " nodes) -> "
+            << ( (nb_diff == 0) ? "reproducible\n" : "LAYOUTS DIFFER\n" );
+
+  return ( nb_diff == 0 );
+}
+
+
+/*
+ * Nodes reachable from a node, following the children.
+ */
+static QSet<Node *>
+reachable_from ( Node *n )
+{
+  QSet<Node *> seen;
+  QList<Node *> queue;
+
+  seen.insert ( n );
+  queue.append ( n );
+
+  while ( !queue.isEmpty() )
+    foreach ( Node *child, queue.takeFirst()->children )
+      if ( !seen.contains(child) )
+        {
+          seen.insert ( child );
+          queue.append ( child );
+        }
+
+  return seen;
+}
+
+
+/*
+ * Assign the SCC IDs of a graph and check them: no edge goes to a lower
+ * ID, and (on small graphs) two nodes share an ID if and only if they
+ * reach each other. Returns true if they are right.
+ */
+static bool
+check_scc ( Graph *g,
+            const char *name )
+{
+  QList<Node *> nodes_list;
+  QSet<quint32> ids;
+  int i, j, nb_errors = 0;
+
+  g->assignSccIDs ( );
+  g->feedListWithActiveNodes ( nodes_list );
+
+  foreach ( Node *n, nodes_list )
+    {
+      ids.insert ( n->scc_id );
+
+      foreach ( Node *child, n->children )
+        if ( child->scc_id < n->scc_id )
+          ++nb_errors;
+    }
+
+  if ( nodes_list.size() <= 2048 )
+    {
+      QList<QSet<Node *> > reach;
+
+      foreach ( Node *n, nodes_list )
+        reach.append ( reachable_from(n) );
+
+      for ( i=0; i<nodes_list.size(); ++i )
+        for ( j=0; j<nodes_list.size(); ++j )
+          {
+            const bool strongly = reach[i].contains(nodes_list[j]) && reach[j].contains(nodes_list[i]);
+
+            if ( strongly != ( nodes_list[i]->scc_id == nodes_list[j]->scc_id ) )
+              ++nb_errors;
+          }
+    }
+
+  std::cout << name << " (" << nodes_list.size() << " nodes) -> " << ids.size() << " components"
+            << ( (nb_errors == 0) ? "\n" : ", WRONG IDS\n" );
+
+  return ( nb_errors == 0 );
+}
+
+
+/*
+ * Assign the subgraph IDs of a graph and compare them with the connected
+ * components found by a search along the children and the parents.
+ * Returns true if they give the same partition.
+ */
+static bool
+check_subgraphs ( Graph *g,
+                  const char *name )
+{
+  QList<Node *> nodes_list;
+  QHash<Node *,int> component;
+  QHash<quint32,int> component_of_id;
+  QHash<int,quint32> id_of_component;
+  int nb_components = 0, nb_errors = 0;
+
+  g->assignSubgraphIDs ( );
+  g->feedListWithActiveNodes ( nodes_list );
+
+  foreach ( Node *n, nodes_list )
+    {
+      if ( component.contains(n) )
+        continue;
+
+      QList<Node *> queue;
+      queue.append ( n );
+      component.insert ( n, nb_components );
+
+      while ( !queue.isEmpty() )
+        {
+          Node *m = queue.takeFirst ( );
+          QList<Node *> neighbours = m->children + m->parents;
+
+          foreach ( Node *k, neighbours )
+            if ( k->isActive() && !component.contains(k) )
+              {
+                component.insert ( k, nb_components );
+                queue.append ( k );
+              }
+        }
+
+      ++nb_components;
+    }
+
+  foreach ( Node *n, nodes_list )
+    {
+      const int c = component.value ( n );
+
+      if ( n->subgraph_id == 0 )
+        ++nb_errors;
+
+      if ( !component_of_id.contains(n->subgraph_id) )
+        component_of_id.insert ( n->subgraph_id, c );
+
+      if ( !id_of_component.contains(c) )
+        id_of_component.insert ( c, n->subgraph_id );
+
+      if ( ( component_of_id.value(n->subgraph_id) != c ) || ( id_of_component.value(c) != n->subgraph_id ) )
+        ++nb_errors;
+    }
+
+  std::cout << name << " (" << nodes_list.size() << " nodes) -> " << nb_components << " subgraphs"
+            << ( (nb_errors == 0) ? "\n" : ", WRONG IDS\n" );
+
+  return ( nb_errors == 0 );
+}
+
+
+/*
+ * Layout a graph as a whole, then subgraph by subgraph, and check that
+ * the packed subgraphs neither overlap each other nor share a cell.
+ * Returns true if they do not.
+ */
+static bool
+check_packing ( Graph *g,
+                const char *name )
+{
+  struct timeval start;
+  QList<Node *> nodes_list;
+  QHash<quint32, QPair<quint32,quint32> > xrange;
+  QSet<quint64> cells;
+  double t_whole, t_packed;
+  int nb_errors = 0;
+
+  g->setLayoutSeed ( 42 );
+  g->setIncrementalLayout ( false );
+
+  g->setComponentLayout ( false );
+  gettimeofday ( &start, NULL );
+  g->assignGridCoordinates ( );
+  t_whole = elapsed_ms ( start );
+
+  g->setComponentLayout ( true );
+  gettimeofday ( &start, NULL );
+  g->assignGridCoordinates ( );
+  t_packed = elapsed_ms ( start );
+
+  g->feedListWithActiveNodes ( nodes_list );
+
+  foreach ( Node *n, nodes_list )
+    {
+      const quint64 cell = ( ((quint64) n->grid_y) << 32 ) | n->grid_x;
+
+      if ( cells.contains(cell) )
+        ++nb_errors;
+
+      cells.insert ( cell );
+
+      if ( !xrange.contains(n->subgraph_id) )
+        xrange.insert ( n->subgraph_id, qMakePair(n->grid_x,n->grid_x) );
+      else
+        {
+          QPair<quint32,quint32> &r = xrange[n->subgraph_id];
+          r.first = qMin ( r.first, n->grid_x );
+          r.second = qMax ( r.second, n->grid_x );
+        }
+    }
+
+  foreach ( Node *n, nodes_list )
+    foreach ( quint32 id, xrange.keys() )
+      if ( ( id != n->subgraph_id ) && ( n->grid_x >= xrange[id].first ) && ( n->grid_x <= xrange[id].second ) )
+        {
+          ++nb_errors;
+          break;
+        }
+
+  std::cout << name << " (" << nodes_list.size() << " nodes, " << xrange.size() << " subgraphs)\n";
+  std::cout << "whole layout  -> " << t_whole << "ms\n";
+  std::cout << "packed layout -> " << t_packed << "ms" << ( (nb_errors == 0) ? "\n\n" : ", OVERLAPPING\n\n" );
+
+  return ( nb_errors == 0 );
+}
+
+/*
+ * Compare two entities' rank in the file they were read from.
+ */
+static bool
+compare_sequences ( const Entity *e1,
+                    const Entity *e2 )
+{
+  return e1->getSequence() < e2->getSequence();
+}
+
+
+/*
+ * Read a file, then its compiled form, as a graph, and check that the
+ * nodes and edges are added in file order: the nodes first, then the
+ * edges, the edges naming a node declared after them coming last.
+ * Returns true if they are.
+ */
+static bool
+check_loading_order ( const char *file_name )
+{
+  EntityList el;
+  EntityList::iterator iter;
+  QList<Entity *> entities;
+  QSet<QString> known;
+  QStringList expected_nodes, expected_edges;
+  QList<QPair<QString,QString> > pending;
+  QPair<QString,QString> p;
+  const char *compiled = "loading-order.kkb";
+  const char *files[2];
+  int nb_errors = 0;
+  int i;
+
+  el.parseFromFile ( file_name );
+  el.compileToFile ( compiled );
+
+  iter = el.iterate ( );
+
+  while ( iter.hasNext() )
+    entities.append ( iter.next() );
+
+  qSort ( entities.begin(), entities.end(), compare_sequences );
+
+  foreach ( Entity *e, entities )
+    {
+      if ( strcmp(e->getType(),ENTITY_NODE) == 0 )
+        {
+          const char *id = e->getValueOfAttribute ( NAME_NODE_ID );
+          const QString qid = ( id != NULL ) ? QString(id) : QString::number(expected_nodes.size()) + "__node";
+
+          expected_nodes.append ( qid );
+          known.insert ( qid );
+        }
+      else if ( strcmp(e->getType(),ENTITY_EDGE) == 0 )
+        {
+          p.first = Node::extractNodeName ( e->getValueOfAttribute(NAME_EDGE_SRC_PORT) );
+          p.second = Node::extractNodeName ( e->getValueOfAttribute(NAME_EDGE_DEST_PORT) );
+
+          if ( known.contains(p.first) && known.contains(p.second) )
+            {
+              if ( p.first != p.second )
+                expected_edges.append ( p.first + "->" + p.second );
+            }
+          else
+            pending.append ( p );
+        }
+    }
+
+  foreach ( p, pending )
+    if ( known.contains(p.first) && known.contains(p.second) && ( p.first != p.second ) )
+      expected_edges.append ( p.first + "->" + p.second );
+
+  files[0] = file_name;
+  files[1] = compiled;
+
+  for ( i=0; i<2; ++i )
+    {
+      Graph g;
+      QMap<quint32,QString> nodes_by_n_id;
+      QStringList edges;
+
+      g.initFromFile ( files[i] );
+
+      foreach ( Node *n, g.nodes )
+        nodes_by_n_id.insert ( n->n_id, n->id );
+
+      foreach ( Edge *e, g.edges )
+        edges.append ( e->src->id + "->" + e->dest->id );
+
+      if ( ( nodes_by_n_id.values() != expected_nodes ) || ( edges != expected_edges ) )
+        ++nb_errors;
+    }
+
+  unlink ( compiled );
+
+  std::cout << file_name << " (" << expected_nodes.size() << " nodes, " << expected_edges.size() << " edges)"
+            << ( (nb_errors == 0) ? "\n" : ", NOT IN FILE ORDER\n" );
+
+  return ( nb_errors == 0 );
+}
+
+
 
 int
 main ( int argc,
        char *argv[] )
 {
-  int i;
+  int c;
+  int ret = 0;
+  bool bench = false;
+  bool reproducible = false;
+  bool scc = false;
+  bool subgraphs = false;
+  bool packing = false;
+  bool order = false;
+  int nb_subgraphs = 1;
 
-  for ( i=1; i<argc; ++i )
+  /* synthetic graphs */
+  while ( ( c = getopt(argc, argv, "brcgpok:s:") ) != -1 )
     {
+      if ( c == 'b' )
+        bench = true;
+      else if ( c == 'r' )
+        reproducible = true;
+      else if ( c == 'c' )
+        scc = true;
+      else if ( c == 'g' )
+        subgraphs = true;
+      else if ( c == 'p' )
+        packing = true;
+      else if ( c == 'o' )
+        order = true;
+      else if ( c == 'k' )
+        nb_subgraphs = atoi ( optarg );
+      else if ( c == 's' )
+        {
+          Graph *g = build_synthetic_graph ( atoi(optarg), nb_subgraphs );
+
+          if ( bench )
+            bench_relayout ( g, "synthetic" );
+          else if ( scc )
+            {
+              if ( !check_scc(g,"synthetic") )
+                ret = -1;
+            }
+          else if ( subgraphs )
+            {
+              if ( !check_subgraphs(g,"synthetic") )
+                ret = -1;
+            }
+          else if ( packing )
+            {
+              if ( !check_packing(g,"synthetic") )
+                ret = -1;
+            }
+          else if ( reproducible )
+            {
+              if ( !check_reproducible(g,"synthetic") )
+                ret = -1;
+            }
+          else
+            g->assignGridCoordinates ( );
+
+          delete g;
+        }
+    }
+
+  /* graph files */
+  for ( ; optind<argc; ++optind )
+    {
+      if ( order )
+        {
+          if ( !check_loading_order(argv[optind]) )
+            ret = -1;
+
+          continue;
+        }
+
       Graph *g = new Graph ( );
-      EntityList *el = new EntityList ( );
 
-      el->parseFromFile ( argv[i] );
-      g->initFromEntityList ( el );
-      delete el;
+      g->initFromFile ( argv[optind] );
+
+      if ( bench )
+        bench_relayout ( g, argv[optind] );
+      else if ( scc )
+        {
+          if ( !check_scc(g,argv[optind]) )
+            ret = -1;
+        }
+      else if ( subgraphs )
+        {
+          if ( !check_subgraphs(g,argv[optind]) )
+            ret = -1;
+        }
+      else if ( packing )
+        {
+          if ( !check_packing(g,argv[optind]) )
+            ret = -1;
+        }
+      else if ( reproducible )
+        {
+          if ( !check_reproducible(g,argv[optind]) )
+            ret = -1;
+        }
+      else
+        g->assignGridCoordinates ( );
 
-      g->assignGridCoordinates ( );
       delete g;
     }
 
-  return 0;
+  return ret;
 }
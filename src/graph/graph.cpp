@@ -21,20 +21,56 @@
  * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+#include <QtConcurrent>
 #include "../parser/defs.h"
+#include "acyclic-greedy.h"
 #include "layering-lazy.h"
 #include "layering-floyd.h"
+#include "layering-bfs.h"
 #include "ordering-wmedian.h"
+#include "ordering-stable.h"
 #include "placing-genetic.h"
+#include "placing-stable.h"
+#include "graph-csr.h"
+#include "scc-condensation.h"
+#include "union-find.h"
 #include "graph.h"
 
 
+LayeringMode Graph::defaultLayeringMode = LAYERING_BFS;
+AcyclicMode Graph::defaultAcyclicMode = ACYCLIC_NONE;
+bool Graph::defaultIncrementalLayout = false;
+bool Graph::defaultParallelLayout = false;
+bool Graph::defaultComponentLayout = false;
+bool Graph::defaultSeededLayout = false;
+quint64 Graph::defaultLayoutSeed = 0;
+
+
+/*
+ * An incremental layout falls back to a full layout when more than
+ * this proportion of the nodes (virtual nodes included) is dirty.
+ */
+#define INCREMENTAL_MAX_DIRTY_RATIO 0.5
+
+
 /*
  * Constructor
  */
 Graph::Graph ( )
 {
   this->resetNodeCounter ( );
+  this->layeringMode = defaultLayeringMode;
+  this->acyclicMode = defaultAcyclicMode;
+  this->incrementalLayout = defaultIncrementalLayout;
+  this->parallelLayout = defaultParallelLayout;
+  this->componentLayout = defaultComponentLayout;
+  this->seededLayout = defaultSeededLayout;
+  this->layoutSeed = defaultLayoutSeed;
+  this->layoutId = 0;
+  this->lastLayoutTime = 0;
+  this->lastLayoutIncremental = false;
+  this->lastLayoutCancelled = false;
+  this->cancelFlag = NULL;
 }
 
 Graph::Graph ( QList<Node *> &nlist )
@@ -43,6 +79,18 @@ Graph::Graph ( QList<Node *> &nlist )
   Edge *e;
 
   this->resetNodeCounter ( );
+  this->layeringMode = defaultLayeringMode;
+  this->acyclicMode = defaultAcyclicMode;
+  this->incrementalLayout = defaultIncrementalLayout;
+  this->parallelLayout = defaultParallelLayout;
+  this->componentLayout = defaultComponentLayout;
+  this->seededLayout = defaultSeededLayout;
+  this->layoutSeed = defaultLayoutSeed;
+  this->layoutId = 0;
+  this->lastLayoutTime = 0;
+  this->lastLayoutIncremental = false;
+  this->lastLayoutCancelled = false;
+  this->cancelFlag = NULL;
 
   /* nodes creation */
   foreach ( Node *n, nlist )
@@ -103,12 +151,12 @@ Graph::initFromEntityList ( const EntityList *el )
     {
       e = iter.next ( );
 
-      src = this->nodes.value ( Node::extractNodeName( e->getValueOfAttribute("src_port") ) );
+      src = this->nodes.value ( Node::extractNodeName( e->getValueOfAttribute(NAME_EDGE_SRC_PORT) ) );
 
       if ( src == NULL )
         continue;
 
-      dest = this->nodes.value ( Node::extractNodeName( e->getValueOfAttribute("dest_port") ) );
+      dest = this->nodes.value ( Node::extractNodeName( e->getValueOfAttribute(NAME_EDGE_DEST_PORT) ) );
 
       if ( dest == NULL )
         continue;
@@ -126,6 +174,92 @@ Graph::initFromEntityList ( const EntityList *el )
 }
 
 
+/*
+ * Visitor used to build a graph while its file is read.
+ * Edges whose nodes are not known yet are resolved at the end.
+ */
+class GraphBuilder : public EntityVisitor
+{
+ public:
+  GraphBuilder ( Graph *g ) : g(g) { }
+
+  void onNode ( Entity *e )
+  {
+    Node *node = new Node ( g );
+    node->initFromEntity ( e );
+    g->addNode ( node );
+  }
+
+  void onEdge ( Entity *e )
+  {
+    const QString src = Node::extractNodeName ( e->getValueOfAttribute(NAME_EDGE_SRC_PORT) );
+    const QString dest = Node::extractNodeName ( e->getValueOfAttribute(NAME_EDGE_DEST_PORT) );
+
+    if ( !addEdge(src,dest) )
+      pending.append ( QPair<QString, QString> ( src, dest ) );
+  }
+
+  /*
+   * Add the edges that came before their nodes.
+   */
+  void finish ( )
+  {
+    QPair<QString, QString> p;
+
+    foreach ( p, pending )
+      addEdge ( p.first, p.second );
+
+    pending.clear ( );
+  }
+
+ private:
+  /*
+   * Add an edge between two nodes, if they are known.
+   */
+  bool addEdge ( const QString &srcName,
+                 const QString &destName )
+  {
+    Node *src = g->nodes.value ( srcName );
+    Node *dest = g->nodes.value ( destName );
+    Edge *edge;
+
+    if ( ( src == NULL ) || ( dest == NULL ) )
+      return false;
+
+    if ( src != dest ) /* loops are ignored */
+      {
+        edge = new Edge ( );
+        edge->setSrc ( src );
+        edge->setDest ( dest );
+        g->addEdge ( edge );
+
+        src->addChild ( dest );
+      }
+
+    return true;
+  }
+
+  Graph *g;
+  QList<QPair<QString, QString> > pending;
+} ;
+
+
+/*
+ * Initialization of a graph by reading a file, without building
+ * an entity list. Groups are not handled.
+ */
+void
+Graph::initFromFile ( const char *file_name )
+{
+  GraphBuilder builder ( this );
+
+  this->resetNodeCounter ( );
+
+  EntityList::visitFile ( file_name, &builder );
+  builder.finish ( );
+}
+
+
 /*
  * Add a node to the graph.
  */
@@ -139,6 +273,31 @@ Graph::addNode ( Node *n )
 }
 
 
+/*
+ * Reverse the edges of a feedback set found by the greedy cycle removal.
+ * The layering then works on an acyclic graph, unReverseUpwardEdges()
+ * restores these edges too.
+ */
+void
+Graph::reverseFeedbackEdges ( )
+{
+  QList<Node *> nodes_list;
+
+  this->feedListWithActiveNodes ( nodes_list );
+
+  GraphCsr csr ( nodes_list );
+  qint32 *rank = new qint32 [ csr.size() + 1 ];
+
+  AcyclicGreedy::applyToCsr ( csr, rank );
+
+  foreach ( Edge *e, this->edges )
+    if ( ( e->isActive() ) && ( rank[e->src->tag] > rank[e->dest->tag] ) )
+      e->reverse ( );
+
+  delete [] rank;
+}
+
+
 /*
  * Reverse the edges that go from a node which is deeper than the destination.
  */
@@ -201,110 +360,325 @@ Graph::feedListWithActiveNodes ( QList<Node *> &l ) const
 }
 
 
+/*
+ * Assign to each (active) node its Strongly Connected Component ID.
+ * The IDs start at 1 and follow a topological order of the components:
+ * an edge never goes from a component to one with a lower ID.
+ */
+void
+Graph::assignSccIDs ( )
+{
+  QList<Node *> nodesList;
+  qint32 i;
+
+  this->feedListWithActiveNodes ( nodesList );
+
+  const GraphCsr csr ( nodesList );
+  const SccCondensation scc ( csr );
+
+  for ( i=0; i<csr.size(); ++i )
+    csr.nodes[i]->scc_id = scc.componentOf ( i ) + 1;
+}
+
+
 /*
  * Assign to each (active) node its subgraph ID
- * recursiveGrouping() finds the subgraph a set of nodes belong to.
- * recursiveTagging() assigns a subgraph ID to every node it processes.
+ * The subgraphs are the connected components of the active nodes, the
+ * direction of the edges aside. They are found with a union-find over
+ * the edges, and numbered from 1 in the order of their first node.
  */
-static quint32
-recursiveGrouping ( Node *n )
+void
+Graph::assignSubgraphIDs ( )
 {
-  /* this function determines if a set of nodes belong to a subgraph */
+  QList<Node *> nodesList;
+  qint32 i;
 
-  quint32 id = 0;
+  this->feedListWithActiveNodes ( nodesList );
 
-  if ( n->subgraph_id != 0 )
-    return n->subgraph_id;
+  const qint32 N = nodesList.size ( );
+  UnionFind sets ( N );
+  qint32 *ids = new qint32 [ N+1 ];
+  quint32 nextid = 1;
 
-  /* the node is tagged if visited */
-  if ( n->tag != 0 )
-    return n->subgraph_id;
+  for ( i=0; i<N; ++i )
+    {
+      nodesList[i]->tag = i;
+      ids[i] = 0;
+    }
 
-  n->tag = 1;
+  foreach ( Edge *e, this->edges )
+    if ( e->isActive() )
+      sets.unite ( e->src->tag, e->dest->tag );
 
-  /* explore children */
-  foreach ( Node *child, n->children )
+  for ( i=0; i<N; ++i )
     {
-      id = recursiveGrouping ( child );
+      const qint32 root = sets.find ( i );
 
-      if ( id != 0 )
-        break;
+      if ( ids[root] == 0 )
+        ids[root] = nextid++;
+
+      nodesList[i]->subgraph_id = ids[root];
     }
 
-  /* explore parents */
-  if ( id != 0 )
+  delete [] ids;
+}
+
+
+/*
+ * Give the virtual nodes of the edges that were virtualized in the
+ * previous layout the position they had (see Edge::unVirtualize).
+ */
+void
+Graph::seedVirtualNodes ( )
+{
+  foreach ( Edge *e, this->edges )
     {
-      foreach ( Node *parent, n->parents )
+      if ( !e->virtualized )
+        continue;
+
+      if ( ( e->src->layout_id != this->layoutId ) || ( e->dest->layout_id != this->layoutId ) )
+        continue; /* the edge was not drawn by the previous layout */
+
+      foreach ( Edge *ve, e->virtualEdges )
         {
-          id = recursiveGrouping ( parent );
+          Node *v = ve->src;
+          const int key = ( e->reversed ) ? -((int)v->grid_y) : v->grid_y;
 
-          if ( id != 0 )
-            break;
+          if ( e->virtualPoints.contains(key) )
+            {
+              v->layout_id = this->layoutId;
+              v->prev_grid_x = e->virtualPoints.value ( key );
+              v->prev_grid_y = v->grid_y;
+            }
         }
     }
+}
 
-  return id;
+
+/*
+ * Find the nodes that an incremental layout has to place: the nodes
+ * which were not part of the previous layout or changed of layer,
+ * and their neighbours.
+ * Returns false if there are too many of them to bother.
+ */
+bool
+Graph::markDirtyNodes ( QList<Node *> &nodes_list )
+{
+  QList<Node *> changed;
+  int nb_dirty = 0;
+
+  foreach ( Node *n, nodes_list )
+    {
+      n->dirty = false;
+
+      if ( ( n->layout_id != this->layoutId ) || ( n->prev_grid_y != n->grid_y ) )
+        changed.append ( n );
+    }
+
+  foreach ( Node *n, changed )
+    {
+      n->dirty = true;
+
+      foreach ( Node *parent, n->parents )
+        parent->dirty = true;
+
+      foreach ( Node *child, n->children )
+        child->dirty = true;
+    }
+
+  foreach ( Node *n, nodes_list )
+    if ( n->dirty )
+      ++nb_dirty;
+
+  return ( nb_dirty <= INCREMENTAL_MAX_DIRTY_RATIO * nodes_list.size() );
+}
+
+
+/*
+ * Seed of the random placing algorithms: the layout seed of a seeded
+ * layout, so that the same graph always gets the same coordinates, or
+ * a fresh one.
+ */
+quint64
+Graph::placingSeed ( ) const
+{
+  if ( this->seededLayout )
+    return this->layoutSeed;
+
+  return (quint64) QDateTime::currentMSecsSinceEpoch ( );
 }
 
+
+/*
+ * Empty grid columns between two packed subgraphs.
+ */
+#define SUBGRAPHS_GAP 1
+
+
+/*
+ * Layer a list of nodes: each node first goes to its greatest
+ * shortest-path distance from an entry point, then the lazy pass.
+ * When the cycles were removed, the nodes are first pushed below
+ * their parents.
+ */
 static void
-recursiveTagging ( Node *n,
-                   quint32 id )
+layer_nodes ( QList<Node *> &nodes_list,
+              const LayeringMode mode,
+              const AcyclicMode acyclic )
 {
-  /* this function assigns a subgraph_id */
+  {
+    GraphCsr csr ( nodes_list );
 
-  if ( n->subgraph_id == id )
-    return;
+    if ( mode == LAYERING_FLOYD )
+      LayeringFloyd::applyToCsr ( csr );
+    else
+      LayeringBfs::applyToCsr ( csr );
 
-  n->subgraph_id = id;
+    if ( acyclic != ACYCLIC_NONE )
+      AcyclicGreedy::pushBelowParents ( csr );
 
-  foreach ( Node *child, n->children )
-    recursiveTagging ( child, id );
+    csr.storeCoordinates ( );
+  }
 
-  foreach ( Node *parent, n->parents )
-    recursiveTagging ( parent, id );
+  LayeringLazy::applyToNodes ( nodes_list );
 }
 
-void
-Graph::assignSubgraphIDs ( )
+
+/*
+ * Order and place a list of layered nodes.
+ */
+static void
+order_and_place_nodes ( QList<Node *> &nodes_list,
+                        const Graph *g,
+                        const quint64 seed,
+                        const bool parallel )
 {
-  Node *n;
-  Node *entry;
-  QList<Node *> entries;
-  QList<Node *> nodesList;
-  this->feedListWithActiveNodes ( nodesList );
+  GraphCsr csr ( nodes_list );
 
-  /* initialization */
-  QListIterator<Node *> iter ( nodesList );
-  entry = nodesList[0];
+  OrderingWMedian::applyToCsr ( csr, parallel );
 
-  while ( iter.hasNext() )
+  if ( !g->isLayoutCancelled() )
+    PlacingGenetic::applyToCsr ( csr, seed, parallel );
+
+  csr.storeCoordinates ( );
+}
+
+
+/*
+ * Functor used to layer the subgraphs in parallel.
+ */
+class SubgraphLayeringKernel
+{
+ public:
+  typedef void result_type;
+
+  SubgraphLayeringKernel ( const LayeringMode mode, const AcyclicMode acyclic )
+    : mode(mode), acyclic(acyclic) { }
+
+  void operator() ( QList<Node *> &subgraph ) const
+  {
+    layer_nodes ( subgraph, mode, acyclic );
+  }
+
+ private:
+  LayeringMode mode;
+  AcyclicMode acyclic;
+} ;
+
+
+/*
+ * Functor used to order and place the subgraphs in parallel.
+ */
+class SubgraphPlacingKernel
+{
+ public:
+  typedef void result_type;
+
+  SubgraphPlacingKernel ( const Graph *g, const quint64 seed )
+    : g(g), seed(seed) { }
+
+  void operator() ( QList<Node *> &subgraph ) const
+  {
+    if ( !g->isLayoutCancelled() )
+      order_and_place_nodes ( subgraph, g, seed, false );
+  }
+
+ private:
+  const Graph *g;
+  quint64 seed;
+} ;
+
+
+/*
+ * Split a list of nodes by subgraph ID. The subgraphs are sorted by
+ * their oldest node so that they are packed in the same order from
+ * one layout to the next.
+ */
+static void
+split_into_subgraphs ( const QList<Node *> &nodes_list,
+                       QList<QList<Node *> > &subgraphs )
+{
+  QHash<quint32,int> index;
+  QList<QPair<quint32,int> > oldest;
+  QList<QList<Node *> > groups;
+  int i;
+
+  foreach ( Node *n, nodes_list )
     {
-      n = iter.next ( );
-      n->subgraph_id = 0;
-      n->tag = 0;
+      i = index.value ( n->subgraph_id, -1 );
 
-      if ( entry->n_id > n->n_id ) /* we take the first node that was added to the graph */
-        entry = n;                 /* it will be used as the default entry point */
+      if ( i == -1 )
+        {
+          i = groups.size ( );
+          index.insert ( n->subgraph_id, i );
+          groups.append ( QList<Node *>() );
+          oldest.append ( qMakePair(n->n_id,i) );
+        }
+      else if ( n->n_id < oldest[i].first )
+        oldest[i].first = n->n_id;
 
-      if ( !n->hasParents() ) /* save the entries of the graph */
-        entries.append ( n );
+      groups[i].append ( n );
     }
 
-  if ( entries.size() == 0 )
-    entries.append ( entry );
+  qSort ( oldest.begin(), oldest.end() );
+
+  subgraphs.clear ( );
+
+  for ( i=0; i<oldest.size(); ++i )
+    subgraphs.append ( groups[oldest[i].second] );
+}
 
-  /* assignment */
-  quint32 id;
-  quint32 nextid = 1;
 
-  foreach ( n, entries )
+/*
+ * Pack the subgraphs side by side, from left to right.
+ * Each one keeps its layers, only its X coordinates are shifted.
+ */
+static void
+pack_subgraphs ( QList<QList<Node *> > &subgraphs )
+{
+  quint32 offset = 0;
+  quint32 xmin, xmax;
+
+  foreach ( const QList<Node *> &subgraph, subgraphs )
     {
-      id = recursiveGrouping ( n );
+      if ( subgraph.isEmpty() )
+        continue;
 
-      if ( id == 0 )
-        recursiveTagging ( n, nextid++ );
-      else
-        recursiveTagging ( n, id );
+      xmin = xmax = subgraph.first()->grid_x;
+
+      foreach ( Node *n, subgraph )
+        {
+          if ( n->grid_x < xmin )
+            xmin = n->grid_x;
+
+          if ( n->grid_x > xmax )
+            xmax = n->grid_x;
+        }
+
+      foreach ( Node *n, subgraph )
+        n->grid_x = n->grid_x - xmin + offset;
+
+      offset += xmax - xmin + 1 + SUBGRAPHS_GAP;
     }
 }
 
@@ -312,16 +686,71 @@ Graph::assignSubgraphIDs ( )
 /*
  * Assign to each (active) node its grid coordinates.
  * The maximal X grid coord and the maximal Y grid coord are returned.
+ *
+ * In incremental mode, when a previous layout exists, the nodes keep
+ * the place they had and only the dirty ones (see markDirtyNodes)
+ * are ordered and placed again. The layering and the virtualization
+ * are not incremental: they run on the whole graph every time. The
+ * coordinates then depend on the history of expands and collapses,
+ * not only on the fold state, which is why the full layout is the
+ * default. The target is to stay under 100ms per expand or collapse
+ * on graphs of 10k nodes; getLastLayoutTime() tells how long the
+ * layout took.
+ *
+ * When a cancel flag is set (see LayoutJob) and raised during the
+ * layout, the expensive stages are skipped and wasLastLayoutCancelled()
+ * returns true.
  */
 QPair<quint32, quint32>
 Graph::assignGridCoordinates ( )
 {
+  QElapsedTimer timer;
   QPair<quint32, quint32> gridMax ( 0, 0 );
   QList<Node *> nodes_list;
+  QList<Node *> real_nodes;
+  QList<QList<Node *> > subgraphs;
+  QList<QList<Node *> > children, parents;
+  bool incremental = ( this->incrementalLayout && ( this->layoutId != 0 ) );
+  int i;
+
+  timer.start ( );
   this->feedListWithActiveNodes ( nodes_list );
+  real_nodes = nodes_list;
 
-  LayeringFloyd::applyToNodes ( nodes_list );
-  LayeringLazy::applyToNodes ( nodes_list );
+  foreach ( Node *n, real_nodes )
+    {
+      children.append ( n->children );
+      parents.append ( n->parents );
+    }
+
+  /* remember where the nodes were */
+  if ( incremental )
+    {
+      foreach ( Node *n, nodes_list )
+        {
+          n->prev_grid_x = n->grid_x;
+          n->prev_grid_y = n->grid_y;
+        }
+    }
+
+  /* cycle removal */
+  if ( this->acyclicMode == ACYCLIC_GREEDY )
+    this->reverseFeedbackEdges ( );
+
+  /* layering, subgraph by subgraph in component layout */
+  if ( this->componentLayout )
+    {
+      this->assignSubgraphIDs ( );
+      split_into_subgraphs ( nodes_list, subgraphs );
+
+      if ( this->parallelLayout )
+        QtConcurrent::blockingMap ( subgraphs, SubgraphLayeringKernel(this->layeringMode,this->acyclicMode) );
+      else
+        for ( i=0; i<subgraphs.size(); ++i )
+          layer_nodes ( subgraphs[i], this->layeringMode, this->acyclicMode );
+    }
+  else
+    layer_nodes ( nodes_list, this->layeringMode, this->acyclicMode );
 
   this->reverseUpwardEdges ( );
   this->virtualizeLongEdges ( );
@@ -343,8 +772,40 @@ Graph::assignGridCoordinates ( )
 
   this->feedListWithActiveNodes ( nodes_list ); /* update the nodes list because of the virtualization */
 
-  OrderingWMedian::applyToNodes ( nodes_list );
-  PlacingGenetic::applyToNodes ( nodes_list );
+  if ( incremental )
+    {
+      this->seedVirtualNodes ( );
+      incremental = this->markDirtyNodes ( nodes_list );
+    }
+
+  if ( incremental )
+    {
+      OrderingStable::applyToNodes ( nodes_list );
+      PlacingStable::applyToNodes ( nodes_list );
+    }
+  else if ( !this->isLayoutCancelled() )
+    {
+      const quint64 seed = this->placingSeed ( );
+
+      if ( this->componentLayout && ( subgraphs.size() > 1 ) )
+        {
+          SubgraphPlacingKernel kernel ( this, seed );
+
+          /* the virtual nodes joined the subgraph of their edge */
+          split_into_subgraphs ( nodes_list, subgraphs );
+
+          /* the subgraphs run in parallel, each one on a single thread */
+          if ( this->parallelLayout )
+            QtConcurrent::blockingMap ( subgraphs, kernel );
+          else
+            for ( i=0; i<subgraphs.size(); ++i )
+              kernel ( subgraphs[i] );
+
+          pack_subgraphs ( subgraphs );
+        }
+      else
+        order_and_place_nodes ( nodes_list, this, seed, this->parallelLayout );
+    }
 
   foreach ( Node *n, nodes_list )
     {
@@ -358,6 +819,33 @@ Graph::assignGridCoordinates ( )
   this->unVirtualizeLongEdges ( );
   this->unReverseUpwardEdges ( );
 
+  /* the reversed and virtualized edges came back at the end of the
+     children and parents lists: restore their order, so that the next
+     layout starts from the same graph */
+  for ( i=0; i<real_nodes.size(); ++i )
+    {
+      real_nodes[i]->children = children[i];
+      real_nodes[i]->parents = parents[i];
+    }
+
+  /* a cancelled layout leaves the nodes somewhere, do not trust it */
+  this->lastLayoutCancelled = this->isLayoutCancelled ( );
+
+  if ( this->lastLayoutCancelled )
+    {
+      this->layoutId = 0;
+      return gridMax;
+    }
+
+  /* stamp the nodes of this layout */
+  ++this->layoutId;
+
+  foreach ( Node *n, real_nodes )
+    n->layout_id = this->layoutId;
+
+  this->lastLayoutIncremental = incremental;
+  this->lastLayoutTime = timer.elapsed ( );
+
   return gridMax;
 }
 
@@ -40,6 +40,13 @@ typedef struct st_candidate
 } Candidate ;
 
 
+/* layering algorithms available for assignGridCoordinates() */
+typedef enum { LAYERING_FLOYD, LAYERING_BFS } LayeringMode ;
+
+/* cycle removal algorithms available for assignGridCoordinates() */
+typedef enum { ACYCLIC_NONE, ACYCLIC_GREEDY } AcyclicMode ;
+
+
 class Graph
 {
  public:
@@ -48,6 +55,7 @@ class Graph
   virtual ~Graph ( );
 
   void initFromEntityList ( const EntityList * );
+  void initFromFile ( const char * );             /* same, streaming the file */
 
   inline quint32 getNextNodeId ( ) { return this->n_id_counter++; }
 
@@ -68,6 +76,29 @@ class Graph
 
   void clear ( );
 
+  inline void setLayeringMode ( const LayeringMode m ) { layeringMode = m; }
+  inline LayeringMode getLayeringMode ( ) const { return layeringMode; }
+  inline void setAcyclicMode ( const AcyclicMode m ) { acyclicMode = m; }         /* how the cycles are broken before the layering */
+  inline AcyclicMode getAcyclicMode ( ) const { return acyclicMode; }
+
+  inline void setIncrementalLayout ( const bool b ) { incrementalLayout = b; }   /* reorder and replace only what changed since the last layout */
+  inline bool isIncrementalLayout ( ) const { return incrementalLayout; }
+  inline void setParallelLayout ( const bool b ) { parallelLayout = b; }         /* use the thread pool for ordering and placing */
+  inline bool isParallelLayout ( ) const { return parallelLayout; }
+  inline void setComponentLayout ( const bool b ) { componentLayout = b; }       /* lay out the subgraphs apart and pack them side by side */
+  inline bool isComponentLayout ( ) const { return componentLayout; }
+  inline void setSeededLayout ( const bool b ) { seededLayout = b; }             /* place with the fixed seed below, not a fresh one */
+  inline bool isSeededLayout ( ) const { return seededLayout; }
+  inline void setLayoutSeed ( const quint64 s ) { layoutSeed = s; seededLayout = true; }
+  inline quint64 getLayoutSeed ( ) const { return layoutSeed; }
+  inline qint64 getLastLayoutTime ( ) const { return lastLayoutTime; }          /* duration of the last layout (ms) */
+  inline bool wasLastLayoutIncremental ( ) const { return lastLayoutIncremental; }
+  inline bool wasLastLayoutCancelled ( ) const { return lastLayoutCancelled; }
+
+  inline void setCancelFlag ( const QAtomicInt *f ) { cancelFlag = f; }         /* layouts stop when *f becomes non-zero */
+  inline bool isLayoutCancelled ( ) const { return ( ( cancelFlag != NULL ) && ( cancelFlag->loadAcquire() != 0 ) ); }
+
+  void reverseFeedbackEdges ( );  /* reverse a small set of edges so that the graph has no cycle */
   void reverseUpwardEdges ( );    /* reverse the edges that are upward oriented */
   void virtualizeLongEdges ( );   /* add virtual nodes so that for each edge : src.grid_y == dest.grid_y+1 */
   void unVirtualizeLongEdges ( ); /* remove the previously created virtual nodes */
@@ -75,14 +106,41 @@ class Graph
 
  private:  
   void resetNodeCounter ( ) { this->n_id_counter = 0; } /* reset the node counter */
+  void seedVirtualNodes ( );                             /* give the virtual nodes their previous position */
+  bool markDirtyNodes ( QList<Node *> & );               /* find the nodes an incremental layout has to place */
+  quint64 placingSeed ( ) const;                         /* seed of the random placing algorithms */
 
 
  public:
   QHash<QString,Node *> nodes;  /* nodes of the graph */
   QList<Edge *> edges;          /* edges of the graph */
 
+  static LayeringMode defaultLayeringMode; /* layering mode of the graphs created from now on */
+  static AcyclicMode defaultAcyclicMode;   /* cycle removal mode of the graphs created from now on */
+  static bool defaultIncrementalLayout;    /* incremental layout of the graphs created from now on */
+  static bool defaultParallelLayout;       /* parallel layout of the graphs created from now on */
+  static bool defaultComponentLayout;      /* component layout of the graphs created from now on */
+  static bool defaultSeededLayout;         /* seeded layout of the graphs created from now on */
+  static quint64 defaultLayoutSeed;
+
  private:
   quint32 n_id_counter;
+  LayeringMode layeringMode;
+  AcyclicMode acyclicMode;
+
+  bool incrementalLayout;
+  bool parallelLayout;
+  bool componentLayout;
+  bool seededLayout;
+  quint64 layoutSeed;
+  quint32 layoutId;             /* id of the last layout (0 if none) */
+  qint64 lastLayoutTime;
+  bool lastLayoutIncremental;
+  bool lastLayoutCancelled;
+  const QAtomicInt *cancelFlag;
+
+  friend class LayoutJob;
+  friend class LayoutCache;
 
 } ;
 
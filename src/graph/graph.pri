@@ -1,19 +1,41 @@
 # Graph
 
+QT += concurrent
+
 HEADERS += $$SRC_DIR/graph/node.h              \
            $$SRC_DIR/graph/edge.h              \
            $$SRC_DIR/graph/graph.h             \
+           $$SRC_DIR/graph/graph-csr.h         \
+           $$SRC_DIR/graph/scc-condensation.h  \
+           $$SRC_DIR/graph/union-find.h        \
+           $$SRC_DIR/graph/acyclic-greedy.h    \
            $$SRC_DIR/graph/layering-lazy.h     \
            $$SRC_DIR/graph/layering-floyd.h    \
+           $$SRC_DIR/graph/layering-bfs.h      \
+           $$SRC_DIR/graph/crossing-counter.h  \
            $$SRC_DIR/graph/ordering-wmedian.h  \
+           $$SRC_DIR/graph/ordering-stable.h   \
            $$SRC_DIR/graph/placing-genetic.h   \
-           $$SRC_DIR/graph/placing-cuckoo.h
+           $$SRC_DIR/graph/placing-stable.h    \
+           $$SRC_DIR/graph/placing-cuckoo.h    \
+           $$SRC_DIR/graph/placing-random.h    \
+           $$SRC_DIR/graph/layout-job.h        \
+           $$SRC_DIR/graph/layout-cache.h
 
 SOURCES += $$SRC_DIR/graph/node.cpp              \
            $$SRC_DIR/graph/edge.cpp              \
            $$SRC_DIR/graph/graph.cpp             \
+           $$SRC_DIR/graph/graph-csr.cpp         \
+           $$SRC_DIR/graph/scc-condensation.cpp  \
+           $$SRC_DIR/graph/acyclic-greedy.cpp    \
            $$SRC_DIR/graph/layering-lazy.cpp     \
            $$SRC_DIR/graph/layering-floyd.cpp    \
+           $$SRC_DIR/graph/layering-bfs.cpp      \
+           $$SRC_DIR/graph/crossing-counter.cpp  \
            $$SRC_DIR/graph/ordering-wmedian.cpp  \
+           $$SRC_DIR/graph/ordering-stable.cpp   \
            $$SRC_DIR/graph/placing-genetic.cpp   \
-           $$SRC_DIR/graph/placing-cuckoo.cpp
+           $$SRC_DIR/graph/placing-stable.cpp    \
+           $$SRC_DIR/graph/placing-cuckoo.cpp    \
+           $$SRC_DIR/graph/layout-job.cpp        \
+           $$SRC_DIR/graph/layout-cache.cpp
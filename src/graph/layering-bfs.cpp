@@ -0,0 +1,171 @@
+/*
+ * layering-bfs.cpp
+ *
+ * Implementation of the LayeringBfs class / breadth-first layering algorithm.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <climits>
+#include "layering-bfs.h"
+
+
+/*
+ * The breadth-first layering algorithm
+ *
+ * This layering algorithm assigns the same grid Y coordinates
+ * as the floyd layering algorithm: each node is placed at its
+ * greatest distance from the entry points of the graph.
+ *
+ * Instead of computing the whole distance matrix, a breadth-first
+ * search is run from every entry point over the children lists.
+ * This needs O(N) memory and O(entries*(N+E)) time, which is
+ * linear for the usual graphs that have only a few entry points,
+ * but quadratic on graphs with many of them. A single search from
+ * all the entry points at once would give the smallest distance to
+ * any of them, not the greatest, so each entry needs its own search.
+ * Each search only resets the distances of the nodes it reached.
+ *
+ */
+
+
+#define LIMIT INT_MAX
+
+
+/*
+ * Layout a list of nodes using breadth-first searches.
+ */
+void
+LayeringBfs::applyToNodes ( QList<Node *> &nodes )
+{
+  GraphCsr csr ( nodes );
+
+  applyToCsr ( csr );
+  csr.storeCoordinates ( );
+}
+
+
+/*
+ * Layout a graph snapshot using breadth-first searches.
+ */
+void
+LayeringBfs::applyToCsr ( GraphCsr &g )
+{
+  quint32 *dist;
+  quint32 *depth;
+  qint32 *queue;
+  QList<qint32> entries;
+  qint32 i, j, n, child, entry;
+  quint32 head, tail, k;
+
+  const qint32 N = g.size ( );
+
+  if ( N == 0 )
+    return;
+
+  /* allocate the working arrays */
+  dist = new quint32 [ N ];
+  depth = new quint32 [ N ];
+  queue = new qint32 [ N ];
+
+  for ( i=0; i!=N; ++i )
+    {
+      depth[i] = 0;
+
+      if ( g.nbParents(i) == 0 ) /* save the entries of the graph */
+        entries.append ( i );
+    }
+
+  if ( entries.size() == 0 )
+    entries.append ( g.defaultEntry() );
+
+  /* breadth-first search from each entry point, keeping the greatest distance */
+  for ( i=0; i!=N; ++i )
+    dist[i] = LIMIT;
+
+  foreach ( entry, entries )
+    {
+      dist[entry] = 0;
+      queue[0] = entry;
+      head = 0;
+      tail = 1;
+
+      while ( head != tail )
+        {
+          n = queue[head++];
+          k = dist[n];
+
+          if ( k > depth[n] )
+            depth[n] = k;
+
+          const qint32 *children = g.children ( n );
+          const qint32 nbChildren = g.nbChildren ( n );
+
+          for ( j=0; j!=nbChildren; ++j )
+            {
+              child = children[j];
+
+              if ( dist[child] == LIMIT )
+                {
+                  dist[child] = k + 1;
+                  queue[tail++] = child;
+                }
+            }
+        }
+
+      /* the queue holds exactly the nodes this search reached */
+      for ( k=0; k!=tail; ++k )
+        dist[queue[k]] = LIMIT;
+    }
+
+  /* affect a layer id to each node according to its distance from the entry points */
+  for ( i=0; i!=N; ++i )
+    g.y[i] = depth[i];
+
+  /* we move the entry points just above their nearest child */
+  foreach ( entry, entries )
+    {
+      const qint32 *children = g.children ( entry );
+      const qint32 nbChildren = g.nbChildren ( entry );
+      bool found = false;
+
+      k = LIMIT;
+
+      for ( j=0; j!=nbChildren; ++j )
+        {
+          child = children[j];
+
+          if ( g.y[child] == 0 )
+            continue;
+
+          if ( g.y[child] < k )
+            {
+              k = g.y[child];
+              found = true;
+            }
+        }
+
+      if ( found )
+        g.y[entry] = k - 1;
+    }
+
+  /* free memory */
+  delete [] dist;
+  delete [] depth;
+  delete [] queue;
+}
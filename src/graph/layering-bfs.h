@@ -1,7 +1,9 @@
 /*
- * tarjan.h
+ * layering-bfs.h
  *
- * Declaration of the Tarjan function (strongly connected componenents finding).
+ * Declaration of the LayeringBfs class.
+ * It can layer a graph.
+ * The algorithm is described in layering-bfs.cpp
  *
  * This file is distributed as part of Kroket.
  * Copyright (c) 2010 Nicolas BENOIT
@@ -22,27 +24,19 @@
  */
 
 
-#ifndef __TARJAN_H__
-#define __TARJAN_H__
+#ifndef __LAYERING_BFS_H__
+#define __LAYERING_BFS_H__
 
 #include <QtCore>
+#include "node.h"
+#include "graph-csr.h"
 
-#include "graph/graph.h"
 
-
-class Tarjan
+class LayeringBfs
 {
  public:
-
-  /*
-   * Build a list of the SCCs of a graph.
-   */
-  static QList<QList<Node *> * > * buildSccList ( const Graph * );
-
-  /*
-   * Assign the SCC ID to each node of a graph.
-   */
-  static void assignSccIDs ( Graph * );
+  static void applyToNodes ( QList<Node *> & );
+  static void applyToCsr ( GraphCsr & );
 
 } ;
 
@@ -22,6 +22,10 @@
  */
 
 #include <iostream>
+#include <QtConcurrent>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "layering-floyd.h"
 
 
@@ -33,148 +37,294 @@
  * on the distance between a node and the entry points
  * of the graph.
  *
+ * The distance matrix is stored in a single aligned buffer
+ * and computed with the blocked (tiled) version of the
+ * algorithm. For each diagonal tile, the tile itself is
+ * computed first, then the tiles of its row and column,
+ * then all the remaining tiles. The tiles of the last two
+ * phases are independent and are computed in parallel.
+ *
  */
 
 
-#define LIMIT INT_MAX
+/* LIMIT+LIMIT must not overflow a signed 32 bits integer (SIMD compare is signed) */
+#define LIMIT 0x3fffffff
+
+/* width of a tile, multiple of 4 so that rows can be processed with SSE2 */
+#define BLOCK 64
 
 
 /*
- * Layout a list of nodes using the floyd algorithm.
+ * Min-plus product of a tile: C[i][j] = min ( C[i][j], A[i][k] + B[k][j] ).
+ * C, A and B point to the first element of their tile.
  */
-void
-LayeringFloyd::applyToNodes ( QList<Node *> &nodes )
+static inline void
+min_plus_tile ( quint32 *C,
+                const quint32 *A,
+                const quint32 *B,
+                const quint32 stride )
 {
-  quint32 **m;
-  quint32 *row;
   quint32 i, j, k;
-  Node *n, *child, *entry;
-  QList<Node *> entries;
 
-  const quint32 N = nodes.size ( );
+  for ( k=0; k!=BLOCK; ++k )
+    {
+      const quint32 *brow = B + k*stride;
 
-  if ( N == 0 )
-    return;
+      for ( i=0; i!=BLOCK; ++i )
+        {
+          quint32 *crow = C + i*stride;
+          const quint32 a = A[i*stride+k];
 
-  entry = nodes[0];
+          if ( a == LIMIT )
+            continue;
 
-  /* allocate matrix */
-  m = new quint32 * [ N ];
+#ifdef __SSE2__
+          const __m128i va = _mm_set1_epi32 ( a );
 
-  for ( i=0; i!=N; ++i )
+          for ( j=0; j!=BLOCK; j+=4 )
+            {
+              __m128i c = _mm_load_si128 ( (const __m128i *) (crow+j) );
+              __m128i t = _mm_add_epi32 ( va, _mm_load_si128((const __m128i *) (brow+j)) );
+              __m128i gt = _mm_cmpgt_epi32 ( c, t );
+              c = _mm_or_si128 ( _mm_and_si128(gt,t), _mm_andnot_si128(gt,c) );
+              _mm_store_si128 ( (__m128i *) (crow+j), c );
+            }
+#else
+          for ( j=0; j!=BLOCK; ++j )
+            {
+              const quint32 tmp = a + brow[j];
+
+              if ( crow[j] > tmp )
+                crow[j] = tmp;
+            }
+#endif
+        }
+    }
+}
+
+
+/*
+ * Functor used to compute the independent tiles of a phase in parallel.
+ * A tile is identified by its (row, column) tile coordinates.
+ */
+class TileKernel
+{
+ public:
+  typedef void result_type;
+
+  TileKernel ( quint32 *m, const quint32 stride, const quint32 kb )
+    : m(m), stride(stride), kb(kb) { }
+
+  void operator() ( const QPair<quint32, quint32> &tile ) const
+  {
+    min_plus_tile ( m + (tile.first*stride + tile.second)*BLOCK,
+                    m + (tile.first*stride + kb)*BLOCK,
+                    m + (kb*stride + tile.second)*BLOCK,
+                    stride );
+  }
+
+ private:
+  quint32 *m;
+  quint32 stride;
+  quint32 kb;
+} ;
+
+
+/*
+ * Compute the distances between all the nodes of a graph snapshot.
+ * The distance from node i to node j is stored at m[i*stride+j],
+ * unreachable nodes have a distance equal to LayeringFloyd::unreachable().
+ * The returned matrix must be freed with freeDistanceMatrix().
+ */
+quint32 *
+LayeringFloyd::buildDistanceMatrix ( const GraphCsr &g,
+                                     quint32 *stride )
+{
+  quint32 *m;
+  quint32 *row;
+  quint32 i, j, kb;
+
+  const quint32 N = g.size ( );
+  const quint32 NB = (N + BLOCK - 1) / BLOCK; /* number of tiles per row */
+  const quint32 S = NB * BLOCK;
+
+  /* allocate matrix, padding rows/columns are never reachable */
+  m = (quint32 *) qMallocAligned ( sizeof(quint32)*S*S, 64 );
+
+  for ( i=0; i!=S; ++i )
     {
-      m[i] = new quint32 [ N ];
-      row = m[i];
+      row = m + i*S;
 
-      for ( j=0; j!=N; ++j )
+      for ( j=0; j!=S; ++j )
         row[j] = LIMIT;
 
-      nodes[i]->tag = i;
+      row[i] = 0;
     }
 
   /* initialize matrix with adjacencies */
-  QListIterator<Node *> iter ( nodes );
-
-  while ( iter.hasNext() )
+  for ( i=0; i!=N; ++i )
     {
-      n = iter.next ( );
-      n->grid_y = 0;
-      row = m [ n->tag ];
-
-      if ( entry->n_id > n->n_id ) /* we take the first node that was added to the graph */
-        entry = n;                 /* it will be used as the default entry point */
-
-      if ( !n->hasParents() ) /* save the entries of the graph */
-        entries.append ( n );
+      const qint32 *children = g.children ( i );
+      const qint32 nbChildren = g.nbChildren ( i );
 
-      foreach ( child, n->children )
-        row[child->tag] = 1;
+      row = m + i*S;
 
-      row[n->tag] = 0;
+      for ( j=0; j!=(quint32)nbChildren; ++j )
+        if ( children[j] != (qint32)i )
+          row[children[j]] = 1;
     }
 
-  if ( entries.size() == 0 )
-    entries.append ( entry );
-
-  /* compute matrix (floyd algorithm) */
-  quint32 tmp;
+  /* compute matrix (blocked floyd algorithm) */
+  QList<QPair<quint32, quint32> > tiles;
 
-  for ( i=0; i!=N; ++i )
+  for ( kb=0; kb!=NB; ++kb )
     {
-      for ( j=0; j!=N; ++j )
+      /* phase 1: the diagonal tile depends only on itself */
+      min_plus_tile ( m + (kb*S + kb)*BLOCK, m + (kb*S + kb)*BLOCK, m + (kb*S + kb)*BLOCK, S );
+
+      /* phase 2: the tiles of the same row and column depend on the diagonal one */
+      tiles.clear ( );
+
+      for ( i=0; i!=NB; ++i )
         {
-          row = m[j];
+          if ( i == kb )
+            continue;
 
-          for ( k=0; k!=N; ++k )
-            {
-              tmp = row[i] + m[i][k];
+          tiles.append ( QPair<quint32, quint32> ( kb, i ) );
+          tiles.append ( QPair<quint32, quint32> ( i, kb ) );
+        }
 
-              if ( row[k] > tmp )
-                row[k] = tmp;
-            }
+      QtConcurrent::blockingMap ( tiles, TileKernel(m,S,kb) );
+
+      /* phase 3: the other tiles depend on the tiles of phase 2 */
+      tiles.clear ( );
+
+      for ( i=0; i!=NB; ++i )
+        {
+          if ( i == kb )
+            continue;
+
+          for ( j=0; j!=NB; ++j )
+            if ( j != kb )
+              tiles.append ( QPair<quint32, quint32> ( i, j ) );
         }
+
+      QtConcurrent::blockingMap ( tiles, TileKernel(m,S,kb) );
     }
 
+  *stride = S;
 
-  /* affect a layer id to each node according to its distance from the entry points */
-  iter.toFront ( );
+  return m;
+}
 
-  QListIterator<Node *> entries_iter ( entries );
-  quint32 distance;
 
-  while ( iter.hasNext() )
-    {
-      n = iter.next ( );
+/*
+ * Free a matrix returned by buildDistanceMatrix().
+ */
+void
+LayeringFloyd::freeDistanceMatrix ( quint32 *m )
+{
+  qFreeAligned ( m );
+}
+
+
+/*
+ * Value of the distance between two nodes that are not connected.
+ */
+quint32
+LayeringFloyd::unreachable ( )
+{
+  return LIMIT;
+}
+
+
+/*
+ * Layout a list of nodes using the floyd algorithm.
+ */
+void
+LayeringFloyd::applyToNodes ( QList<Node *> &nodes )
+{
+  GraphCsr csr ( nodes );
 
+  applyToCsr ( csr );
+  csr.storeCoordinates ( );
+}
+
+
+/*
+ * Layout a graph snapshot using the floyd algorithm.
+ */
+void
+LayeringFloyd::applyToCsr ( GraphCsr &g )
+{
+  quint32 *m;
+  quint32 S;
+  quint32 k, distance;
+  qint32 i, j, child;
+  QList<qint32> entries;
+
+  const qint32 N = g.size ( );
+
+  if ( N == 0 )
+    return;
+
+  /* compute the distance matrix */
+  m = buildDistanceMatrix ( g, &S );
+
+  /* find the entry points */
+  for ( i=0; i!=N; ++i )
+    if ( g.nbParents(i) == 0 ) /* save the entries of the graph */
+      entries.append ( i );
+
+  if ( entries.size() == 0 )
+    entries.append ( g.defaultEntry() );
+
+  /* affect a layer id to each node according to its distance from the entry points */
+  for ( i=0; i!=N; ++i )
+    {
       distance = 0;
-      entries_iter.toFront ( );
 
-      while ( entries_iter.hasNext() )
+      foreach ( qint32 entry, entries )
         {
-          entry = entries_iter.next ( );
+          const quint32 d = m[entry*S + i];
 
-          if ( m[entry->tag][n->tag] != LIMIT )
+          if ( d != LIMIT )
             {
-              if ( m[entry->tag][n->tag] > distance )
-                distance = m[entry->tag][n->tag];
+              if ( d > distance )
+                distance = d;
             }
         }
 
-      n->grid_y = distance;
+      g.y[i] = distance;
     }
 
   /* we move the entry points just above their nearest child */
-  entries_iter.toFront ( );
-
-  while ( entries_iter.hasNext() )
+  foreach ( qint32 entry, entries )
     {
-      entry = entries_iter.next ( );
+      const qint32 *children = g.children ( entry );
+      const qint32 nbChildren = g.nbChildren ( entry );
+      bool found = false;
 
-      iter = QListIterator<Node *> ( entry->children );
-      n = NULL;
       k = LIMIT;
 
-      while ( iter.hasNext() )
+      for ( j=0; j!=nbChildren; ++j )
         {
-          child = iter.next ( );
+          child = children[j];
 
-          if ( child->grid_y == 0 )
+          if ( g.y[child] == 0 )
             continue;
 
-          if ( child->grid_y < k )
+          if ( g.y[child] < k )
             {
-              k = child->grid_y;
-              n = child;
+              k = g.y[child];
+              found = true;
             }
         }
 
-      if ( n != NULL )
-        entry->grid_y = k - 1;
+      if ( found )
+        g.y[entry] = k - 1;
     }
 
   /* free memory */
-  for ( i=0; i<N; ++i )
-    delete m[i];
-
-  delete m;
+  freeDistanceMatrix ( m );
 }
@@ -29,12 +29,18 @@
 
 #include <QtCore>
 #include "node.h"
+#include "graph-csr.h"
 
 
 class LayeringFloyd
 {
  public:
   static void applyToNodes ( QList<Node *> & );
+  static void applyToCsr ( GraphCsr & );
+
+  static quint32 *buildDistanceMatrix ( const GraphCsr &, quint32 * ); /* all-pairs distances, row stride returned */
+  static void freeDistanceMatrix ( quint32 * );
+  static quint32 unreachable ( );
 
 } ;
 
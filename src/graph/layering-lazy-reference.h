@@ -0,0 +1,219 @@
+/*
+ * layering-lazy-reference.h
+ *
+ * The lazy layering algorithm as it was before its conflicts were
+ * resolved layer by layer, kept to check the new one in layering-test.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __LAYERING_LAZY_REFERENCE_H__
+#define __LAYERING_LAZY_REFERENCE_H__
+
+#include "node.h"
+
+
+/*
+ * Internal structure used to store a conflict.
+ */
+typedef struct st_reference_conflict
+{
+  Node *n;                /* parent node which has children at the same level */
+  QList<Node *> cnodes;   /* conflicting children */
+  int nb;                 /* number of conflicting children */
+
+} ReferenceConflict ;
+
+
+/*
+ * Helper function which tells if a node is the head of a conflict in a conflicts list.
+ */
+static inline bool
+reference_contains_conflict_where_parent_is ( const QList<ReferenceConflict *> conflicts,
+                                              const Node *node )
+{
+  foreach ( ReferenceConflict *c, conflicts )
+    if ( c->n == node )
+      return true;
+
+  return false;
+}
+
+
+/*
+ * Move a node to the sublayer.
+ * If the node is the head of a conflict, then its conflicting children are moved too.
+ */
+static void
+reference_move_node_in_sublayer ( const unsigned int l_idx,
+                                  QList<QList<Node *> > &layers,
+                                  Node *node,
+                                  QMap<int, ReferenceConflict *> &conflicts,
+                                  QList<ReferenceConflict *> candidates )
+{
+  qlist_remove ( layers[l_idx], node );
+  node->grid_y = l_idx + 1;
+  layers[l_idx+1].append ( node );
+
+  foreach ( ReferenceConflict *c, conflicts ) /* search the node in the conflicts, so we can move its children */
+    {
+      if ( c->n == node )
+        {
+          foreach ( Node *child, c->cnodes )
+            if ( ( child->grid_y != (l_idx+1) ) &&
+                 ( !reference_contains_conflict_where_parent_is(candidates,child) ) )
+              reference_move_node_in_sublayer ( l_idx, layers, child, conflicts, candidates );
+
+          break;
+        }
+    }
+}
+
+
+/*
+ * Apply the previous lazy layering algorithm to a list of layers:
+ * resolve the best conflict of the first layer having one, then
+ * restart from the top. A child which a recursive move already moved
+ * down is not moved again (it used to be appended twice to its layer).
+ */
+static void
+reference_lazy_layers ( QList<QList<Node *> > &layers )
+{
+  bool moved;
+  int i;
+  int valid = 0;
+
+  do
+    {
+      moved = false;
+
+      for ( i=valid; i<layers.size(); ++i )
+        {
+          QMap<int, ReferenceConflict *> conflicts;
+          ReferenceConflict *conflict;
+          QList<ReferenceConflict *> candidates;
+          int nb_conflicts;
+
+          /* for each node of the layer, look for children which are in the same layer */
+          foreach ( Node *n, layers[i] )
+            {
+              conflict = new ReferenceConflict;
+              conflict->n = n;
+              nb_conflicts = 0;
+
+              foreach ( Node *child, n->children )
+                if ( child->grid_y == (unsigned int) i )
+                  {
+                    conflict->cnodes.append ( child );
+                    --nb_conflicts; /* we decrement so the keys in the conflicts map have descendant order */
+                  }
+
+              if ( nb_conflicts == 0 )
+                delete conflict;
+              else
+                {
+                  conflict->nb = nb_conflicts;
+                  conflicts.insertMulti ( nb_conflicts, conflict );
+                }
+            }
+
+          if ( conflicts.size() == 0 )
+            {
+              valid = i+1;
+              continue;
+            }
+
+          /* only the best conflicts with a parent in the upper layer interest us */
+          if ( i != 0 )
+            {
+              QList<Node *> valids;
+
+              foreach ( Node *parent, layers[i-1] )
+                valids << parent->children;
+
+              foreach ( ReferenceConflict *c, conflicts.values(conflicts.begin().value()->nb) )
+                if ( valids.contains(c->n) )
+                  candidates.append ( c );
+            }
+
+          /* default choice if we could not find a satisfying candidate */
+          if ( candidates.size() == 0 )
+            candidates.append ( conflicts.begin().value() );
+
+          /* allocate a new layer if needed */
+          if ( (i+1) >= layers.size() )
+            layers.append ( QList<Node *> ( ) );
+
+          /* move the nodes down */
+          foreach ( Node *n, candidates.at(0)->cnodes )
+            if ( n->grid_y == (unsigned int) i )
+              reference_move_node_in_sublayer ( i, layers, n, conflicts, candidates );
+
+          foreach ( ReferenceConflict *c, conflicts )
+            delete c;
+
+          /* restart from top */
+          moved = true;
+          break;
+        }
+    }
+  while ( moved ) ;
+}
+
+
+/*
+ * Layer a list of nodes using the previous lazy layering algorithm.
+ */
+static void
+reference_lazy_layering ( QList<Node *> &nodes )
+{
+  QList<QList<Node *> > layers;
+  int i, j;
+
+  /* build layers list */
+  layers.append ( QList<Node *> ( ) );
+
+  foreach ( Node *n, nodes )
+    {
+      while ( (int)n->grid_y >= layers.size() )
+        layers.append ( QList<Node *> ( ) );
+
+      layers[n->grid_y].append ( n );
+    }
+
+  reference_lazy_layers ( layers );
+
+  /* remove the empty layers */
+  for ( i=0; i<layers.size(); ++i )
+    {
+      if ( layers.at(i).size() == 0 )
+        {
+          layers.removeAt ( i );
+
+          for ( j=i; j<layers.size(); ++j )
+            foreach ( Node *n, layers.at(j) )
+              --n->grid_y;
+
+          --i;
+        }
+    }
+}
+
+
+#endif
@@ -31,6 +31,30 @@
  * This layering algorithm moves nodes that are at the same level
  * as their parents to a deeper layer.
  *
+ * The layers are handled from the top. In a layer, the parent with
+ * the most children in the same layer is chosen first (preferring a
+ * parent that has a parent in the layer above, then the last one in
+ * the layer); its conflicting children move one layer down, and so do
+ * the conflicting children of those which were themselves parents,
+ * except the other best parents. This goes on until the layer has no
+ * conflict left.
+ *
+ * Nodes only ever move from the current layer to the next one, so
+ * the layers above stay valid. The conflicts of the current layer are
+ * counted once, then kept up to date as nodes leave it: the parents
+ * are held in a heap ordered by (conflicts, parent above, position),
+ * which holds an entry for each count a parent went through. Within
+ * a layer, each conflict is thus processed once, in O((N+E) log E).
+ *
+ * That bound is per layer, not overall: each layer is counted again
+ * when it is resolved, and a node pushed down k layers is scanned
+ * again, with its edges, in each of them. With L layers, this gives
+ * O(L.(N+E) log E) in the worst case, e.g. a chain of nodes all
+ * starting in the same layer.
+ *
+ * Only the nodes of the layers are considered, and self loops are
+ * not conflicts.
+ *
  */
 
 
@@ -38,255 +62,300 @@
 
 
 /*
- * Internal structure used to store a conflict.
+ * Internal structure holding the state of the layering.
  */
-typedef struct st_conflict
+typedef struct st_lazy_state
 {
-  Node *n;                /* parent node which has children at the same level */
-  QList<Node *> cnodes;   /* conflicting children */
-  int nb;                 /* number of conflicting children */
+  Node **nodes;       /* tag -> node */
+  qint32 nbNodes;
+  qint32 *count;      /* children in the same layer, frozen while a conflict is resolved */
+  qint32 *pos;        /* position in its layer */
+  bool *upper;        /* has a parent in the layer above */
 
-} Conflict ;
+  quint64 *heap;      /* (count, upper, pos) of the parents of the current layer */
+  qint32 heapSize;
 
+} LazyState ;
 
 
 /*
- * Helper function which tells if a node is the head of a conflict in a conflicts list.
+ * Whether a node is one of the nodes being layered.
  */
 static inline bool
-contains_conflict_where_parent_is ( const QList<Conflict *> conflicts,
-                                    const Node *node )
+is_layered ( const LazyState &s,
+             const Node *n )
 {
-  bool ret = false;
+  return ( ( n->tag < (quint32) s.nbNodes ) && ( s.nodes[n->tag] == n ) );
+}
 
-  foreach ( Conflict *c, conflicts )
-    {
-      if ( c->n == node )
-        {
-          ret = true;
-          break;
-        }
-    }
 
-  return ret;
+/*
+ * Whether a node is in a given layer.
+ */
+static inline bool
+is_in_layer ( const LazyState &s,
+              const Node *n,
+              const unsigned int l )
+{
+  return ( ( n->grid_y == l ) && is_layered(s,n) );
 }
 
 
 /*
- * Move a node to the sublayer.
- * If the node is the head of a conflict, then its conflicting children are moved too.
+ * Heap key of a parent: conflicts first, then parent above, then position.
  */
-static void
-move_node_in_sublayer ( const unsigned int l_idx,
-                        QList<QList<Node *> > &layers,
-                        Node *node,
-                        QMap<int, Conflict *> &conflicts,
-                        QList<Conflict *> candidates )
+static inline quint64
+key_of ( const LazyState &s,
+         const qint32 t )
 {
-  qlist_remove ( layers[l_idx], node );
-  node->grid_y = l_idx + 1;
-  layers[l_idx+1].append ( node );
+  return ( ((quint64) s.count[t]) << 33 ) | ( ((quint64) s.upper[t]) << 32 ) | (quint64) s.pos[t];
+}
 
-#if DEBUG_LAYERING_LEVEL >= 2
-  std::cout << "moving node \'" << qPrintable(node->id) << "\' to layer " << (l_idx+1) << std::endl;
-#endif
 
-  foreach ( Conflict *c, conflicts ) /* search the node in the conflicts, so we can move its children */
+/*
+ * Push a key in the heap.
+ */
+static inline void
+heap_push ( LazyState &s,
+            const quint64 key )
+{
+  qint32 i = s.heapSize++;
+
+  while ( i > 0 )
     {
-      if ( c->n == node )
-        {
-#if DEBUG_LAYERING_LEVEL >= 2
-          std::cout << "found one conflict related to \'" << qPrintable(node->id) << "\'\n";
-#endif
+      const qint32 up = ( i - 1 ) / 2;
 
-          foreach ( Node *child, c->cnodes )
-            {
-              if ( ( child->grid_y != (l_idx+1) ) &&
-                   ( !contains_conflict_where_parent_is(candidates,child) ) )
-                move_node_in_sublayer ( l_idx, layers, child, conflicts, candidates );
-              else
-                {
-#if DEBUG_LAYERING_LEVEL >= 2
-                  std::cout << "NOT moving subnode \'" << qPrintable(child->id) << "\' to layer " << (l_idx+1) << std::endl;
-                  std::cout << "test layer said " << ( child->grid_y != (l_idx+1) ) << " and contains said " << ( !contains_conflict_where_parent_is(candidates,child) ) << std::endl;
-#endif
-                }
-            }
+      if ( s.heap[up] >= key )
+        break;
 
-          break;
-        }
+      s.heap[i] = s.heap[up];
+      i = up;
     }
+
+  s.heap[i] = key;
 }
 
 
 /*
- * Return the first conflict of a not empty conflicts map.
+ * Remove the greatest key of the heap.
  */
-static inline Conflict *
-get_first_conflict ( QMap<int, Conflict *> &conflicts )
+static inline void
+heap_pop ( LazyState &s )
 {
-  QMapIterator<int, Conflict *> iter ( conflicts );
-  Conflict *ret = NULL;
+  const quint64 key = s.heap[--s.heapSize];
+  qint32 i = 0;
+  qint32 child;
 
-  if ( iter.hasNext() )
+  while ( ( child = 2*i + 1 ) < s.heapSize )
     {
-      iter.next ( );
-      ret = iter.value ( );
+      if ( ( child+1 < s.heapSize ) && ( s.heap[child+1] > s.heap[child] ) )
+        ++child;
+
+      if ( key >= s.heap[child] )
+        break;
+
+      s.heap[i] = s.heap[child];
+      i = child;
     }
 
-  return ret;
+  s.heap[i] = key;
 }
 
 
 /*
- * Apply the lazy layering algorithm to a list of layers.
+ * Move a node to the next layer.
  */
-void
-LayeringLazy::applyToLayers ( QList<QList<Node *> > &layers )
+static inline void
+move_node_in_sublayer ( const unsigned int l_idx,
+                        QList<QList<Node *> > &layers,
+                        Node *node,
+                        QList<Node *> &moved )
 {
-  bool moved;
-  int i;
-  int valid = 0;
+  node->grid_y = l_idx + 1;
+  layers[l_idx+1].append ( node );
+  moved.append ( node );
+
+#if DEBUG_LAYERING_LEVEL >= 2
+  std::cout << "moving node \'" << qPrintable(node->id) << "\' to layer " << (l_idx+1) << std::endl;
+#endif
+}
+
+
+/*
+ * Resolve the conflicts of a layer. The next layer must exist.
+ */
+static void
+resolve_layer ( const unsigned int l_idx,
+                QList<QList<Node *> > &layers,
+                LazyState &s )
+{
+  QList<Node *> &layer = layers[l_idx];
+  QList<Node *> moved;
+  QList<QPair<Node *,int> > stack;
+  qint32 i, t, best;
+  quint64 key;
+  bool bestAbove;
+
+  /* count the conflicts once */
+  s.heapSize = 0;
 
-  do
+  for ( i=0; i<layer.size(); ++i )
     {
-      moved = false;
+      Node *n = layer[i];
 
-      for ( i=valid; i<layers.size(); ++i )
-        {
-          QMap<int, Conflict *> conflicts;
-          Conflict *conflict;
-          QList<Conflict *> candidates;
-          int nb_conflicts;
+      t = n->tag;
+      s.pos[t] = i;
+      s.count[t] = 0;
+      s.upper[t] = false;
 
-#if DEBUG_LAYERING_LEVEL >= 1
-          std::cout << "\n --- Layer " << i << " (" << layers[i].size() << " nodes) ---\n";
-#endif
+      foreach ( Node *child, n->children )
+        if ( ( child != n ) && is_in_layer(s,child,l_idx) )
+          ++s.count[t];
 
-          /* for each node of the layer, look for children which are in the same layer */
-          foreach ( Node *n, layers[i] )
+      if ( l_idx != 0 )
+        foreach ( Node *parent, n->parents )
+          if ( is_in_layer(s,parent,l_idx-1) )
             {
-              conflict = new Conflict;
-              conflict->n = n;
-              nb_conflicts = 0;
-
-              foreach ( Node *child, n->children )
-                {
-                  if ( child->grid_y == (unsigned int) i )
-                    {
-                      conflict->cnodes.append ( child );
-                      --nb_conflicts; /* we decrement so the keys in the conflicts map have descendant order */
-#if DEBUG_LAYERING_LEVEL >= 2
-                      std::cout << "conflict found between \'" << qPrintable(n->id) << "\' and \'" << qPrintable(child->id) << "\'\n";
-#endif
-                    }
-                }
-
-              if ( nb_conflicts == 0 )
-                delete conflict;
-              else
-                {
-                  conflict->nb = nb_conflicts;
-                  conflicts.insertMulti ( nb_conflicts, conflict );
-                }
+              s.upper[t] = true;
+              break;
             }
 
-          /* if there is any conflict, we must move some nodes down */
-          if ( conflicts.size() != 0 )
-            {
-              if ( i != 0 )
-                {
-                  QList<Node *> valids;
-
-                  /* only the nodes with a parent in the upper-layer interest us */
-                  foreach ( Node *parent, layers[i-1] )
-                    valids << parent->children;
-
-                  foreach ( Conflict *c, conflicts.values(get_first_conflict(conflicts)->nb) ) /* best conflicts which are valid */
-                    {
-                      if ( valids.contains(c->n) )
-                        candidates.append ( c );
-                    }
-                }
-              else
-                {
-                  candidates.append ( get_first_conflict(conflicts) );
-#if DEBUG_LAYERING_LEVEL >= 1
-                  std::cout << "no best choice (layer 0)" << std::endl;
-#endif
-                }
+      if ( s.count[t] != 0 )
+        heap_push ( s, key_of(s,t) );
+    }
+
+  while ( s.heapSize != 0 )
+    {
+      /* best parent still in the layer, outdated keys are dropped */
+      key = s.heap[0];
+      heap_pop ( s );
+
+      Node *chosen = layer[(qint32) (key & 0xFFFFFFFF)];
+      t = chosen->tag;
+
+      if ( ( chosen->grid_y != l_idx ) || ( key != key_of(s,t) ) )
+        continue;
+
+      best = s.count[t];
+      bestAbove = s.upper[t];
 
-              /* default choice if we could not find a satisfying candidate */
-              if ( candidates.size() == 0 )
-                {
-#if DEBUG_LAYERING_LEVEL >= 1
-                  std::cout << "no best choice (" << conflicts.size() << " conflicts)" << std::endl;
-                  std::cout << "will resolve conflict of node \'" << qPrintable(get_first_conflict(conflicts)->n->id) << "\'\n";
-#endif
-                  candidates.append ( get_first_conflict(conflicts) );
-                }
 #if DEBUG_LAYERING_LEVEL >= 1
-              else
-                std::cout << "found " << candidates.size() << " interesting conflicts" << std::endl;
+      std::cout << "will resolve conflict of node \'" << qPrintable(chosen->id) << "\' (" << best << " children)\n";
 #endif
 
-              /* allocate a new layer if needed */
-              if ( (i+1) >= layers.size() )
-                layers.append ( QList<Node *> ( ) );
-
-              /* move the nodes down */
-              if ( candidates.size() != 0 )
-                {
-                  Conflict *c = candidates.at ( 0 );
-                  foreach ( Node *n, c->cnodes )
-                    move_node_in_sublayer ( i, layers, n, conflicts, candidates );
-                }
-
-              /* free allocated Conflict structures */
-              QMapIterator<int, Conflict *> iter ( conflicts );
-
-              while ( iter.hasNext() )
-                {
-                  iter.next ( );
-                  delete iter.value();
-                }
-
-              /* restart from top */
-              moved = true;
-              break;
+      /* move the conflicting children, then theirs, except the other best parents */
+      moved.clear ( );
+      stack.clear ( );
+      stack.append ( qMakePair(chosen,0) );
+
+      while ( !stack.isEmpty() )
+        {
+          QPair<Node *,int> &top = stack.last ( );
+          Node *n = top.first;
+
+          if ( top.second == n->children.size() )
+            {
+              stack.removeLast ( );
+              continue;
             }
-          else
+
+          Node *child = n->children[top.second++];
+
+          if ( ( child == n ) || !is_in_layer(s,child,l_idx) )
+            continue;
+
+          if ( n != chosen )
             {
-              valid = i+1;
-#if DEBUG_LAYERING_LEVEL >= 1
-              std::cout << "no more conflicts in layer " << i << std::endl;
-#endif
+              const qint32 c = child->tag;
+
+              if ( ( s.count[c] == best ) && ( ( child == chosen ) || ( bestAbove && s.upper[c] ) ) )
+                continue;
             }
+
+          move_node_in_sublayer ( l_idx, layers, child, moved );
+
+          if ( s.count[child->tag] != 0 )
+            stack.append ( qMakePair(child,0) );
         }
+
+      /* the parents left in the layer lose these children */
+      foreach ( Node *n, moved )
+        foreach ( Node *parent, n->parents )
+          if ( ( parent != n ) && is_in_layer(s,parent,l_idx) )
+            {
+              t = parent->tag;
+
+              if ( --s.count[t] != 0 )
+                heap_push ( s, key_of(s,t) );
+            }
     }
-  while ( moved ) ;
+
+  /* drop the nodes which moved down */
+  QList<Node *> kept;
+
+  kept.reserve ( layer.size() );
+
+  foreach ( Node *n, layer )
+    if ( n->grid_y == l_idx )
+      kept.append ( n );
+
+  layer = kept;
 }
 
 
 /*
- * Remove a layer from the layers list.
+ * Apply the lazy layering algorithm to a list of layers.
  */
-static void
-removeLayer ( QList<QList<Node *> > &layers,
-              const int idx )
+void
+LayeringLazy::applyToLayers ( QList<QList<Node *> > &layers )
 {
-  int i;
-  QList<Node *> l;
+  LazyState s;
+  qint32 i, nbEdges;
+
+  /* tag the nodes */
+  s.nbNodes = 0;
+  nbEdges = 0;
+
+  for ( i=0; i<layers.size(); ++i )
+    s.nbNodes += layers[i].size ( );
 
-  layers.removeAt ( idx );
+  s.nodes = new Node * [ s.nbNodes + 1 ];
+  s.count = new qint32 [ s.nbNodes + 1 ];
+  s.pos = new qint32 [ s.nbNodes + 1 ];
+  s.upper = new bool [ s.nbNodes + 1 ];
+  s.nbNodes = 0;
 
-  for ( i=idx; i<layers.size(); ++i )
+  for ( i=0; i<layers.size(); ++i )
+    foreach ( Node *n, layers[i] )
+      {
+        n->tag = s.nbNodes;
+        s.nodes[s.nbNodes++] = n;
+        nbEdges += n->children.size ( );
+      }
+
+  /* a parent has an entry per count it goes through */
+  s.heap = new quint64 [ s.nbNodes + nbEdges + 1 ];
+
+  for ( i=0; i<layers.size(); ++i )
     {
-      l = layers.at ( i );
+      if ( (i+1) == layers.size() )
+        layers.append ( QList<Node *> ( ) );
+
+      resolve_layer ( i, layers, s );
 
-      foreach ( Node *n, l )
-        --n->grid_y;
+      if ( ( (i+2) == layers.size() ) && layers[i+1].isEmpty() )
+        {
+          layers.removeLast ( );
+          break;
+        }
     }
+
+  /* free memory */
+  delete [] s.nodes;
+  delete [] s.count;
+  delete [] s.pos;
+  delete [] s.upper;
+  delete [] s.heap;
 }
 
 
@@ -297,7 +366,7 @@ void
 LayeringLazy::applyToNodes ( QList<Node *> &nodes )
 {
   QList<QList<Node *> > layers;
-  int i;
+  int i, l;
 
   /* build layers list */
   layers.append ( QList<Node *> ( ) );
@@ -313,13 +382,17 @@ LayeringLazy::applyToNodes ( QList<Node *> &nodes )
   /* layering */
   applyToLayers ( layers );
 
-  /* correct invalid layers */
+  /* remove the empty layers */
+  l = 0;
+
   for ( i=0; i<layers.size(); ++i )
     {
       if ( layers.at(i).size() == 0 )
-        {
-          removeLayer ( layers, i );
-          --i;
-        }
+        continue;
+
+      foreach ( Node *n, layers.at(i) )
+        n->grid_y = l;
+
+      ++l;
     }
 }
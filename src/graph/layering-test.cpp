@@ -0,0 +1,341 @@
+/*
+ * layering-test.cpp
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+#include "graph.h"
+#include "layering-floyd.h"
+#include "layering-bfs.h"
+#include "layering-lazy.h"
+#include "layering-lazy-reference.h"
+#include "graph-csr.h"
+#include "scc-condensation.h"
+#include "synthetic-graph.h"
+
+
+/*
+ * Run both layering algorithms on a graph and compare their results.
+ * Returns true if the layers are identical.
+ */
+static bool
+compare_layerings ( Graph *g,
+                    const char *name )
+{
+  struct timeval start, end;
+  QList<Node *> nodes_list;
+  QList<quint32> floyd_y;
+  double t_floyd, t_bfs;
+  int i, nb_diff = 0;
+
+  g->feedListWithActiveNodes ( nodes_list );
+
+  gettimeofday ( &start, NULL );
+  LayeringFloyd::applyToNodes ( nodes_list );
+  gettimeofday ( &end, NULL );
+  t_floyd = ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+
+  foreach ( Node *n, nodes_list )
+    floyd_y.append ( n->grid_y );
+
+  gettimeofday ( &start, NULL );
+  LayeringBfs::applyToNodes ( nodes_list );
+  gettimeofday ( &end, NULL );
+  t_bfs = ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+
+  for ( i=0; i<nodes_list.size(); ++i )
+    {
+      if ( nodes_list[i]->grid_y != floyd_y[i] )
+        {
+          if ( nb_diff < 8 )
+            std::cout << "node \'" << qPrintable(nodes_list[i]->id) << "\' : floyd=" << floyd_y[i] << " bfs=" << nodes_list[i]->grid_y << "\n";
+
+          ++nb_diff;
+        }
+    }
+
+  std::cout << name << " (" << nodes_list.size() << " nodes, " << g->edges.size() << " edges)\n";
+  std::cout << "floyd -> " << t_floyd << "ms\n";
+  std::cout << "bfs   -> " << t_bfs << "ms\n";
+  std::cout << ((nb_diff == 0) ? "identical layers\n\n" : "LAYERS DIFFER\n\n");
+
+  return ( nb_diff == 0 );
+}
+
+
+/*
+ * Reverse the feedback edges of a graph, check that no cycle is left,
+ * then compare the layout time with and without the cycle removal.
+ * Returns true if the graph became acyclic.
+ */
+static bool
+check_acyclic ( Graph *g,
+                const char *name )
+{
+  struct timeval start, end;
+  QList<Node *> nodes_list;
+  double t_fas, t_layout[2];
+  int nb_reversed = 0;
+  bool acyclic;
+  int mode;
+
+  g->feedListWithActiveNodes ( nodes_list );
+
+  gettimeofday ( &start, NULL );
+  g->reverseFeedbackEdges ( );
+  gettimeofday ( &end, NULL );
+  t_fas = ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+
+  foreach ( Edge *e, g->edges )
+    if ( e->reversed )
+      ++nb_reversed;
+
+  {
+    GraphCsr csr ( nodes_list );
+    SccCondensation scc ( csr );
+
+    acyclic = ( scc.nbComponents() == csr.size() );
+  }
+
+  g->unReverseUpwardEdges ( );
+
+  g->setLayoutSeed ( 42 );
+  g->setIncrementalLayout ( false );
+
+  for ( mode=0; mode<2; ++mode )
+    {
+      g->setAcyclicMode ( (mode == 0) ? ACYCLIC_NONE : ACYCLIC_GREEDY );
+
+      gettimeofday ( &start, NULL );
+      g->assignGridCoordinates ( );
+      gettimeofday ( &end, NULL );
+      t_layout[mode] = ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+    }
+
+  std::cout << name << " (" << nodes_list.size() << " nodes, " << g->edges.size() << " edges)\n";
+  std::cout << "greedy cycle removal -> " << t_fas << "ms, " << nb_reversed << " edges reversed\n";
+  std::cout << "layout without       -> " << t_layout[0] << "ms\n";
+  std::cout << "layout with          -> " << t_layout[1] << "ms\n";
+  std::cout << (acyclic ? "acyclic\n\n" : "CYCLES LEFT\n\n");
+
+  return acyclic;
+}
+
+
+/*
+ * Put all the nodes of a graph in the first layer and let the lazy
+ * layering spread them. Returns true if no conflict is left.
+ */
+static bool
+bench_lazy ( Graph *g,
+             const char *name )
+{
+  struct timeval start, end;
+  QList<Node *> nodes_list;
+  quint32 nb_layers = 0;
+  int nb_conflicts = 0;
+  double t_lazy;
+
+  g->feedListWithActiveNodes ( nodes_list );
+
+  foreach ( Node *n, nodes_list )
+    n->grid_y = 0;
+
+  gettimeofday ( &start, NULL );
+  LayeringLazy::applyToNodes ( nodes_list );
+  gettimeofday ( &end, NULL );
+  t_lazy = ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+
+  foreach ( Node *n, nodes_list )
+    {
+      nb_layers = qMax ( nb_layers, n->grid_y+1 );
+
+      foreach ( Node *child, n->children )
+        if ( child->grid_y == n->grid_y )
+          ++nb_conflicts;
+    }
+
+  std::cout << name << " (" << nodes_list.size() << " nodes, " << g->edges.size() << " edges)\n";
+  std::cout << "lazy -> " << t_lazy << "ms, " << nb_layers << " layers\n";
+  std::cout << ((nb_conflicts == 0) ? "no conflict\n\n" : "CONFLICTS LEFT\n\n");
+
+  return ( nb_conflicts == 0 );
+}
+
+/*
+ * Run the lazy layering and the previous one from the same layers,
+ * the BFS ones or random ones within nb_layers (if not 0), and compare
+ * their results. The graphs have no self loop and all their nodes are
+ * layered, as the previous algorithm handled these cases differently.
+ * Returns true if the layers are identical.
+ */
+static bool
+compare_lazy_layerings ( Graph *g,
+                         const char *name,
+                         const int nb_layers )
+{
+  QList<Node *> nodes_list;
+  QList<quint32> initial_y, reference_y;
+  int i, nb_diff = 0;
+
+  g->feedListWithActiveNodes ( nodes_list );
+
+  if ( nb_layers == 0 )
+    LayeringBfs::applyToNodes ( nodes_list );
+  else
+    foreach ( Node *n, nodes_list )
+      n->grid_y = rand() % nb_layers;
+
+  foreach ( Node *n, nodes_list )
+    initial_y.append ( n->grid_y );
+
+  reference_lazy_layering ( nodes_list );
+
+  for ( i=0; i<nodes_list.size(); ++i )
+    {
+      reference_y.append ( nodes_list[i]->grid_y );
+      nodes_list[i]->grid_y = initial_y[i];
+    }
+
+  LayeringLazy::applyToNodes ( nodes_list );
+
+  for ( i=0; i<nodes_list.size(); ++i )
+    if ( nodes_list[i]->grid_y != reference_y[i] )
+      ++nb_diff;
+
+  std::cout << name << " (" << nodes_list.size() << " nodes, " << g->edges.size() << " edges, ";
+
+  if ( nb_layers == 0 )
+    std::cout << "bfs layers";
+  else
+    std::cout << nb_layers << " random layers";
+
+  std::cout << ") -> " << ( (nb_diff == 0) ? "same layers\n" : "LAYERS DIFFER\n" );
+
+  return ( nb_diff == 0 );
+}
+
+
+/*
+ * Compare the lazy layering with the previous one on synthetic graphs
+ * of up to nb_nodes nodes. Returns true if they always agree.
+ */
+static bool
+check_lazy_reference ( const int nb_nodes )
+{
+  int size, variant;
+  bool ret = true;
+
+  for ( size=5; size<=nb_nodes; size=size*3/2+1 )
+    {
+      for ( variant=0; variant<12; ++variant )
+        {
+          Graph *g = build_synthetic_graph ( size, 1+variant%3 );
+
+          srand ( variant*7919 + size );
+
+          if ( !compare_lazy_layerings(g,"synthetic",(variant < 4) ? 0 : 1+variant%5) )
+            ret = false;
+
+          delete g;
+        }
+
+      Graph *chain = build_synthetic_dag ( size, 1 );
+      Graph *dense = build_synthetic_dag ( size, 8 );
+
+      if ( !compare_lazy_layerings(chain,"deep chain",1) || !compare_lazy_layerings(dense,"dense dag",1) )
+        ret = false;
+
+      delete chain;
+      delete dense;
+    }
+
+  return ret;
+}
+
+
+
+int
+main ( int argc,
+       char *argv[] )
+{
+  int c;
+  int ret = 0;
+  bool acyclic = false;
+
+  std::cout << "\n";
+
+  /* synthetic graphs */
+  while ( ( c = getopt(argc, argv, "ad:m:s:") ) != -1 )
+    {
+      if ( c == 'a' )
+        acyclic = true;
+      else if ( c == 'd' )
+        {
+          Graph *chain = build_synthetic_dag ( atoi(optarg), 1 );
+          Graph *dense = build_synthetic_dag ( atoi(optarg), 8 );
+
+          if ( !bench_lazy(chain,"deep chain") || !bench_lazy(dense,"dense dag") )
+            ret = -1;
+
+          delete chain;
+          delete dense;
+        }
+      else if ( c == 'm' )
+        {
+          if ( !check_lazy_reference(atoi(optarg)) )
+            ret = -1;
+        }
+      else if ( c == 's' )
+        {
+          Graph *g = build_synthetic_graph ( atoi(optarg) );
+
+          if ( acyclic )
+            {
+              if ( !check_acyclic(g,"synthetic") )
+                ret = -1;
+            }
+          else if ( !compare_layerings(g,"synthetic") )
+            ret = -1;
+
+          delete g;
+        }
+    }
+
+  /* graph files */
+  for ( ; optind<argc; ++optind )
+    {
+      Graph *g = new Graph ( );
+
+      g->initFromFile ( argv[optind] );
+
+      if ( acyclic )
+        {
+          if ( !check_acyclic(g,argv[optind]) )
+            ret = -1;
+        }
+      else if ( !compare_layerings(g,argv[optind]) )
+        ret = -1;
+
+      delete g;
+    }
+
+  return ret;
+}
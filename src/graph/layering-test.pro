@@ -0,0 +1,17 @@
+
+TEMPLATE = app
+LANGUAGE = C++
+
+SRC_DIR = ..
+
+include ( ../parser/parser.pri )
+include ( graph.pri )
+
+SOURCES += layering-test.cpp
+
+TARGET = layering-test
+
+CONFIG += warn_on release
+
+#QMAKE_CXXFLAGS_DEBUG += -pg
+#QMAKE_LFLAGS_DEBUG += -pg
@@ -0,0 +1,445 @@
+/*
+ * layout-cache.cpp
+ *
+ * Implementation of the LayoutCache class.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "layout-cache.h"
+
+
+/*
+ * The layout cache
+ *
+ * A layout only depends on the nodes and edges of a graph, on which
+ * of them are active (the fold state: collapsed groups, traces and
+ * tag filters) and on the layout settings. The cache maps a hash of
+ * all this to the grid coordinates of the active nodes and the
+ * virtual points of the active edges.
+ *
+ * Nodes and edges are stored in the order of their IDs, so that the
+ * entries do not depend on the order in which the graph was loaded.
+ * The least recently used fold states are dropped when there are too
+ * many of them, or when they take too much memory. Within a session,
+ * this is what makes undoing an expand, a collapse or a tag filter
+ * immediate: the previous fold state is still known.
+ *
+ * By default, the cache is kept in memory only: nothing is written
+ * next to the user's files. When enabled, it is also loaded from and
+ * saved to a sidecar file, which is discarded as soon as the graph
+ * file does not describe the same nodes and edges any more.
+ */
+
+
+#define CACHE_MAGIC      0x4b4b4c43 /* KKLC */
+#define CACHE_VERSION    2
+#define CACHE_MAX_STATES 32
+#define CACHE_MAX_BYTES  (16*1024*1024)
+
+
+bool LayoutCache::enabled = false;
+
+
+/*
+ * Compare two nodes' ID.
+ */
+static bool
+compare_node_ids ( const Node *n1,
+                   const Node *n2 )
+{
+  return n1->id < n2->id;
+}
+
+
+/*
+ * Compare two edges' source, then destination IDs.
+ */
+static bool
+compare_edge_ends ( const Edge *e1,
+                    const Edge *e2 )
+{
+  if ( e1->src->id != e2->src->id )
+    return e1->src->id < e2->src->id;
+
+  return e1->dest->id < e2->dest->id;
+}
+
+
+/*
+ * Add a string to a hash, preceded by its length, so that
+ * the IDs hashed in a row can not be split another way.
+ */
+static void
+hash_field ( QCryptographicHash &hash,
+             const QString &s )
+{
+  const QByteArray utf8 = s.toUtf8 ( );
+  const quint32 length = utf8.size ( );
+
+  hash.addData ( (const char *) &length, sizeof(length) );
+  hash.addData ( utf8 );
+}
+
+
+/*
+ * Feed the lists with the active nodes and edges of a graph,
+ * in a stable order.
+ */
+static void
+sorted_active_elements ( const Graph *g,
+                         QList<Node *> &nodes,
+                         QList<Edge *> &edges )
+{
+  g->feedListWithActiveNodes ( nodes );
+  qSort ( nodes.begin(), nodes.end(), compare_node_ids );
+
+  edges.clear ( );
+
+  foreach ( Edge *e, g->edges )
+    if ( e->isActive() )
+      edges.append ( e );
+
+  qStableSort ( edges.begin(), edges.end(), compare_edge_ends );
+}
+
+
+/*
+ * Memory used by an entry.
+ */
+static quint32
+entry_bytes ( const QByteArray &key,
+              const QVector<quint32> &coords,
+              const QVector<qint32> &points )
+{
+  return key.size() + sizeof(quint32)*coords.size() + sizeof(qint32)*points.size();
+}
+
+
+/*
+ * Constructor
+ * Hash the nodes and edges of the graph and load the sidecar file,
+ * if any (an empty file name keeps the cache in memory only).
+ */
+LayoutCache::LayoutCache ( const QString &file,
+                           const Graph *g )
+  : file(file), bytes(0), dirty(false)
+{
+  QCryptographicHash hash ( QCryptographicHash::Sha1 );
+  QStringList ids;
+  QList<QPair<QString, QString> > ends;
+  QPair<QString, QString> p;
+
+  foreach ( Node *n, g->nodes )
+    ids.append ( n->id );
+
+  ids.sort ( );
+
+  foreach ( const QString &id, ids )
+    hash_field ( hash, id );
+
+  /* the source and destination IDs apart: IDs may contain the '-' of the KIds */
+  foreach ( Edge *e, g->edges )
+    ends.append ( qMakePair(e->src->id,e->dest->id) );
+
+  qSort ( ends.begin(), ends.end() );
+
+  foreach ( p, ends )
+    {
+      hash_field ( hash, p.first );
+      hash_field ( hash, p.second );
+    }
+
+  this->topology = hash.result ( );
+  this->load ( );
+}
+
+
+/*
+ * Name of the sidecar file of a graph file.
+ */
+QString
+LayoutCache::sidecarOf ( const QString &graphFile )
+{
+  return graphFile + QString::fromLatin1 ( ".layout" );
+}
+
+
+/*
+ * Key of the fold state of a graph: its active nodes, with the
+ * topology of the graph and the settings of the layout. An incremental
+ * layout depends on the previous one, so it is never taken for the
+ * full layout of the same fold state.
+ */
+QByteArray
+LayoutCache::keyOf ( const Graph *g ) const
+{
+  QCryptographicHash hash ( QCryptographicHash::Sha1 );
+  QList<Node *> nodes;
+  QByteArray settings;
+
+  g->feedListWithActiveNodes ( nodes );
+  qSort ( nodes.begin(), nodes.end(), compare_node_ids );
+
+  QDataStream stream ( &settings, QIODevice::WriteOnly );
+  stream << (qint32) g->getLayeringMode() << (qint32) g->getAcyclicMode() << g->isComponentLayout() << g->isSeededLayout() << g->getLayoutSeed()
+         << g->isIncrementalLayout();
+
+  hash.addData ( this->topology );
+  hash.addData ( settings );
+
+  foreach ( Node *n, nodes )
+    hash_field ( hash, n->id );
+
+  return hash.result ( );
+}
+
+
+/*
+ * Give the graph the layout of a fold state, if it is known.
+ * Returns false if it is not.
+ */
+bool
+LayoutCache::restore ( Graph *g,
+                       const QByteArray &key,
+                       QPair<quint32, quint32> &gridMax )
+{
+  QList<Node *> nodes;
+  QList<Edge *> edges;
+  QList<QMap<int, quint32> > points;
+  int i, j, k, nb;
+
+  if ( !this->entries.contains(key) )
+    return false;
+
+  const Entry &e = this->entries[key];
+
+  sorted_active_elements ( g, nodes, edges );
+
+  if ( e.coords.size() != 2*nodes.size() )
+    return false;
+
+  /* read the virtual points first, the entry might not match */
+  k = 0;
+
+  for ( i=0; i<edges.size(); ++i )
+    {
+      if ( k >= e.points.size() )
+        return false;
+
+      nb = e.points[k++];
+
+      if ( ( nb < 0 ) || ( k+2*nb > e.points.size() ) )
+        return false;
+
+      points.append ( QMap<int, quint32> ( ) );
+
+      for ( j=0; j<nb; ++j, k+=2 )
+        points.last().insert ( e.points[k], (quint32) e.points[k+1] );
+    }
+
+  if ( k != e.points.size() )
+    return false;
+
+  for ( i=0; i<nodes.size(); ++i )
+    {
+      nodes[i]->grid_x = e.coords[2*i];
+      nodes[i]->grid_y = e.coords[2*i+1];
+    }
+
+  for ( i=0; i<edges.size(); ++i )
+    edges[i]->virtualPoints = points[i];
+
+  gridMax = QPair<quint32, quint32> ( e.maxX, e.maxY );
+
+  /* the next incremental layout starts from this one */
+  ++g->layoutId;
+
+  foreach ( Node *n, nodes )
+    n->layout_id = g->layoutId;
+
+  g->lastLayoutTime = 0;
+  g->lastLayoutIncremental = false;
+  g->lastLayoutCancelled = false;
+
+  this->recent.removeOne ( key );
+  this->recent.append ( key );
+
+  return true;
+}
+
+
+/*
+ * Remember the current layout of a graph as the one of a fold state.
+ */
+void
+LayoutCache::store ( const Graph *g,
+                     const QByteArray &key,
+                     const QPair<quint32, quint32> &gridMax )
+{
+  QList<Node *> nodes;
+  QList<Edge *> edges;
+  Entry e;
+
+  sorted_active_elements ( g, nodes, edges );
+
+  e.maxX = gridMax.first;
+  e.maxY = gridMax.second;
+  e.coords.reserve ( 2*nodes.size() );
+
+  foreach ( Node *n, nodes )
+    {
+      e.coords.append ( n->grid_x );
+      e.coords.append ( n->grid_y );
+    }
+
+  foreach ( Edge *edge, edges )
+    {
+      e.points.append ( edge->virtualPoints.size() );
+
+      for ( QMap<int, quint32>::const_iterator iter=edge->virtualPoints.constBegin(); iter!=edge->virtualPoints.constEnd(); ++iter )
+        {
+          e.points.append ( iter.key() );
+          e.points.append ( (qint32) iter.value() );
+        }
+    }
+
+  this->forget ( key );
+  this->insert ( key, e );
+  this->dirty = true;
+}
+
+
+/*
+ * Add an entry as the most recently used one,
+ * dropping the least recently used ones to stay within bounds.
+ */
+void
+LayoutCache::insert ( const QByteArray &key,
+                      const Entry &e )
+{
+  this->entries.insert ( key, e );
+  this->recent.append ( key );
+  this->bytes += entry_bytes ( key, e.coords, e.points );
+
+  while ( ( this->recent.size() > CACHE_MAX_STATES ) ||
+          ( ( this->bytes > CACHE_MAX_BYTES ) && ( this->recent.size() > 1 ) ) )
+    this->forget ( this->recent.first() );
+}
+
+
+/*
+ * Drop an entry, if it is known.
+ */
+void
+LayoutCache::forget ( const QByteArray &key )
+{
+  if ( !this->entries.contains(key) )
+    return;
+
+  const Entry &e = this->entries[key];
+  this->bytes -= entry_bytes ( key, e.coords, e.points );
+
+  this->entries.remove ( key );
+  this->recent.removeOne ( key );
+}
+
+
+/*
+ * Read the sidecar file.
+ * A missing, damaged or outdated file is an empty cache.
+ */
+void
+LayoutCache::load ( )
+{
+  QFile f ( this->file );
+  QByteArray key, topo;
+  quint32 magic, version, nb, i;
+  Entry e;
+
+  if ( this->file.isEmpty() || !f.open(QIODevice::ReadOnly) )
+    return;
+
+  QDataStream stream ( &f );
+  stream.setVersion ( QDataStream::Qt_5_0 );
+
+  stream >> magic >> version >> topo >> nb;
+
+  if ( ( stream.status() != QDataStream::Ok ) || ( magic != CACHE_MAGIC ) ||
+       ( version != CACHE_VERSION ) || ( topo != this->topology ) )
+    return;
+
+  for ( i=0; ( i<nb ) && ( i<CACHE_MAX_STATES ); ++i )
+    {
+      stream >> key >> e.maxX >> e.maxY >> e.coords >> e.points;
+
+      if ( stream.status() != QDataStream::Ok )
+        {
+          this->entries.clear ( );
+          this->recent.clear ( );
+          this->bytes = 0;
+          return;
+        }
+
+      this->forget ( key );
+      this->insert ( key, e );
+    }
+}
+
+
+/*
+ * Write the sidecar file if there is one and anything changed.
+ * Returns false if it could not be written.
+ */
+bool
+LayoutCache::save ( )
+{
+  if ( !this->dirty || this->file.isEmpty() )
+    return true;
+
+  QSaveFile f ( this->file );
+
+  if ( !f.open(QIODevice::WriteOnly) )
+    return false;
+
+  QDataStream stream ( &f );
+  stream.setVersion ( QDataStream::Qt_5_0 );
+
+  stream << (quint32) CACHE_MAGIC << (quint32) CACHE_VERSION << this->topology << (quint32) this->recent.size();
+
+  foreach ( const QByteArray &key, this->recent )
+    {
+      const Entry &e = this->entries[key];
+      stream << key << e.maxX << e.maxY << e.coords << e.points;
+    }
+
+  if ( !f.commit() )
+    return false;
+
+  this->dirty = false;
+
+  return true;
+}
+
+
+/*
+ * Destructor
+ */
+LayoutCache::~LayoutCache ( )
+{
+}
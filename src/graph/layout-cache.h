@@ -0,0 +1,76 @@
+/*
+ * layout-cache.h
+ *
+ * Declaration of the LayoutCache class.
+ * It remembers the layouts of the fold states of a graph, in memory
+ * and optionally in a sidecar file, so that they do not have to be computed again.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __LAYOUT_CACHE_H__
+#define __LAYOUT_CACHE_H__
+
+#include <QtCore>
+#include "graph.h"
+
+
+class LayoutCache
+{
+ public:
+  LayoutCache ( const QString &, const Graph * ); /* sidecar file (empty for none), graph as loaded (loads the file) */
+  ~LayoutCache ( );
+
+  static QString sidecarOf ( const QString & );   /* sidecar file of a graph file */
+
+  QByteArray keyOf ( const Graph * ) const;       /* key of the current fold state of a graph */
+
+  bool restore ( Graph *, const QByteArray &, QPair<quint32, quint32> & );    /* apply a known layout */
+  void store ( const Graph *, const QByteArray &, const QPair<quint32, quint32> & ); /* remember a layout */
+
+  bool save ( );                                  /* write the sidecar file if anything changed */
+
+  static bool enabled;                            /* use sidecar files for the graphs opened from now on (off by default) */
+
+ private:
+  void load ( );
+
+  class Entry
+  {
+   public:
+    quint32 maxX;
+    quint32 maxY;
+    QVector<quint32> coords;   /* grid_x and grid_y of the active nodes, sorted by ID */
+    QVector<qint32> points;    /* for each active edge (sorted by source, then destination ID): count, then (key, x) pairs */
+  } ;
+
+  void insert ( const QByteArray &, const Entry & );
+  void forget ( const QByteArray & );
+
+  QString file;
+  QByteArray topology;         /* hash of the nodes and edges of the graph */
+  QHash<QByteArray, Entry> entries;
+  QList<QByteArray> recent;    /* keys of the entries, least recently used first */
+  quint32 bytes;               /* memory used by the entries */
+  bool dirty;
+
+} ;
+
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * layout-job.cpp
+ *
+ * Implementation of the LayoutJob class.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "layout-job.h"
+
+
+/*
+ * Constructor
+ * Copy the topology of the active nodes and edges, with what the
+ * incremental layout needs to know about the previous layout.
+ */
+LayoutJob::LayoutJob ( Graph *g )
+  : cancelled ( 0 ), gridMax ( 0, 0 )
+{
+  QHash<Node *, Node *> copyOf;
+  Node *ncopy;
+  Edge *ecopy;
+  int i;
+
+  this->graph = g;
+  this->snapshot = new Graph ( );
+  this->snapshot->layeringMode = g->layeringMode;
+  this->snapshot->acyclicMode = g->acyclicMode;
+  this->snapshot->incrementalLayout = g->incrementalLayout;
+  this->snapshot->parallelLayout = g->parallelLayout;
+  this->snapshot->componentLayout = g->componentLayout;
+  this->snapshot->seededLayout = g->seededLayout;
+  this->snapshot->layoutSeed = g->layoutSeed;
+  this->snapshot->layoutId = g->layoutId;
+  this->snapshot->setCancelFlag ( &this->cancelled );
+
+  /* nodes */
+  g->feedListWithActiveNodes ( this->nodes );
+
+  foreach ( Node *n, this->nodes )
+    {
+      ncopy = new Node ( this->snapshot );
+      ncopy->id = n->id;
+      ncopy->n_id = n->n_id; /* the layering picks its default entry with it */
+      ncopy->grid_x = n->grid_x;
+      ncopy->grid_y = n->grid_y;
+      ncopy->subgraph_id = n->subgraph_id;
+      ncopy->scc_id = n->scc_id;
+      ncopy->layout_id = n->layout_id;
+      this->snapshot->addNode ( ncopy );
+      this->copies.append ( ncopy );
+      copyOf.insert ( n, ncopy );
+    }
+
+  this->snapshot->n_id_counter = g->n_id_counter; /* virtual nodes ids must not clash */
+
+  /* children, in the same order */
+  for ( i=0; i<this->nodes.size(); ++i )
+    {
+      foreach ( Node *child, this->nodes[i]->children )
+        {
+          if ( copyOf.contains(child) )
+            this->copies[i]->addChild ( copyOf.value(child) );
+        }
+    }
+
+  /* edges */
+  foreach ( Edge *e, g->edges )
+    {
+      if ( !e->isActive() )
+        continue;
+
+      if ( !copyOf.contains(e->src) || !copyOf.contains(e->dest) )
+        continue;
+
+      ecopy = new Edge ( copyOf.value(e->src), copyOf.value(e->dest) );
+      ecopy->virtualPoints = e->virtualPoints;
+      this->snapshot->addEdge ( ecopy );
+      this->edges.append ( e );
+      this->edgeCopies.append ( ecopy );
+    }
+}
+
+
+/*
+ * Lay the snapshot out.
+ * Only the snapshot is touched, the graph may be used meanwhile.
+ */
+void
+LayoutJob::run ( )
+{
+  if ( this->isCancelled() )
+    return;
+
+  this->gridMax = this->snapshot->assignGridCoordinates ( );
+}
+
+
+/*
+ * Copy the grid coordinates of the snapshot back to the graph.
+ * Returns false if the job was cancelled (the graph is unchanged).
+ */
+bool
+LayoutJob::apply ( )
+{
+  int i;
+
+  if ( this->isCancelled() || this->snapshot->wasLastLayoutCancelled() )
+    return false;
+
+  for ( i=0; i<this->nodes.size(); ++i )
+    {
+      this->nodes[i]->grid_x = this->copies[i]->grid_x;
+      this->nodes[i]->grid_y = this->copies[i]->grid_y;
+      this->nodes[i]->layout_id = this->copies[i]->layout_id;
+    }
+
+  for ( i=0; i<this->edges.size(); ++i )
+    this->edges[i]->virtualPoints = this->edgeCopies[i]->virtualPoints;
+
+  this->graph->layoutId = this->snapshot->layoutId;
+  this->graph->lastLayoutTime = this->snapshot->lastLayoutTime;
+  this->graph->lastLayoutIncremental = this->snapshot->lastLayoutIncremental;
+  this->graph->lastLayoutCancelled = false;
+
+  return true;
+}
+
+
+/*
+ * Destructor
+ */
+LayoutJob::~LayoutJob ( )
+{
+  delete this->snapshot;
+}
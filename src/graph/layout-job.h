@@ -0,0 +1,63 @@
+/*
+ * layout-job.h
+ *
+ * Declaration of the LayoutJob class.
+ * It lays out a snapshot of a graph, so that the layout can run
+ * on a worker thread while the graph itself keeps being used.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __LAYOUT_JOB_H__
+#define __LAYOUT_JOB_H__
+
+#include <QtCore>
+#include "graph.h"
+
+
+class LayoutJob
+{
+ public:
+  LayoutJob ( Graph * );  /* snapshot the active part of a graph (caller's thread) */
+  ~LayoutJob ( );
+
+  void run ( );           /* lay the snapshot out (any thread) */
+  bool apply ( );         /* copy the result back to the graph (caller's thread) */
+
+  inline void cancel ( ) { cancelled.storeRelease ( 1 ); }                      /* a newer layout supersedes this one */
+  inline bool isCancelled ( ) const { return ( cancelled.loadAcquire() != 0 ); }
+
+  inline QPair<quint32, quint32> getGridMax ( ) const { return gridMax; }
+
+ private:
+  Graph *graph;           /* the graph to lay out */
+  Graph *snapshot;        /* its active nodes and edges */
+
+  QList<Node *> nodes;    /* nodes of the graph ... */
+  QList<Node *> copies;   /* ... and their copy in the snapshot */
+  QList<Edge *> edges;
+  QList<Edge *> edgeCopies;
+
+  QAtomicInt cancelled;
+  QPair<quint32, quint32> gridMax;
+
+} ;
+
+
+#endif
@@ -41,7 +41,12 @@ Node::Node ( Graph *g,
   this->grid_y = 0;
   this->grid_x = 0;
   this->subgraph_id = 0;
+  this->scc_id = 0;
   this->nbChildren = 0;
+  this->layout_id = 0;
+  this->prev_grid_x = 0;
+  this->prev_grid_y = 0;
+  this->dirty = true;
 }
 
 
@@ -55,19 +60,24 @@ Node::initFromEntity ( const Entity *e )
   Attribute *a;
 
   /* load ID */
-  attr_v = e->getValueOfAttribute ( ATTR_NODE_ID );
+  attr_v = e->getValueOfAttribute ( NAME_NODE_ID );
 
   if ( attr_v != NULL )
     this->id = attr_v; /* NOTE: we do not check for duplicate IDs */
 
   /* load tags */
-  a = e->getAttribute ( ATTR_NODE_TAGS );
+  a = e->getAttribute ( NAME_NODE_TAGS );
 
   if ( a != NULL )
     {
-      QStringList *sl = a->getValueAsListOfString ( );
-      this->tags = QStringList ( *sl );
-      delete sl;
+      const AttributeStrings sl = a->getValueAsListOfString ( );
+      unsigned int i;
+
+      this->tags.clear ( );
+      this->tags.reserve ( sl.size() );
+
+      for ( i=0; i<sl.size(); ++i )
+        this->tags.append ( sl[i] );
     }
 }
 
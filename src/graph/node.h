@@ -128,12 +128,18 @@ class Node
   quint32 grid_y;                /* Y coordinate in the grid (layers organization) */
 
   quint32 subgraph_id;           /* id of the subgraph the node belongs to */
+  quint32 scc_id;                /* id of its strongly connected component (from 1, in topological order) */
 
   quint32 tag;                   /* tag (used to hold temporary data) */
   double coef;                   /* storage for some floating tag/coefficient (used for layout) */
 
   bool isVirtual;                /* whether the node is virtual or not */
 
+  quint32 layout_id;             /* id of the last layout the node took part in (0 if none) */
+  quint32 prev_grid_x;           /* grid coordinates of the node in that layout */
+  quint32 prev_grid_y;
+  bool dirty;                    /* whether an incremental layout has to place the node again */
+
   QList<Node *> parents;         /* node's parents  */
   QList<Node *> children;        /* node's children */
   QList<Node *> inactiveParents;
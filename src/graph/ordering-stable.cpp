@@ -0,0 +1,220 @@
+/*
+ * ordering-stable.cpp
+ *
+ * Implementation of the OrderingStable class / stable ordering algorithm.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <iostream>
+#include "ordering-stable.h"
+
+
+/*
+ * The stable ordering algorithm
+ *
+ * This algorithm is used by incremental layouts. The nodes that
+ * are not dirty keep the order they had in the previous layout.
+ * Dirty nodes are inserted at the median position of their
+ * neighbours, then adjacent swaps involving dirty nodes are
+ * tried to remove edge crossings. Layers without any dirty node
+ * keep the order of their nodes, but like the others they are
+ * renumbered from 1: the stable placing then puts their nodes back
+ * at their previous position.
+ */
+
+
+#define NB_TRANSPOSE_ITER 4
+
+#define UNKNOWN -1.0
+
+
+/*
+ * Return the median of a list of values (UNKNOWN if the list is empty).
+ */
+static double
+median ( QList<double> &values )
+{
+  const int n = values.size ( );
+
+  if ( n == 0 )
+    return UNKNOWN;
+
+  qSort ( values.begin(), values.end() );
+
+  if ( n & 1 )
+    return values[n >> 1];
+
+  return ( values[(n>>1)-1] + values[n>>1] ) / 2.0;
+}
+
+
+/*
+ * Compute the sort key of a dirty node using its neighbours' keys.
+ */
+static inline void
+assign_neighbours_median_coef ( Node *n )
+{
+  QList<double> values;
+
+  foreach ( Node *p, n->parents )
+    if ( p->coef != UNKNOWN )
+      values.append ( p->coef );
+
+  foreach ( Node *c, n->children )
+    if ( c->coef != UNKNOWN )
+      values.append ( c->coef );
+
+  n->coef = median ( values );
+}
+
+
+/*
+ * Compare two nodes' coefficient. This is used for sorting layer.
+ */
+static bool
+compareCoef ( const Node *n1,
+              const Node *n2 )
+{
+  return ( n1->coef < n2->coef );
+}
+
+
+/*
+ * Count the number of edge crossings between two nodes.
+ * The function consider n1 is on the left side of n2.
+ */
+static inline unsigned int
+count_nb_crossings ( const Node *n1,
+                     const Node *n2 )
+{
+  unsigned int ret = 0;
+
+  foreach ( Node *p1, n1->parents )
+    foreach ( Node *p2, n2->parents )
+      if ( p2->grid_x < p1->grid_x )
+        ++ret;
+
+  foreach ( Node *c1, n1->children )
+    foreach ( Node *c2, n2->children )
+      if ( c2->grid_x < c1->grid_x )
+        ++ret;
+
+  return ret;
+}
+
+
+/*
+ * Order a list of nodes, keeping the order of the previous layout.
+ */
+void
+OrderingStable::applyToNodes ( QList<Node *> &nodes )
+{
+  QList<QList<Node *> > layers;
+  QList<bool> dirtyLayers;
+  int i, j, k;
+
+  if ( nodes.size() == 0 )
+    return;
+
+  /* build layers list, clean nodes are sorted by previous position */
+  foreach ( Node *n, nodes )
+    {
+      while ( (int)n->grid_y >= layers.size() )
+        {
+          layers.append ( QList<Node *> ( ) );
+          dirtyLayers.append ( false );
+        }
+
+      layers[n->grid_y].append ( n );
+
+      if ( n->dirty )
+        {
+          n->coef = UNKNOWN;
+          dirtyLayers[n->grid_y] = true;
+        }
+      else
+        n->coef = n->prev_grid_x;
+    }
+
+  /* dirty nodes take the median position of their neighbours, top-down then bottom-up */
+  for ( i=0; i<layers.size(); ++i )
+    if ( dirtyLayers[i] )
+      foreach ( Node *n, layers[i] )
+        if ( n->dirty )
+          assign_neighbours_median_coef ( n );
+
+  for ( i=layers.size()-1; i>=0; --i )
+    if ( dirtyLayers[i] )
+      foreach ( Node *n, layers[i] )
+        if ( ( n->dirty ) && ( n->coef == UNKNOWN ) )
+          assign_neighbours_median_coef ( n );
+
+  /* sort the layers, the nodes which are still unknown go to the right */
+  for ( i=0; i<layers.size(); ++i )
+    {
+      QList<Node *> &l = layers[i];
+      double right = 0.0;
+
+      foreach ( Node *n, l )
+        if ( n->coef > right )
+          right = n->coef;
+
+      foreach ( Node *n, l )
+        if ( n->coef == UNKNOWN )
+          n->coef = ++right;
+
+      qStableSort ( l.begin(), l.end(), compareCoef );
+
+      for ( j=0; j<l.size(); ++j )
+        l[j]->grid_x = j+1;
+    }
+
+  /* exchange dirty nodes with their neighbours if it removes crossings */
+  bool improved = true;
+
+  for ( k=0; ( k<NB_TRANSPOSE_ITER ) && improved; ++k )
+    {
+      improved = false;
+
+      for ( i=0; i<layers.size(); ++i )
+        {
+          if ( !dirtyLayers[i] )
+            continue;
+
+          QList<Node *> &l = layers[i];
+
+          for ( j=0; j<l.size()-1; ++j )
+            {
+              Node *n1 = l[j];
+              Node *n2 = l[j+1];
+
+              if ( !n1->dirty && !n2->dirty )
+                continue;
+
+              if ( count_nb_crossings(n1,n2) > count_nb_crossings(n2,n1) )
+                {
+                  improved = true;
+                  l.swap ( j, j+1 );
+                  n2->grid_x = j+1;
+                  n1->grid_x = j+2;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * ordering-test.cpp
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+#include <string.h>
+#include <QtConcurrent>
+#include "graph.h"
+#include "graph-csr.h"
+#include "layering-bfs.h"
+#include "layering-lazy.h"
+#include "ordering-wmedian.h"
+#include "crossing-counter.h"
+#include "synthetic-graph.h"
+
+
+/*
+ * Run the median ordering on a snapshot of the nodes.
+ * Returns the duration in ms, the positions are saved in x.
+ */
+static double
+run_ordering ( QList<Node *> &nodes_list,
+               const bool parallel,
+               quint32 *x,
+               quint64 *nbc )
+{
+  struct timeval start, end;
+  GraphCsr csr ( nodes_list );
+
+  gettimeofday ( &start, NULL );
+  OrderingWMedian::applyToCsr ( csr, parallel );
+  gettimeofday ( &end, NULL );
+
+  memcpy ( x, csr.x, sizeof(quint32)*csr.size() );
+
+  csr.buildLayers ( );
+  CrossingCounter cc ( csr );
+  *nbc = cc.countAll ( );
+
+  return ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+}
+
+
+/*
+ * Order a graph serially then in parallel and compare the timings.
+ * Returns true if two parallel runs give the same order.
+ */
+static bool
+compare_orderings ( Graph *g,
+                    const char *name )
+{
+  QList<Node *> nodes_list;
+  quint32 *x_serial, *x_parallel, *x_check;
+  quint64 nbc_serial, nbc_parallel, nbc_check;
+  double t_serial, t_parallel;
+  bool deterministic;
+
+  /* layer the graph as assignGridCoordinates() does */
+  g->feedListWithActiveNodes ( nodes_list );
+  LayeringBfs::applyToNodes ( nodes_list );
+  LayeringLazy::applyToNodes ( nodes_list );
+  g->reverseUpwardEdges ( );
+  g->virtualizeLongEdges ( );
+  g->feedListWithActiveNodes ( nodes_list );
+
+  x_serial = new quint32 [ nodes_list.size()+1 ];
+  x_parallel = new quint32 [ nodes_list.size()+1 ];
+  x_check = new quint32 [ nodes_list.size()+1 ];
+
+  t_serial = run_ordering ( nodes_list, false, x_serial, &nbc_serial );
+  t_parallel = run_ordering ( nodes_list, true, x_parallel, &nbc_parallel );
+  run_ordering ( nodes_list, true, x_check, &nbc_check );
+
+  deterministic = ( memcmp(x_parallel,x_check,sizeof(quint32)*nodes_list.size()) == 0 );
+
+  std::cout << name << " (" << nodes_list.size() << " nodes with virtual ones)\n";
+  std::cout << "serial   -> " << t_serial << "ms, " << nbc_serial << " crossings\n";
+  std::cout << "parallel -> " << t_parallel << "ms, " << nbc_parallel << " crossings ("
+            << QThreadPool::globalInstance()->maxThreadCount() << " threads)\n";
+  std::cout << ( deterministic ? "deterministic\n\n" : "PARALLEL RUNS DIFFER\n\n" );
+
+  g->unVirtualizeLongEdges ( );
+  g->unReverseUpwardEdges ( );
+
+  delete [] x_serial;
+  delete [] x_parallel;
+  delete [] x_check;
+
+  return deterministic;
+}
+
+
+int
+main ( int argc,
+       char *argv[] )
+{
+  int c;
+  int ret = 0;
+
+  std::cout << "\n";
+
+  /* thread count and synthetic graphs */
+  while ( ( c = getopt(argc, argv, "j:s:") ) != -1 )
+    {
+      if ( c == 'j' )
+        QThreadPool::globalInstance()->setMaxThreadCount ( atoi(optarg) );
+      else if ( c == 's' )
+        {
+          Graph *g = build_synthetic_graph ( atoi(optarg) );
+
+          if ( !compare_orderings(g,"synthetic") )
+            ret = -1;
+
+          delete g;
+        }
+    }
+
+  /* graph files */
+  for ( ; optind<argc; ++optind )
+    {
+      Graph *g = new Graph ( );
+      EntityList *el = new EntityList ( );
+
+      el->parseFromFile ( argv[optind] );
+      g->initFromEntityList ( el );
+      delete el;
+
+      if ( !compare_orderings(g,argv[optind]) )
+        ret = -1;
+
+      delete g;
+    }
+
+  return ret;
+}
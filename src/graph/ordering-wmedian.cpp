@@ -22,6 +22,9 @@
  */
 
 #include <iostream>
+#include <string.h>
+#include <QtConcurrent>
+#include "crossing-counter.h"
 #include "ordering-wmedian.h"
 
 
@@ -31,11 +34,27 @@
  * The median value of a node is defined as the median position
  * of its adjacent nodes. Each layer is sorted according to
  * the median values of the nodes it contains.
+ *
+ * In parallel mode, the sweeps still go through the layers one after
+ * the other, since each layer is sorted against the new order of the
+ * previous one, but the coefficients of the wide layers are computed
+ * by chunks on the thread pool. The transposition processes the odd
+ * layers then the even layers: layers of the same parity do not share
+ * any neighbouring layer, so they are transposed concurrently. The
+ * crossings of the bilayers are counted concurrently as well.
+ *
+ * The result does not depend on the number of threads, but it may
+ * differ from the serial mode, whose transposition goes through the
+ * layers one after the other.
  */
 
 
 #define NB_ITER 24
 
+#define NO_COEF -1.0
+
+#define COEF_CHUNK 1024 /* nodes per parallel task when computing the coefficients */
+
 
 /*
  * The following structure is used to store a given configuration.
@@ -44,251 +63,272 @@ class WMConfig
 {
  public:
   /* constructor */
-  WMConfig ( const QList<Node *> &l, const unsigned int score  )
+  WMConfig ( const GraphCsr &g, const quint64 score  )
+    : g(g)
   {
-    QList<Node *>::const_iterator iter = l.constBegin ( );
-    pos.clear ( );
-
-    while ( iter != l.constEnd() )
-      {
-        pos.append ( new QPair<Node *, unsigned int> ( *iter, (*iter)->grid_x ) );
-        ++iter;
-      }
-
-    this->score = score;
+    pos = new quint32 [ g.size() ];
+    sync ( score );
   }
 
   /* destructor */
   ~WMConfig ( )
   {
-    qDeleteAll ( pos );
+    delete [] pos;
   }
 
   /* read and save the nodes positions */
-  void sync ( unsigned int score )
+  void sync ( quint64 score )
   {
-    QList<QPair<Node *, unsigned int> *>::iterator iter = pos.begin ( );
-    QPair<Node *, unsigned int> *pair;
-
-    while ( iter != pos.end() )
-      {
-        pair = *iter;
-        pair->second = pair->first->grid_x;
-        ++iter;
-      }
-
+    memcpy ( pos, g.x, sizeof(quint32)*g.size() );
     this->score = score;
   }
 
   /* write the saved positions back to the nodes */
   void writeBack ( )
   {
-    QList<QPair<Node *, unsigned int> *>::const_iterator iter = pos.constBegin ( );
-    QPair<Node *, unsigned int> *pair;
-
-    while ( iter != pos.constEnd() )
-      {
-        pair = *iter;
-        pair->first->grid_x = pair->second;
-        ++iter;
-      }
+    memcpy ( g.x, pos, sizeof(quint32)*g.size() );
   }
 
  public:
-  unsigned int score;
-  QList<QPair<Node *, unsigned int> *> pos;
+  quint64 score;
+  quint32 *pos;
+
+ private:
+  const GraphCsr &g;
 
 } ;
 
 
 /*
- * Assign the weighted median coefficient of a parent.
+ * Compute the weighted median coefficient of a node given its
+ * neighbours on the adjacent layer.
  */
-static inline void
-assign_parental_wmedian_coef ( Node *n )
+static inline double
+wmedian_coef ( const qint32 *nb,
+               const int nbNeighbours,
+               const quint32 *x )
 {
-  const int nbChildren = n->children.size ( );
-
-  if ( nbChildren == 0 )       /* no children, dummy value */
-    n->coef = -1.0;
-  else if ( nbChildren & 1 )   /* odd number of children, central value */
-    n->coef = n->children[nbChildren >> 1]->grid_x;
-  else if ( nbChildren == 2 )
-    n->coef = (n->children[0]->grid_x + n->children[1]->grid_x) / 2.0;
+  double coef;
+
+  if ( nbNeighbours == 0 )       /* no neighbours, dummy value */
+    coef = NO_COEF;
+  else if ( nbNeighbours & 1 )   /* odd number of neighbours, central value */
+    coef = x[nb[nbNeighbours >> 1]];
+  else if ( nbNeighbours == 2 )
+    coef = (x[nb[0]] + x[nb[1]]) / 2.0;
   else
     {
-      const unsigned int left = n->children[(nbChildren>>1)-1]->grid_x - n->children[0]->grid_x;
-      const unsigned int right = n->children[nbChildren-1]->grid_x - n->children[nbChildren>>1]->grid_x;
-      n->coef = n->children[(nbChildren>>1)-1]->grid_x * right + n->children[nbChildren>>1]->grid_x * left;
-      n->coef = n->coef / (left+right);
+      const unsigned int left = x[nb[(nbNeighbours>>1)-1]] - x[nb[0]];
+      const unsigned int right = x[nb[nbNeighbours-1]] - x[nb[nbNeighbours>>1]];
+      coef = x[nb[(nbNeighbours>>1)-1]] * right + x[nb[nbNeighbours>>1]] * left;
+      coef = coef / (left+right);
     }
+
+  return coef;
 }
 
 
 /*
- * Assign the weighted median coefficient of a child.
+ * Compare two nodes' weighted median coefficient. This is used for sorting layer.
+ */
+class CompareMediCoef
+{
+ public:
+  CompareMediCoef ( const double *coef, const quint32 *x ) : coef(coef), x(x) { }
+
+  inline bool operator() ( const qint32 n1, const qint32 n2 ) const
+  {
+    if ( coef[n1] == NO_COEF )
+      {
+        if ( coef[n2] == NO_COEF )
+          return ( x[n1] < x[n2] );
+        else
+          return ( (double)x[n1] < coef[n2] );
+      }
+    else
+      {
+        if ( coef[n2] == NO_COEF )
+          return ( coef[n1] < (double)x[n2] );
+        else
+          return ( coef[n1] < coef[n2] );
+      }
+  }
+
+ private:
+  const double *coef;
+  const quint32 *x;
+} ;
+
+
+/*
+ * Sort the nodes of a layer according to their coefficients.
  */
 static inline void
-assign_filial_wmedian_coef ( Node *n )
+sort_layer ( GraphCsr &g,
+             const qint32 i,
+             const double *coef )
 {
-  const int nbParents = n->parents.size ( );
-
-  if ( nbParents == 0 )       /* no parents, dummy value */
-    n->coef = -1.0;
-  else if ( nbParents & 1 )   /* odd number of parents, central value */
-    n->coef = n->parents[nbParents >> 1]->grid_x;
-  else if ( nbParents == 2 )
-    n->coef = (n->parents[0]->grid_x + n->parents[1]->grid_x) / 2.0;
-  else
-    {
-      const unsigned int left = n->parents[(nbParents>>1)-1]->grid_x - n->parents[0]->grid_x;
-      const unsigned int right = n->parents[nbParents-1]->grid_x - n->parents[nbParents>>1]->grid_x;
-      n->coef = n->parents[(nbParents>>1)-1]->grid_x * right + n->parents[nbParents>>1]->grid_x * left;
-      n->coef = n->coef / (left+right);
-    }
+  qint32 j;
+  qint32 *l = g.layer ( i );
+  const qint32 size = g.layerSize ( i );
+
+  qStableSort ( l, l+size, CompareMediCoef(coef,g.x) );
+
+  /* update indexes */
+  for ( j=0; j<size; ++j )
+    g.x[l[j]] = j+1;
 }
 
 
 /*
- * Compare two nodes' weighted median coefficient. This is used for sorting layer.
+ * Compute the weighted median coefficients of the nodes [first,last) of
+ * the layer[i] according to the nodes of the layer[i-1] (filial) or of
+ * the layer[i+1] (parental).
  */
-static bool
-compareMediCoef ( const Node *n1,
-                  const Node *n2 )
+static inline void
+compute_wmedian_coefs ( const GraphCsr &g,
+                        const qint32 i,
+                        const qint32 first,
+                        const qint32 last,
+                        double *coef,
+                        const bool filial )
 {
-  if ( n1->coef == -1.0 )
+  qint32 j;
+  const qint32 *l = g.layer ( i );
+
+  if ( filial ) /* calculate filial weighted median coefs */
     {
-      if ( n2->coef == -1.0 )
-        return ( n1->grid_x < n2->grid_x );
-      else
-        return ( (double)n1->grid_x < n2->coef );
+      for ( j=first; j<last; ++j )
+        coef[l[j]] = wmedian_coef ( g.parents(l[j]), g.nbParents(l[j]), g.x );
     }
-  else
+  else /* calculate parental weighted median coefs */
     {
-      if ( n2->coef == -1.0 )
-        return ( n1->coef < (double)n2->grid_x );
-      else
-        return ( n1->coef < n2->coef );
+      for ( j=first; j<last; ++j )
+        coef[l[j]] = wmedian_coef ( g.children(l[j]), g.nbChildren(l[j]), g.x );
     }
 }
 
 
 /*
- * Sort the nodes in each layer (step 1 of sugiyama's algorithm)
+ * Functor used to compute the coefficients of a wide layer by chunks.
  */
-static inline void
-sort_using_filial_wmedian_coef ( QList<QList<Node *> > &layers )
+class CoefKernel
 {
-  int i, j;
-  
-  /* sort the nodes of the layer[i] according to the nodes of the layer[i-1] */
-  for ( i=1; i<layers.size(); ++i )
-    {
-      QList<Node *> &l = layers[i];
+ public:
+  typedef void result_type;
 
-      /* calculate filial weighted median coefs */
-      foreach ( Node *n, l )
-        assign_filial_wmedian_coef ( n );
+  CoefKernel ( const GraphCsr *g, const qint32 i, double *coef, const bool filial )
+    : g(g), i(i), coef(coef), filial(filial) { }
 
-      /* sort */
-      qStableSort ( l.begin(), l.end(), compareMediCoef );
+  void operator() ( const qint32 &first ) const
+  {
+    compute_wmedian_coefs ( *g, i, first, qMin(first+COEF_CHUNK,g->layerSize(i)), coef, filial );
+  }
 
-      /* update indexes */
-      for ( j=0; j<l.size(); ++j )
-        l[j]->grid_x = j+1;
-    }
-}
+ private:
+  const GraphCsr *g;
+  qint32 i;
+  double *coef;
+  bool filial;
+} ;
 
 
 /*
- * Sort the nodes in each layer (step 1 of sugiyama's algorithm)
+ * Sort the nodes of the layer[i] according to their neighbours
+ * on the previous (filial) or next (parental) layer.
  */
 static inline void
-sort_using_parental_wmedian_coef ( QList<QList<Node *> > &layers )
+sort_layer_using_wmedian_coef ( GraphCsr &g,
+                                const qint32 i,
+                                double *coef,
+                                const bool filial,
+                                const bool parallel )
 {
-  int i, j;
+  qint32 j;
+  const qint32 size = g.layerSize ( i );
 
-  /* sort the nodes of the layer[i] according to the nodes of the layer[i+1] */
-  for ( i=(layers.size()-2); i>=0; --i )
+  if ( parallel && ( size > COEF_CHUNK ) )
     {
-      QList<Node *> &l = layers[i];
+      QList<qint32> chunks;
 
-      /* calculate parental barycenter coefs */
-      foreach ( Node *n, l )
-        assign_parental_wmedian_coef ( n );
+      for ( j=0; j<size; j+=COEF_CHUNK )
+        chunks.append ( j );
 
-      /* sort */
-      qStableSort ( l.begin(), l.end(), compareMediCoef );
-
-      /* update indexes */
-      for ( j=0; j<l.size(); ++j )
-        l[j]->grid_x = j+1;
+      QtConcurrent::blockingMap ( chunks, CoefKernel(&g,i,coef,filial) );
     }
+  else
+    compute_wmedian_coefs ( g, i, 0, size, coef, filial );
+
+  sort_layer ( g, i, coef );
 }
 
 
 /*
- * Count the number of edge crossings between two nodes.
- * count_nb_crossings(a,b,s) != count_nb_crossings(b,a,s)
- * The function consider n1 is on the left side of n2.
+ * Sort the nodes in each layer (step 1 of sugiyama's algorithm)
  */
-static inline unsigned int
-count_nb_crossings ( const Node *n1,
-                     const Node *n2,
-                     QList<Node *> *upperLayer,
-                     QList<Node *> *lowerLayer )
+static inline void
+sort_using_filial_wmedian_coef ( GraphCsr &g,
+                                 double *coef,
+                                 const bool parallel )
 {
-  unsigned int ret = 0;
-  Node *p;
+  qint32 i;
 
-  if ( upperLayer != NULL )
-    {
-      foreach ( p, n1->parents )
-        {
-          const int idx = p->grid_x - 1;
+  /* sort the nodes of the layer[i] according to the nodes of the layer[i-1] */
+  for ( i=1; i<g.nbLayers(); ++i )
+    sort_layer_using_wmedian_coef ( g, i, coef, true, parallel );
+}
 
-          for ( int i=0; i<idx; ++i )
-            if ( n2->parents.contains((*upperLayer)[i]) )
-              ++ret;
-        }
-    }
 
-  if ( lowerLayer != NULL )
-    {
-      foreach ( p, n1->children )
-        {
-          const int idx = p->grid_x - 1;
-
-          for ( int i=0; i<idx; ++i )
-            if ( n2->children.contains((*lowerLayer)[i]) )
-              ++ret;
-        }
-    }
+/*
+ * Sort the nodes in each layer (step 1 of sugiyama's algorithm)
+ */
+static inline void
+sort_using_parental_wmedian_coef ( GraphCsr &g,
+                                   double *coef,
+                                   const bool parallel )
+{
+  qint32 i;
 
-  return ret;
+  /* sort the nodes of the layer[i] according to the nodes of the layer[i+1] */
+  for ( i=(g.nbLayers()-2); i>=0; --i )
+    sort_layer_using_wmedian_coef ( g, i, coef, false, parallel );
 }
 
 
 /*
- * Count the number of edge crossings for all layers.
+ * Exchange the position of adjacent nodes within a layer if it improves the layout.
+ * Returns true if at least one pair was exchanged.
  */
-static unsigned int
-count_nb_crossings ( QList<QList<Node *> > &layers )
+static bool
+transpose_layer ( GraphCsr &g,
+                  CrossingCounter &cc,
+                  const qint32 i )
 {
-  int i, j, k;
-  unsigned int ret = 0;
+  qint32 j, n1, n2;
+  qint32 *l = g.layer ( i );
+  bool improved = false;
+
+  cc.sortNeighbourPositions ( i );
 
-  for ( i=0; i<layers.size()-1; ++i )
+  for ( j=0; j<g.layerSize(i)-1; ++j )
     {
-      QList<Node *> &l = layers[i];
-      QList<Node *> *l1 = &layers[i+1];
+      n1 = l[j];
+      n2 = l[j+1];
 
-      for ( j=0; j<l.size()-1; ++j )
-        for ( k=j+1; k<l.size(); ++k )
-          ret += count_nb_crossings ( l[j], l[k], NULL, l1 );
+      const int c_ori = cc.countPair ( n1, n2 );
+      const int c_exc = cc.countPair ( n2, n1 );
+
+      if ( c_ori > c_exc )
+        {
+          improved = true;
+          l[j] = n2;
+          l[j+1] = n1;
+          g.x[n2] = j+1;
+          g.x[n1] = j+2;
+        }
     }
 
-  return ret;
+  return improved;
 }
 
 
@@ -296,111 +336,105 @@ count_nb_crossings ( QList<QList<Node *> > &layers )
  * Exchange the position of nodes within a layer if it improves the layout.
  */
 static void
-transpose ( QList<QList<Node *> > &layers )
+transpose ( GraphCsr &g,
+            CrossingCounter &cc )
 {
-  int i, j;
-  Node *n1, *n2;
+  qint32 i;
   bool improved = true;
 
   while ( improved )
     {
       improved = false;
 
-      /* handle the first layer separately */
-      QList<Node *> &l0 = layers[0];
+      for ( i=0; i<g.nbLayers(); ++i )
+        if ( transpose_layer(g,cc,i) )
+          improved = true;
+    }
+}
 
-      for ( j=0; j<l0.size()-1; ++j )
-        {
-          n1 = l0[j];
-          n2 = l0[j+1];
-
-          const int c_ori = count_nb_crossings ( n1, n2, NULL, &layers[1] );
-          const int c_exc = count_nb_crossings ( n2, n1, NULL, &layers[1] );
-
-          if ( c_ori > c_exc )
-            {
-              improved = true;
-              l0.swap ( j, j+1 );
-              n2->grid_x = j+1;
-              n1->grid_x = j+2;
-            }
-        }
 
-      /* handle layers that have an upper and a lower layer */
-      for ( i=1; i<layers.size()-1; ++i )
-        {
-          QList<Node *> &l = layers[i];
-
-          for ( j=0; j<l.size()-1; ++j )
-            {
-              n1 = l[j];
-              n2 = l[j+1];
-
-              const int c_ori = count_nb_crossings ( n1, n2, &layers[i-1], &layers[i+1] );
-              const int c_exc = count_nb_crossings ( n2, n1, &layers[i-1], &layers[i+1] );
-
-              if ( c_ori > c_exc )
-                {
-                  improved = true;
-                  l.swap ( j, j+1 );
-                  n2->grid_x = j+1;
-                  n1->grid_x = j+2;
-                }
-            }
-        }
+/*
+ * Functor used to transpose the layers of a phase in parallel.
+ */
+class TransposeKernel
+{
+ public:
+  typedef void result_type;
 
-      /* handle the last layer separately */
-      QList<Node *> &lN = layers[i];
+  TransposeKernel ( GraphCsr *g, CrossingCounter *cc, bool *improved ) : g(g), cc(cc), improved(improved) { }
 
-      for ( j=0; j<lN.size()-1; ++j )
-        {
-          n1 = lN[j];
-          n2 = lN[j+1];
-
-          const int c_ori = count_nb_crossings ( n1, n2, &layers[i-1], NULL );
-          const int c_exc = count_nb_crossings ( n2, n1, &layers[i-1], NULL );
-
-          if ( c_ori > c_exc )
-            {
-              improved = true;
-              lN.swap ( j, j+1 );
-              n2->grid_x = j+1;
-              n1->grid_x = j+2;
-            }
-        }
-    }
-}
+  void operator() ( const qint32 &i ) const
+  {
+    if ( transpose_layer(*g,*cc,i) )
+      improved[i] = true;
+  }
+
+ private:
+  GraphCsr *g;
+  CrossingCounter *cc;
+  bool *improved;
+} ;
 
 
 /*
- * Assign an X coordinate to each node in order discovery
+ * Transpose the layers, one parity after the other, until no layer improves.
  */
 static void
-assignInitialGridX ( Node *n,
-                     QList<unsigned int> &posList )
+parallel_transpose ( GraphCsr &g,
+                     CrossingCounter &cc,
+                     QList<qint32> *parities,
+                     bool *improved )
 {
-  unsigned int x;
+  qint32 i;
+  bool any = true;
 
-  if ( n->grid_x != 0 )
-    return;
+  while ( any )
+    {
+      any = false;
+
+      for ( i=0; i<g.nbLayers(); ++i )
+        improved[i] = false;
 
-  x = posList[n->grid_y];
-  n->grid_x = x;
-  posList[n->grid_y] = x + 1;
+      QtConcurrent::blockingMap ( parities[0], TransposeKernel(&g,&cc,improved) );
+      QtConcurrent::blockingMap ( parities[1], TransposeKernel(&g,&cc,improved) );
 
-  foreach ( Node *child, n->children )
-    assignInitialGridX ( child, posList );
+      for ( i=0; i<g.nbLayers(); ++i )
+        if ( improved[i] )
+          any = true;
+    }
 }
 
 
 /*
- * Compare to nodes grid_x in order to sort a layer.
+ * Assign an X coordinate to each node in order discovery
+ * (depth-first, children in order).
  */
-static bool
-compareGridX ( const Node *n1,
-               const Node *n2 )
+static void
+assignInitialGridX ( GraphCsr &g,
+                     const qint32 entry,
+                     quint32 *posList,
+                     QVector<qint32> &stack )
 {
-  return ( n1->grid_x < n2->grid_x );
+  qint32 n, j;
+
+  stack.append ( entry );
+
+  while ( !stack.isEmpty() )
+    {
+      n = stack.last ( );
+      stack.removeLast ( );
+
+      if ( g.x[n] != 0 )
+        continue;
+
+      g.x[n] = posList[g.y[n]]++;
+
+      const qint32 *children = g.children ( n );
+
+      for ( j=g.nbChildren(n)-1; j>=0; --j )
+        if ( g.x[children[j]] == 0 )
+          stack.append ( children[j] );
+    }
 }
 
 
@@ -410,66 +444,92 @@ compareGridX ( const Node *n1,
 void
 OrderingWMedian::applyToNodes ( QList<Node *> &nodes )
 {
-  QList<QList<Node *> > layers;
-  QList<unsigned int> posList;
-  QList<Node *> entries;
-  Node *entry;
-  int i;
+  GraphCsr csr ( nodes );
 
-  if ( nodes.size() == 0 )
-    return;
+  applyToCsr ( csr );
+  csr.storeCoordinates ( );
+}
 
-  entry = nodes[0];
 
-  /* build layers and entry points list */
-  layers.append ( QList<Node *> ( ) );
-  posList.append ( 1 );
+/*
+ * Order a graph snapshot using the median algorithm.
+ * The layers are swept concurrently if parallel is true.
+ */
+void
+OrderingWMedian::applyToCsr ( GraphCsr &g,
+                              const bool parallel )
+{
+  quint32 *posList;
+  double *coef;
+  bool *improved;
+  QList<qint32> parities[2];  /* odd and even layers, for the parallel transposition */
+  QList<qint32> entries;
+  QVector<qint32> stack;
+  qint32 i;
 
-  foreach ( Node *n, nodes )
-    {
-      while ( (int)n->grid_y >= layers.size() )
-        {
-          layers.append ( QList<Node *> ( ) );
-          posList.append ( 1 );
-        }
+  const qint32 N = g.size ( );
 
-      layers[n->grid_y].append ( n );
-      n->grid_x = 0;
+  if ( N == 0 )
+    return;
 
-      if ( entry->n_id > n->n_id ) /* we take the first node that was added to the graph */
-        entry = n;                 /* it will be used as the default entry point */
+  /* entry points list */
+  for ( i=0; i<N; ++i )
+    {
+      g.x[i] = 0;
 
-      if ( !n->hasParents() ) /* save the entries of the graph */
-        entries.append ( n );
+      if ( g.nbParents(i) == 0 ) /* save the entries of the graph */
+        entries.append ( i );
     }
 
   if ( entries.size() == 0 )
-    entries.append ( entry );
+    entries.append ( g.defaultEntry() );
 
   /* compute initial order by going through each tree */
-  foreach ( Node *n, entries )
-    assignInitialGridX ( n, posList );
+  g.buildLayers ( );
+  posList = new quint32 [ g.nbLayers() ];
+
+  for ( i=0; i<g.nbLayers(); ++i )
+    posList[i] = 1;
+
+  foreach ( qint32 entry, entries )
+    assignInitialGridX ( g, entry, posList, stack );
 
-  for ( i=0; i<layers.size(); ++i )
-    qSort ( layers[i].begin(), layers[i].end(), compareGridX );
+  delete [] posList;
 
-  if ( layers.size() == 1 )
+  g.buildLayers ( );
+
+  if ( g.nbLayers() == 1 )
     return;
 
   /* apply the weighted median sorting algorithm to the layers */
-  unsigned int nbc = count_nb_crossings ( layers );
-  WMConfig conf ( nodes, nbc );
+  coef = new double [ N ];
+  improved = new bool [ g.nbLayers() ];
+  CrossingCounter cc ( g );
+  quint64 nbc = cc.countAll ( parallel );
+  WMConfig conf ( g, nbc );
+
+  for ( i=0; i<g.nbLayers(); ++i )
+    parities[i&1].append ( i );
 
   for ( i=0; i<NB_ITER; ++i )
     {
       //std::cout << "[wm " << i << " W] " << nbc << " edge crossings\n";
 
-      sort_using_filial_wmedian_coef ( layers );
-      transpose ( layers );
-      sort_using_parental_wmedian_coef ( layers );
-      transpose (  layers );
+      sort_using_filial_wmedian_coef ( g, coef, parallel );
+
+      if ( parallel )
+        parallel_transpose ( g, cc, parities, improved );
+      else
+        transpose ( g, cc );
+
+      sort_using_parental_wmedian_coef ( g, coef, parallel );
+
+      if ( parallel )
+        parallel_transpose ( g, cc, parities, improved );
+      else
+        transpose ( g, cc );
 
-      nbc = count_nb_crossings ( layers );
+      nbc = cc.countAll ( parallel );
 
       if ( nbc == 0 )
         break; /* no more crossing edges, bail out */
@@ -481,5 +541,8 @@ OrderingWMedian::applyToNodes ( QList<Node *> &nodes )
   if ( nbc != 0 )
     conf.writeBack ( );
 
+  delete [] coef;
+  delete [] improved;
+
   //std::cout << "[wm] " << conf.score << " edge crossings\n";
 }
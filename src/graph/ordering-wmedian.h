@@ -29,12 +29,14 @@
 
 #include <QtCore>
 #include "node.h"
+#include "graph-csr.h"
 
 
 class OrderingWMedian
 {
  public:
   static void applyToNodes ( QList<Node *> & );
+  static void applyToCsr ( GraphCsr &, const bool parallel=false );
 
 } ;
 
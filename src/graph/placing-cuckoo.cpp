@@ -23,6 +23,8 @@
 
 #include <iostream>
 #include <cmath>
+#include <QtConcurrent>
+#include "placing-random.h"
 #include "placing-cuckoo.h"
 
 
@@ -32,13 +34,19 @@
  * adjacent nodes.
  * After a round of computation and evaluation, the best configurations
  * are cloned, randomized and a few other new configurations are created.
+ *
+ * In parallel mode, several nests are incubated at the same time on the
+ * thread pool and the best egg is kept. Each egg has its own random
+ * generator, seeded from the seed of the placing and the rank of its
+ * nest, so a given seed always gives the same placing whatever the
+ * number of threads. The first nest is the one of the serial mode.
  */
 
-inline double cauchy ( void )
+inline double cauchy ( PlacingRandom &rng )
 {
-  double p = drand48 ( );
+  double p = rng.nextDouble ( );
   while ( p == 0.0 )
-    p = drand48 ( );
+    p = rng.nextDouble ( );
   return 0.6*tan(M_PI*(p-0.5)); // 0.6 is scaling factor
 }
 
@@ -87,9 +95,9 @@ class Value
   }
 
   /* randomize the position held by a value */
-  inline void randomize ( )
+  inline void randomize ( PlacingRandom &rng )
   {
-    double c = cauchy ( );
+    double c = cauchy ( rng );
     pos = (unsigned int) ((double) pos) + c;
 
     if ( pos >= *upperB )
@@ -141,7 +149,7 @@ class Value
 class Egg
 {
  public:
-  Egg ( unsigned int *Z, unsigned int *M ) : ZERO(Z), MAX(M) { }
+  Egg ( unsigned int *Z, unsigned int *M, const quint64 seed, const quint64 stream ) : ZERO(Z), MAX(M), rng(seed,stream) { }
   ~Egg ( ) { qDeleteAll(values); values.clear(); }
 
   /* initialize an egg from a list of values */
@@ -206,7 +214,7 @@ class Egg
   void randomize ( )
   {
     for ( QList<Value *>::iterator iter=values.begin(); iter!=values.end(); ++iter )
-      (*iter)->randomize ( );
+      (*iter)->randomize ( rng );
   }
 
   /* save the positions */
@@ -270,12 +278,15 @@ class Egg
 
   unsigned int *ZERO;
   unsigned int *MAX;
+
+  PlacingRandom rng;
 } ;
 
 
 
 #define PRECISION      1
 #define NB_ITER        10000
+#define NB_NESTS       8
 
 #ifdef PLACING_TEST
 extern unsigned long int placing_score;
@@ -285,11 +296,67 @@ extern unsigned long int placing_score;
 extern bool compareLayerIndex ( const Node *, const Node * );
 
 
+/*
+ * Improve an egg by random walks, keeping the changes that lower its score.
+ */
+static void
+incubate ( Egg *e,
+           const bool verbose )
+{
+  unsigned long int min_score;
+  int i;
+
+  e->computeScore ( );
+  min_score = e->score;
+
+  for ( i=0; i<NB_ITER; ++i )
+    {
+      e->randomize ( );
+      e->computeScore ( );
+
+      if ( e->score > min_score )
+        e->reset ( );
+      else
+        {
+          min_score = e->score;
+          e->storeOriPos ( );
+        }
+
+#ifdef PLACING_TEST
+      if ( verbose && ( (i % 128) == 0 ) )
+        std::cout << "[" << i << "] best score -> " << min_score << "\n";
+#else
+      Q_UNUSED ( verbose );
+#endif
+    }
+
+  e->score = min_score;
+}
+
+
+/*
+ * Functor used to incubate the nests in parallel.
+ */
+class NestKernel
+{
+ public:
+  typedef void result_type;
+
+  void operator() ( Egg * const &e ) const
+  {
+    incubate ( e, false );
+  }
+} ;
+
+
 /*
  * Place nodes using a simplified cuckoo algorithm.
+ * Several nests are incubated on the thread pool if parallel is true.
  */
 void
-PlacingCuckoo::applyToNodes ( QList<Node *> &nodes )
+PlacingCuckoo::applyToNodes ( QList<Node *> &nodes,
+                             const quint64 seed,
+                             const bool parallel )
 {
   unsigned int max_width = 0;
   QList<Value *> ref;
@@ -297,8 +364,8 @@ PlacingCuckoo::applyToNodes ( QList<Node *> &nodes )
   Value *g = NULL;
   Value *previous;
   Egg *e;
+  QList<Egg *> nests;
 
-  unsigned long int min_score;
   int i, j;
 
   unsigned int ZERO = 0;
@@ -418,35 +485,33 @@ PlacingCuckoo::applyToNodes ( QList<Node *> &nodes )
   delete layers;
   delete hb;
 
-  /* create two eggs */
-#ifndef PLACING_TEST
-  srand ( time(NULL) );
-#endif
-
-  e = new Egg ( &ZERO, &MAX );
-  e->fill ( ref );
-
-  e->computeScore ( );
-  min_score = e->score;
-
-  /* evaluate, produce offspring, mutate the best, add fresh flesh */
-  for ( i=0; i<NB_ITER; ++i )
+  /* create the eggs */
+  if ( parallel )
     {
-      e->randomize ( );
-      e->computeScore ( );
-
-      if ( e->score > min_score )
-        e->reset ( );
-      else
+      for ( i=0; i<NB_NESTS; ++i )
         {
-          min_score = e->score;
-          e->storeOriPos ( );
+          e = new Egg ( &ZERO, &MAX, seed, i );
+          e->fill ( ref );
+          nests.append ( e );
         }
 
-#ifdef PLACING_TEST
-      if ( (i % 128) == 0 )
-        std::cout << "[" << i << "] best score -> " << min_score << "\n";
-#endif
+      QtConcurrent::blockingMap ( nests, NestKernel() );
+
+      /* keep the best egg, the first one on ties */
+      e = nests[0];
+
+      for ( i=1; i<NB_NESTS; ++i )
+        if ( nests[i]->score < e->score )
+          e = nests[i];
+
+      nests.removeOne ( e );
+      qDeleteAll ( nests );
+    }
+  else
+    {
+      e = new Egg ( &ZERO, &MAX, seed, 0 );
+      e->fill ( ref );
+      incubate ( e, true );
     }
 
   // e->validate ( );
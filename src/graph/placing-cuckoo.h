@@ -34,7 +34,7 @@
 class PlacingCuckoo
 {
  public:
-  static void applyToNodes ( QList<Node *> & );
+  static void applyToNodes ( QList<Node *> &, const quint64 seed=0, const bool parallel=false );
 
 } ;
 
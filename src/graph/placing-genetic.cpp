@@ -22,6 +22,9 @@
  */
 
 #include <iostream>
+#include <string.h>
+#include <QtConcurrent>
+#include "placing-random.h"
 #include "placing-genetic.h"
 
 
@@ -31,294 +34,295 @@
  * adjacent nodes.
  * After a round of computation and evaluation, the best configurations
  * are cloned, randomized and a few other new configurations are created.
+ *
+ * Each chromosome draws its random numbers from its own generator,
+ * seeded from the seed of the placing and the rank of the chromosome
+ * in the initial population. So a given seed always gives the same
+ * placing, and the parallel mode, which evaluates and breeds the
+ * chromosomes on the thread pool, gives the same placing as the
+ * serial mode whatever the number of threads.
  */
 
 
 /*
- * Gene
+ * The genes are stored as a structure of arrays. The genes of all the
+ * chromosomes are ranked in the same way, layer after layer, from left
+ * to right, so that the neighbours of a gene on its layer are the
+ * previous and next ranks. A chromosome is only a position array
+ * indexed by rank, while the edges are shared by all the chromosomes.
  */
-class Gene
-{
- public:
-  Gene ( Node *n ) : node(n), score(0) { }
-  ~Gene ( ) { }
-
-  /* compute the score of a gene */
-  inline unsigned long int computeScore ( )
-  {
-    QList<Gene *>::const_iterator iter;
-
-    score = 0;
-
-    for ( iter=children.constBegin(); iter!=children.constEnd(); ++iter )
-      score += ( ( (*iter)->pos - pos ) * ( (*iter)->pos - pos ) );
-
-    for ( iter=parents.constBegin(); iter!=parents.constEnd(); ++iter )
-      score += ( ( (*iter)->pos - pos ) * ( (*iter)->pos - pos ) );
-
-    return score;
-  }
-
-  /* save the position held by a gene */
-  inline void savePos ( )
-  {
-    node->grid_x = pos;
-  }
 
-  /* change the position held by a gene */
-  inline void setPos ( const unsigned int p )
-  {
-    prev_pos = pos;
-    pos = p;
-  }
-
-  /* randomize the position held by a gene */
-  inline void randomize ( )
-  {
-    int delta = *upperB - *lowerB;
-
-    --delta;
-    prev_pos = pos;
-
-    if ( delta != 0 )
-      setPos ( *lowerB + 1 + (rand() % delta) );
-  }
-
-  /* reset the position help by a gene */
-  inline void reset ( )
-  {
-    pos = prev_pos;
-  }
 
-  /* compute a new position using the median heuristic */
-  inline void median ( )
+/*
+ * Genome (what the chromosomes have in common)
+ */
+class Genome
+{
+ public:
+  Genome ( const GraphCsr &csr, unsigned int max ) : size(csr.size()), MAX(max)
   {
-    QList<Gene *>::const_iterator iter;
-    int delta = 0;
-    int res;
-
-    prev_pos = pos;
-
-    if ( ( parents.size() | children.size() ) == 0 )
-      return;
+    qint32 i, j, k, n, r;
+
+    const qint32 N = csr.size ( );
+
+    idx = new qint32 [ N ];
+    rankOf = new qint32 [ N ];
+    first = new bool [ N ];
+    last = new bool [ N ];
+    virt = new bool [ N ];
+    parent0 = new qint32 [ N ];
+    child0 = new qint32 [ N ];
+    adjOffsets = new qint32 [ N+1 ];
+    adj = new qint32 [ 2*csr.edgesCount()+1 ];
+    src = new qint32 [ csr.edgesCount()+1 ];
+    dest = new qint32 [ csr.edgesCount()+1 ];
+    vheads = new qint32 [ csr.edgesCount()+1 ];
+
+    /* rank the nodes layer after layer */
+    r = 0;
+
+    for ( i=0; i<csr.nbLayers(); ++i )
+      {
+        const qint32 *l = csr.layer ( i );
 
-    for ( iter=children.constBegin(); iter!=children.constEnd(); ++iter )
-      delta += (*iter)->pos - pos;
+        for ( j=0; j<csr.layerSize(i); ++j )
+          {
+            n = l[j];
+            idx[r] = n;
+            rankOf[n] = r;
+            first[r] = ( j == 0 );
+            last[r] = ( j == csr.layerSize(i)-1 );
+            virt[r] = csr.isVirtual[n];
+            ++r;
+          }
+      }
 
-    for ( iter=parents.constBegin(); iter!=parents.constEnd(); ++iter )
-      delta += (*iter)->pos - pos;
+    /* neighbours (children then parents) and edges by rank */
+    nbEdges = 0;
+    adjOffsets[0] = 0;
 
-    delta /= (parents.size()+children.size());
-    res = pos + delta;
+    for ( r=0; r<N; ++r )
+      {
+        n = idx[r];
 
-    if ( res <= (int)*lowerB )
-      setPos ( *lowerB + 1 );
-    else if ( res >= (int)*upperB )
-      setPos ( *upperB - 1 );
-    else
-      setPos ( res );
-  }
+        const qint32 *children = csr.children ( n );
+        const qint32 *parents = csr.parents ( n );
 
-  /* validate the position help by a gene */
-  inline void validate ( ) const
-  {
-    if ( pos <= *lowerB )
-      std::cout << "node " << qPrintable(node->id) << " conflicts with lowerB\n";
+        adjOffsets[r+1] = adjOffsets[r];
 
-    if  ( pos >= *upperB )
-      std::cout << "node " << qPrintable(node->id) << " conflicts with upperB\n";
-  }
+        for ( k=0; k<csr.nbChildren(n); ++k )
+          {
+            adj[adjOffsets[r+1]++] = rankOf[children[k]];
+            src[nbEdges] = r;
+            dest[nbEdges] = rankOf[children[k]];
+            ++nbEdges;
+          }
 
-  /* is a gene representing a virtual node ? */
-  inline bool isVirtual ( ) const
-  {
-    return node->isVirtual;
-  }
+        for ( k=0; k<csr.nbParents(n); ++k )
+          adj[adjOffsets[r+1]++] = rankOf[parents[k]];
 
-  /* straighten an edge of virtual nodes */
-  void straightenDownward ( const unsigned int fix,
-                            const unsigned int min,
-                            const unsigned int max )
-  {
-    if ( !isVirtual() )
-      return;
+        child0[r] = ( csr.nbChildren(n) > 0 ) ? rankOf[children[0]] : -1;
+        parent0[r] = ( csr.nbParents(n) > 0 ) ? rankOf[parents[0]] : -1;
+      }
 
-    this->straightened = false;
+    /* first node of the virtualized edges */
+    nbVheads = 0;
 
-    if ( fix <= *lowerB )
+    for ( r=0; r<N; ++r )
       {
-        this->straightened = true;
-        // std::cout << "[" << qPrintable(node->id) << "] fix <= lowerB (" << fix << " <= " << *lowerB << ")\n";
-
-        setPos ( 1 + *lowerB );
+        if ( virt[r] )
+          continue;
 
-        parents[0]->straightenUpward ( fix );
-        children[0]->straightenDownward ( pos, *lowerB, *upperB );
-      }
-    else if ( fix >= *upperB )
-      {
-        this->straightened = true;
-        // std::cout << "[" << qPrintable(node->id) << "] fix >= upperB (" << fix << " >= " << *upperB << ")\n";
-        setPos ( *upperB - 1 );
-        parents[0]->straightenUpward ( fix );
-        children[0]->straightenDownward ( pos, *lowerB, *upperB );
-      }
-    else
-      {
-        if ( children[0]->isVirtual() )
-          {
-            // std::cout << "[" << qPrintable(node->id) << "] going down\n";
-            children[0]->straightenDownward ( fix,
-                                              (min > *lowerB) ? min : *lowerB,
-                                              (max < *upperB) ? max : *upperB );
-          }
-        else
-          {
-            // std::cout << "[" << qPrintable(node->id) << "] going up\n";
-            this->straightenUpward ( fix );
-          }
+        for ( k=0; k<csr.nbChildren(idx[r]); ++k )
+          if ( virt[adj[adjOffsets[r]+k]] )
+            vheads[nbVheads++] = adj[adjOffsets[r]+k];
       }
   }
 
-  void straightenUpward ( const unsigned int fix )
+  ~Genome ( )
   {
-    if ( ( !isVirtual() ) || ( this->straightened ) )
-      return;
-
-    // std::cout << "[" << qPrintable(node->id) << "] moving from " << pos << " to " << fix << "\n";
-    setPos ( fix );
-    parents[0]->straightenUpward ( fix );
+    delete [] idx;
+    delete [] rankOf;
+    delete [] first;
+    delete [] last;
+    delete [] virt;
+    delete [] parent0;
+    delete [] child0;
+    delete [] adjOffsets;
+    delete [] adj;
+    delete [] src;
+    delete [] dest;
+    delete [] vheads;
   }
 
+  /* left and right bounds of the gene of rank r */
+  inline unsigned int lowerB ( const quint32 *pos, const qint32 r ) const { return first[r] ? 0 : pos[r-1]; }
+  inline unsigned int upperB ( const quint32 *pos, const qint32 r ) const { return last[r] ? MAX : pos[r+1]; }
 
  public:
-  Node *node;
-  QList<Gene *> children;
-  QList<Gene *> parents;
+  qint32 size;
+  unsigned int MAX;
 
-  unsigned int *upperB;
-  unsigned int *lowerB;
-  unsigned int pos;
-  unsigned int prev_pos;
+  qint32 *idx;               /* index of the node of a rank in the graph snapshot */
+  qint32 *rankOf;            /* rank of a node of the graph snapshot */
+  bool *first;               /* is the rank the first of its layer ? */
+  bool *last;                /* is the rank the last of its layer ? */
+  bool *virt;                /* is the rank a virtual node ? */
+  qint32 *parent0;           /* first parent, -1 if none */
+  qint32 *child0;            /* first child, -1 if none */
 
-  unsigned long int score;
+  qint32 *adjOffsets;        /* neighbours of each rank: adj[adjOffsets[r]..adjOffsets[r+1]] */
+  qint32 *adj;
+
+  qint32 nbEdges;            /* edges as (src,dest) rank pairs */
+  qint32 *src;
+  qint32 *dest;
 
-  bool straightened;
+  qint32 nbVheads;           /* ranks of the first virtual node of each virtualized edge */
+  qint32 *vheads;
 } ;
 
 
 /*
- * Chromosome (set of genes)
+ * Chromosome (positions of the genes)
  */
 class Chromosome
 {
  public:
-  Chromosome ( unsigned int *Z, unsigned int *M ) : ZERO(Z), MAX(M) { }
-  ~Chromosome ( ) { qDeleteAll(genes); genes.clear(); }
+  Chromosome ( const Genome &g, const quint64 seed, const quint64 stream ) : rng(seed,stream), g(g)
+  {
+    pos = new quint32 [ g.size ];
+    prev_pos = new quint32 [ g.size ];
+    straightened = new bool [ g.size ];
+    memset ( straightened, 0, sizeof(bool)*g.size );
+  }
 
-  /* initialize a chromosome from a list of genes */
-  void fill ( QList<Gene *> &l )
+  ~Chromosome ( )
   {
-    Gene *g, *prev, *ori, *prev_ori;
-    int i;
-    QHash<Gene *, Gene *> tb;
-
-    qDeleteAll ( genes );
-    genes.clear ( );
-
-    /* copy genes */
-    ori = l[0];
-    g = new Gene ( ori->node );
-    g->lowerB = ZERO;
-    g->pos = ori->pos;
-    genes.append ( g );
-    tb.insert ( ori, g );
-    prev = g;
-    prev_ori = ori;
-
-    for ( i=1; i<l.size(); ++i )
-      {
-        ori = l[i];
-        g = new Gene ( ori->node );
-        genes.append ( g );
-        tb.insert ( ori, g );
-        g->pos = ori->pos;
-
-        if ( ori->lowerB != ZERO )
-          g->lowerB = &prev->pos;
-        else
-          g->lowerB = ZERO;
+    delete [] pos;
+    delete [] prev_pos;
+    delete [] straightened;
+  }
 
-        if ( prev_ori->upperB != MAX )
-          prev->upperB = &g->pos;
-        else
-          prev->upperB = MAX;
+  /* random integer from the generator of the chromosome */
+  inline int random ( )
+  {
+    return rng.nextInt ( );
+  }
 
-        prev = g;
-        prev_ori = ori;
-      }
+  /* initialize a chromosome from the positions of another one */
+  inline void fill ( const quint32 *p )
+  {
+    memcpy ( pos, p, sizeof(quint32)*g.size );
+    memcpy ( prev_pos, p, sizeof(quint32)*g.size );
+  }
 
-    prev->upperB = MAX;
+  /* change the position held by a gene */
+  inline void setPos ( const qint32 r, const unsigned int p )
+  {
+    prev_pos[r] = pos[r];
+    pos[r] = p;
+  }
 
-    /* set children/parents */
-    for ( i=0; i<l.size(); ++i )
-      {
-        ori = l[i];
-        g = tb.value ( ori );
+  /* randomize the position held by a gene */
+  inline void randomizeGene ( const qint32 r )
+  {
+    const unsigned int lower = g.lowerB ( pos, r );
+    int delta = g.upperB ( pos, r ) - lower;
 
-        foreach ( Gene *child, ori->children )
-          g->children.append ( tb.value(child) );
+    --delta;
+    prev_pos[r] = pos[r];
 
-        foreach ( Gene *parent, ori->parents )
-          g->parents.append ( tb.value(parent) );
-      }
+    if ( delta != 0 )
+      setPos ( r, lower + 1 + (random() % delta) );
   }
 
   /* randomize a chromosome */
   void randomize ( )
   {
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      (*iter)->randomize ( );
+    qint32 r;
+
+    for ( r=0; r<g.size; ++r )
+      randomizeGene ( r );
   }
 
   /* mutate randomly a chromosome */
   void mutate ( )
   {
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
+    qint32 r;
+
+    for ( r=0; r<g.size; ++r )
       {
-        if ( (rand() & 3) == 0 ) /* 25% mutation rate */
-          (*iter)->randomize ( );
+        if ( (random() & 3) == 0 ) /* 25% mutation rate */
+          randomizeGene ( r );
       }
   }
 
   /* apply the median heuristic to a chromosome */
   void median ( )
   {
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      (*iter)->median ( );
+    qint32 r, k;
+    int delta, res;
+
+    for ( r=0; r<g.size; ++r )
+      {
+        const qint32 begin = g.adjOffsets[r];
+        const qint32 end = g.adjOffsets[r+1];
+
+        prev_pos[r] = pos[r];
+
+        if ( begin == end )
+          continue;
+
+        delta = 0;
+
+        for ( k=begin; k<end; ++k )
+          delta += pos[g.adj[k]] - pos[r];
+
+        delta /= (end-begin);
+        res = pos[r] + delta;
+
+        if ( res <= (int)g.lowerB(pos,r) )
+          setPos ( r, g.lowerB(pos,r) + 1 );
+        else if ( res >= (int)g.upperB(pos,r) )
+          setPos ( r, g.upperB(pos,r) - 1 );
+        else
+          setPos ( r, res );
+      }
   }
 
   /* save the positions */
-  void savePos ( )
+  void savePos ( quint32 *x ) const
   {
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      (*iter)->savePos ( );
+    qint32 r;
+
+    for ( r=0; r<g.size; ++r )
+      x[g.idx[r]] = pos[r];
   }
 
   /* reset the positions */
   void reset ( )
   {
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      (*iter)->reset ( );
+    memcpy ( pos, prev_pos, sizeof(quint32)*g.size );
   }
 
-  /* compute the score of a chromosome */
+  /* compute the score of a chromosome: squared length of the edges,
+     counted once from each end */
   unsigned long int computeScore ( )
   {
-    score = 0;
+    qint32 e;
+    quint64 sum = 0;
+
+    const qint32 *src = g.src;
+    const qint32 *dest = g.dest;
 
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      score += (*iter)->computeScore ( );
+    for ( e=0; e<g.nbEdges; ++e )
+      {
+        const quint32 d = pos[dest[e]] - pos[src[e]];
+        sum += (quint32)( d * d );
+      }
+
+    score = 2 * sum;
 
     return score;
   }
@@ -326,61 +330,107 @@ class Chromosome
   /* validate a chromosome */
   void validate ( ) const
   {
-    for ( QList<Gene *>::const_iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      (*iter)->validate ( );
+    qint32 r;
+
+    for ( r=0; r<g.size; ++r )
+      {
+        if ( pos[r] <= g.lowerB(pos,r) )
+          std::cout << "node " << r << " conflicts with lowerB\n";
+
+        if  ( pos[r] >= g.upperB(pos,r) )
+          std::cout << "node " << r << " conflicts with upperB\n";
+      }
   }
 
   /* align all the positions along the left border */
   void alignLeft ( )
   {
-    unsigned int min_pos = *MAX;
+    qint32 r;
+    unsigned int min_pos = g.MAX;
 
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      if ( (*iter)->pos < min_pos )
-        min_pos = (*iter)->pos;
+    for ( r=0; r<g.size; ++r )
+      if ( pos[r] < min_pos )
+        min_pos = pos[r];
 
     --min_pos; /* the left border has index=1 */
 
-    for ( QList<Gene *>::iterator iter=genes.begin(); iter!=genes.end(); ++iter )
-      (*iter)->setPos ( (*iter)->pos - min_pos );
+    for ( r=0; r<g.size; ++r )
+      setPos ( r, pos[r] - min_pos );
   }
 
   /* straighten the virtual edges */
   void straightenVirtualEdges ( )
   {
-    QList<Gene *> vheads;
-    Gene *g;
+    qint32 i, r;
 
-    /* find the first node of virtualized edges */
-    for ( QList<Gene *>::iterator genesIter=genes.begin(); genesIter!=genes.end(); ++genesIter )
+    /* attempt to straighten each virtual edge */
+    for ( i=0; i<g.nbVheads; ++i )
       {
-        g = *genesIter;
+        r = g.vheads[i];
+        straightenDownward ( r, pos[g.parent0[r]], g.lowerB(pos,r), g.upperB(pos,r) );
+      }
+  }
 
-        if ( g->isVirtual() )
-          continue;
+  /* straighten an edge of virtual nodes, from the gene of rank r downward */
+  void straightenDownward ( qint32 r,
+                            unsigned int fix,
+                            unsigned int min,
+                            unsigned int max )
+  {
+    while ( g.virt[r] )
+      {
+        const unsigned int lower = g.lowerB ( pos, r );
+        const unsigned int upper = g.upperB ( pos, r );
+
+        straightened[r] = false;
+
+        if ( ( fix <= lower ) || ( fix >= upper ) )
+          {
+            straightened[r] = true;
+            setPos ( r, ( fix <= lower ) ? lower+1 : upper-1 );
+            straightenUpward ( g.parent0[r], fix );
+
+            fix = pos[r];
+            min = lower;
+            max = upper;
+          }
+        else if ( !g.virt[g.child0[r]] )
+          {
+            straightenUpward ( r, fix );
+            return;
+          }
+        else
+          {
+            min = (min > lower) ? min : lower;
+            max = (max < upper) ? max : upper;
+          }
 
-        for ( QList<Gene *>::iterator childrenIter=g->children.begin(); childrenIter!=g->children.end(); ++childrenIter )
-          if ( (*childrenIter)->isVirtual() )
-            vheads.append ( *childrenIter );
+        r = g.child0[r];
       }
+  }
 
-    /* attempt to straighten each virtual edge */
-    for ( QList<Gene *>::iterator iter=vheads.begin(); iter!=vheads.end(); ++iter )
+  /* move a chain of virtual nodes, from the gene of rank r upward */
+  void straightenUpward ( qint32 r,
+                          const unsigned int fix )
+  {
+    while ( g.virt[r] && !straightened[r] )
       {
-        g = *iter;
-        // std::cout << "\n-- straightening from parent " << qPrintable(g->parents[0]->node->id) << "\n";
-        g->straightenDownward ( g->parents[0]->pos, *g->lowerB, *g->upperB );
+        setPos ( r, fix );
+        r = g.parent0[r];
       }
   }
 
 
  public:
-  QList<Gene *> genes;
+  quint32 *pos;
+  quint32 *prev_pos;
+  bool *straightened;
 
   unsigned long int score;
 
-  unsigned int *ZERO;
-  unsigned int *MAX;
+ private:
+  PlacingRandom rng;
+  const Genome &g;
 } ;
 
 
@@ -416,196 +466,237 @@ bool compareScore ( const Chromosome *c1,
 }
 
 
+/*
+ * Initial chromosome.
+ */
+static inline void
+init_chromosome ( Chromosome *c,
+                  const quint32 *ref )
+{
+  c->fill ( ref );
+  c->randomize ( );
+  c->randomize ( );
+  c->randomize ( );
+  c->median ( );
+  c->median ( );
+  c->straightenVirtualEdges ( );
+  c->straightenVirtualEdges ( );
+}
+
+
+/*
+ * Offspring of a kept chromosome.
+ */
+static inline void
+breed_chromosome ( Chromosome *c,
+                   const quint32 *parent )
+{
+  c->fill ( parent );
+  c->randomize ( );
+  c->median ( );
+  c->straightenVirtualEdges ( );
+  c->straightenVirtualEdges ( );
+}
+
+
+/*
+ * Fresh chromosome.
+ */
+static inline void
+fresh_chromosome ( Chromosome *c,
+                   const quint32 *ref )
+{
+  c->fill ( ref );
+  c->randomize ( );
+  c->median ( );
+  c->median ( );
+  c->straightenVirtualEdges ( );
+  c->straightenVirtualEdges ( );
+}
+
+
+/*
+ * Functors used to process the population in parallel.
+ */
+class InitKernel
+{
+ public:
+  typedef void result_type;
+
+  InitKernel ( const quint32 *ref ) : ref(ref) { }
+
+  void operator() ( Chromosome * const &c ) const
+  {
+    init_chromosome ( c, ref );
+  }
+
+ private:
+  const quint32 *ref;
+} ;
+
+
+class ScoreKernel
+{
+ public:
+  typedef void result_type;
+
+  void operator() ( Chromosome * const &c ) const
+  {
+    c->computeScore ( );
+  }
+} ;
+
+
+class BreedKernel
+{
+ public:
+  typedef void result_type;
+
+  BreedKernel ( const QList<Chromosome *> *pool, const quint32 *ref ) : pool(pool), ref(ref) { }
+
+  void operator() ( const qint32 &j ) const
+  {
+    if ( j < NB_CHROMOSOMES-NB_FRESH )
+      breed_chromosome ( pool->at(j), pool->at(j%NB_KEPT)->pos );
+    else
+      fresh_chromosome ( pool->at(j), ref );
+  }
+
+ private:
+  const QList<Chromosome *> *pool;
+  const quint32 *ref;
+} ;
+
+
+class MedianKernel
+{
+ public:
+  typedef void result_type;
+
+  MedianKernel ( const QList<Chromosome *> *pool ) : pool(pool) { }
+
+  void operator() ( const qint32 &j ) const
+  {
+    pool->at(j)->median ( );
+  }
+
+ private:
+  const QList<Chromosome *> *pool;
+} ;
+
+
 /*
  * Place nodes using a genetic algorithm.
  */
 void
-PlacingGenetic::applyToNodes ( QList<Node *> &nodes )
+PlacingGenetic::applyToNodes ( QList<Node *> &nodes,
+                               const quint64 seed,
+                               const bool parallel )
+{
+  GraphCsr csr ( nodes );
+
+  applyToCsr ( csr, seed, parallel );
+  csr.storeCoordinates ( );
+}
+
+
+/*
+ * Place the nodes of a graph snapshot using a genetic algorithm.
+ * The population is processed on the thread pool if parallel is true.
+ */
+void
+PlacingGenetic::applyToCsr ( GraphCsr &csr,
+                             const quint64 seed,
+                             const bool parallel )
 {
   unsigned int max_width = 0;
-  QList<Gene *> ref;
+  quint32 *ref;
   QList<Chromosome *> pool;
-  Node *n;
-  Gene *g = NULL;
-  Gene *previous;
+  QList<qint32> offspring;     /* ranks in the pool of the renewed chromosomes */
+  QList<qint32> kept;          /* ranks in the pool of the kept chromosomes */
   Chromosome *c;
+  qint32 r;
 
   unsigned long int min_score;
   int i, j;
 
-  unsigned int ZERO = 0;
-  unsigned int MAX;
+  const qint32 N = csr.size ( );
 
-  if ( nodes.size() == 0 )
+  if ( N == 0 )
     return;
 
   /* order the nodes */
-  QList<QList<Node *> *> *layers = new QList<QList<Node *> *> ( );
-  QList<Node *> *l;
-  layers->append ( new QList<Node *> ( ) );
+  csr.buildLayers ( );
 
-  foreach ( Node *n, nodes )
-    {
-      while ( (int)n->grid_y >= layers->size() )
-        layers->append ( new QList<Node *> ( ) );
+  max_width = csr.maxLayerSize ( ) * PRECISION;
 
-      l = layers->at ( n->grid_y );
-      l->append ( n );
+  Genome genome ( csr, max_width+1 );
 
-      if ( l->size() > (int)max_width )
-        max_width = l->size ( );
-    }
+  /* build the reference positions */
+  ref = new quint32 [ N ];
 
-  max_width = max_width * PRECISION;
-  MAX = max_width+1;
+  for ( r=0; r<N; ++r )
+    ref[r] = genome.first[r] ? 0 : PRECISION * csr.x[genome.idx[r]];
 
-  for ( i=0; i<layers->size(); ++i )
+  /* create initial population */
+  if ( parallel )
     {
-      l = layers->at ( i );
-      qStableSort ( l->begin(), l->end(), compareLayerIndex );
-    }
-
-
-  /* build the reference genes */
-  QHash<Node *, Gene *> *hb = new QHash<Node *, Gene *> ( );
-  previous = NULL;
+      for ( i=0; i<NB_CHROMOSOMES; ++i )
+        pool.append ( new Chromosome(genome,seed,i) );
 
-  for ( i=0; i<layers->size(); ++i )
-    {
-      l = layers->at ( i );
-      previous = NULL;
-
-      n = l->at ( 0 );
-      g = new Gene ( n );
-      g->lowerB = &ZERO;
-      g->pos = ZERO;
-      previous = g;
-      hb->insert ( n, g );
-      ref.append ( g );
-
-      for ( j=1; j<l->size()-1; ++j )
-        {
-          n = l->at ( j );
-          g = new Gene ( n );
-          g->lowerB = &previous->pos;
-          g->pos = PRECISION * n->grid_x;
-          previous->upperB = &g->pos;
-          previous = g;
-          hb->insert ( n, g );
-          ref.append ( g );
-        }
+      for ( i=0; i<NB_KEPT; ++i )
+        kept.append ( i );
 
-      if ( l->size() != 1 )
-        {
-          n = l->at ( j );
-          g = new Gene ( n );
-          g->lowerB = &previous->pos;
-          g->pos = PRECISION * n->grid_x;
-          previous->upperB = &g->pos;
-          previous = g;
-          hb->insert ( n, g );
-          ref.append ( g );
-        }
+      for ( i=NB_KEPT; i<NB_CHROMOSOMES; ++i )
+        offspring.append ( i );
 
-      previous->upperB = &MAX;
+      QtConcurrent::blockingMap ( pool, InitKernel(ref) );
     }
-
-  foreach ( Node *n, nodes )
+  else
     {
-      g = hb->value ( n );
-
-      foreach ( Node *child, n->children )
-        {
-          if ( hb->value(child) == NULL )
-            {
-              std::cout << "[" << qPrintable(n->id) << "] error : NULL entry for child \'" << qPrintable(child->id) << "\' (" << child << ")\n";
-              if ( child->isActive() )
-                std::cout << "child is active !\n";
-              else
-                std::cout << "child is INactive !\n";
-            }
-
-          /* if the error occurs, then it might be because we have duplicate nodes IDs */
-
-          g->children.append ( hb->value(child) );
-        }
-
-      foreach ( Node *parent, n->parents )
+      for ( i=0; i<NB_CHROMOSOMES; ++i )
         {
-          if ( hb->value(parent) == NULL )
-            {
-              std::cout << "[" << qPrintable(n->id) << "] error : NULL entry for parent \'" << qPrintable(parent->id) << "\' (" << parent << ")\n";
-              if ( parent->isActive() )
-                std::cout << "parent is active !\n";
-              else
-                std::cout << "parent is INactive !\n";
-            }
-
-          g->parents.append ( hb->value(parent) );
+          c = new Chromosome ( genome, seed, i );
+          init_chromosome ( c, ref );
+          pool.append ( c );
         }
     }
 
-  
-  qDeleteAll ( *layers );
-  delete layers;
-  delete hb;
-
-  /* create initial population */
-#ifndef PLACING_TEST
-  srand ( time(NULL) );
-#endif
-
-  for ( i=0; i<NB_CHROMOSOMES; ++i )
-    {
-      c = new Chromosome ( &ZERO, &MAX );
-      c->fill ( ref );
-
-      c->randomize ( );
-      c->randomize ( );
-      c->randomize ( );
-      c->median ( );
-      c->median ( );
-      c->straightenVirtualEdges ( );
-      c->straightenVirtualEdges ( );
-
-      pool.append ( c );
-    }
-
   int improvement = 0;
   min_score = pool[0]->computeScore ( );
 
   /* evaluate, produce offspring, mutate the best, add fresh flesh */
   for ( i=0; i<NB_ITER; ++i )
     {
-      for ( j=0; j<NB_CHROMOSOMES; ++j )
-        pool[j]->computeScore ( );
+      if ( parallel )
+        QtConcurrent::blockingMap ( pool, ScoreKernel() );
+      else
+        {
+          for ( j=0; j<NB_CHROMOSOMES; ++j )
+            pool[j]->computeScore ( );
+        }
 
       qSort ( pool.begin(), pool.end(), compareScore );
 
       improvement += min_score - pool[0]->score;
       min_score = pool[0]->score;
 
-      for ( j=NB_KEPT; j<NB_CHROMOSOMES-NB_FRESH; ++j )
+      if ( parallel )
         {
-          c = pool[j];
-          c->fill ( pool[j%NB_KEPT]->genes );
-          c->randomize ( );
-          c->median ( );
-          c->straightenVirtualEdges ( );
-          c->straightenVirtualEdges ( );
+          /* the offspring read the kept chromosomes before they change */
+          QtConcurrent::blockingMap ( offspring, BreedKernel(&pool,ref) );
+          QtConcurrent::blockingMap ( kept, MedianKernel(&pool) );
         }
+      else
+        {
+          for ( j=NB_KEPT; j<NB_CHROMOSOMES-NB_FRESH; ++j )
+            breed_chromosome ( pool[j], pool[j%NB_KEPT]->pos );
 
-      for ( j=0; j<NB_KEPT; ++j )
-        pool[j]->median ( );
+          for ( j=0; j<NB_KEPT; ++j )
+            pool[j]->median ( );
 
-      for ( j=NB_CHROMOSOMES-NB_FRESH; j<NB_CHROMOSOMES; ++j )
-        {
-          pool[j]->fill ( ref );
-          pool[j]->randomize ( );
-          pool[j]->median ( );
-          pool[j]->median ( );
-          pool[j]->straightenVirtualEdges ( );
-          pool[j]->straightenVirtualEdges ( );
+          for ( j=NB_CHROMOSOMES-NB_FRESH; j<NB_CHROMOSOMES; ++j )
+            fresh_chromosome ( pool[j], ref );
         }
 
       pool[0]->computeScore ( );
@@ -631,7 +722,7 @@ PlacingGenetic::applyToNodes ( QList<Node *> &nodes )
   // std::cout << "[straightening improvement]  " << min_score << " -> " << pool[0]->score << "\n";
 
   pool[0]->alignLeft ( );
-  pool[0]->savePos ( );
+  pool[0]->savePos ( csr.x );
 
 #ifdef PLACING_TEST
   pool[0]->computeScore ( );
@@ -641,5 +732,5 @@ PlacingGenetic::applyToNodes ( QList<Node *> &nodes )
 
   /* free */
   qDeleteAll ( pool );
-  qDeleteAll ( ref );
+  delete [] ref;
 }
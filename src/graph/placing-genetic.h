@@ -29,12 +29,14 @@
 
 #include <QtCore>
 #include "node.h"
+#include "graph-csr.h"
 
 
 class PlacingGenetic
 {
  public:
-  static void applyToNodes ( QList<Node *> & );
+  static void applyToNodes ( QList<Node *> &, const quint64 seed=0, const bool parallel=false );
+  static void applyToCsr ( GraphCsr &, const quint64 seed=0, const bool parallel=false );
 
 } ;
 
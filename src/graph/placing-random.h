@@ -0,0 +1,97 @@
+/*
+ * placing-random.h
+ *
+ * Declaration of the PlacingRandom class.
+ * Pseudo-random generator owned by the placing algorithms, so that
+ * placings are reproducible and parallel placers do not share any state.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __PLACING_RANDOM_H__
+#define __PLACING_RANDOM_H__
+
+#include <QtCore>
+
+
+/*
+ * xoshiro256** generator, seeded with splitmix64.
+ * Two generators built with the same (seed, stream) pair produce
+ * the same sequence.
+ */
+class PlacingRandom
+{
+ public:
+  PlacingRandom ( const quint64 seed=0, const quint64 stream=0 ) { this->seed ( seed, stream ); }
+
+  /* restart the sequence */
+  inline void seed ( const quint64 seed, const quint64 stream=0 )
+  {
+    int i;
+    quint64 z = seed ^ ( stream * 0xd1b54a32d192ed03ULL );
+
+    for ( i=0; i<4; ++i )
+      {
+        z += 0x9e3779b97f4a7c15ULL;
+        quint64 t = z;
+        t = ( t ^ (t >> 30) ) * 0xbf58476d1ce4e5b9ULL;
+        t = ( t ^ (t >> 27) ) * 0x94d049bb133111ebULL;
+        s[i] = t ^ (t >> 31);
+      }
+  }
+
+  /* next 64 bits */
+  inline quint64 next ( )
+  {
+    const quint64 result = rotl ( s[1] * 5, 7 ) * 9;
+    const quint64 t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl ( s[3], 45 );
+
+    return result;
+  }
+
+  /* integer in [0,2^31), like rand() */
+  inline int nextInt ( )
+  {
+    return (int)( next() >> 33 );
+  }
+
+  /* double in [0,1), like drand48() */
+  inline double nextDouble ( )
+  {
+    return (double)( next() >> 11 ) * ( 1.0 / 9007199254740992.0 );
+  }
+
+ private:
+  static inline quint64 rotl ( const quint64 x, const int k )
+  {
+    return ( x << k ) | ( x >> (64-k) );
+  }
+
+  quint64 s[4];
+} ;
+
+
+#endif
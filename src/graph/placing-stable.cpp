@@ -0,0 +1,169 @@
+/*
+ * placing-stable.cpp
+ *
+ * Implementation of the PlacingStable class / stable placing algorithm.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <iostream>
+#include "placing-stable.h"
+
+
+/*
+ * The stable placing algorithm
+ *
+ * This algorithm is used by incremental layouts. The nodes that
+ * are not dirty want to go back to the position they had in the
+ * previous layout, dirty nodes want to go to the median position
+ * of their neighbours. Each layer is then swept from left to right
+ * so that positions are strictly increasing, which only pushes
+ * nodes to the right when there is no room left.
+ * Finally, a few median iterations move the dirty nodes between
+ * their left and right neighbours.
+ */
+
+
+#define NB_ITER 4
+
+
+extern bool compareLayerIndex ( const Node *, const Node * );
+
+
+/*
+ * Return the median position of the neighbours of a node (0 if none).
+ * Only the nodes which are already placed are considered.
+ */
+static unsigned int
+neighbours_median ( const Node *n,
+                    const bool childrenPlaced )
+{
+  QList<unsigned int> values;
+
+  foreach ( Node *p, n->parents )
+    values.append ( p->grid_x );
+
+  foreach ( Node *c, n->children )
+    {
+      if ( childrenPlaced )
+        values.append ( c->grid_x );
+      else if ( !c->dirty )
+        values.append ( c->prev_grid_x );
+    }
+
+  const int nb = values.size ( );
+
+  if ( nb == 0 )
+    return 0;
+
+  qSort ( values.begin(), values.end() );
+
+  if ( nb & 1 )
+    return values[nb >> 1];
+
+  return ( values[(nb>>1)-1] + values[nb>>1] ) / 2;
+}
+
+
+/*
+ * Place nodes, keeping the positions of the previous layout.
+ */
+void
+PlacingStable::applyToNodes ( QList<Node *> &nodes )
+{
+  QList<QList<Node *> > layers;
+  unsigned int min_pos = UINT_MAX;
+  unsigned int last, pos;
+  int i, j, k;
+
+  if ( nodes.size() == 0 )
+    return;
+
+  /* build the ordered layers */
+  foreach ( Node *n, nodes )
+    {
+      while ( (int)n->grid_y >= layers.size() )
+        layers.append ( QList<Node *> ( ) );
+
+      layers[n->grid_y].append ( n );
+    }
+
+  for ( i=0; i<layers.size(); ++i )
+    qStableSort ( layers[i].begin(), layers[i].end(), compareLayerIndex );
+
+  /* top-down sweep: each node takes its wished position or the first free one */
+  for ( i=0; i<layers.size(); ++i )
+    {
+      last = 0;
+
+      foreach ( Node *n, layers[i] )
+        {
+          if ( n->dirty )
+            pos = neighbours_median ( n, false );
+          else
+            pos = n->prev_grid_x;
+
+          if ( pos <= last )
+            pos = last + 1;
+
+          n->grid_x = pos;
+          last = pos;
+        }
+    }
+
+  /* move the dirty nodes towards the median of their neighbours */
+  for ( k=0; k<NB_ITER; ++k )
+    {
+      for ( i=0; i<layers.size(); ++i )
+        {
+          QList<Node *> &l = layers[i];
+
+          for ( j=0; j<l.size(); ++j )
+            {
+              Node *n = l[j];
+
+              if ( !n->dirty )
+                continue;
+
+              pos = neighbours_median ( n, true );
+
+              if ( pos == 0 )
+                continue;
+
+              if ( ( j > 0 ) && ( pos <= l[j-1]->grid_x ) )
+                pos = l[j-1]->grid_x + 1;
+
+              if ( ( j < l.size()-1 ) && ( pos >= l[j+1]->grid_x ) )
+                pos = l[j+1]->grid_x - 1;
+
+              if ( ( j == 0 || pos > l[j-1]->grid_x ) && ( pos > 0 ) )
+                n->grid_x = pos;
+            }
+        }
+    }
+
+  /* align all the positions along the left border */
+  foreach ( Node *n, nodes )
+    if ( n->grid_x < min_pos )
+      min_pos = n->grid_x;
+
+  --min_pos; /* the left border has index=1 */
+
+  foreach ( Node *n, nodes )
+    n->grid_x -= min_pos;
+}
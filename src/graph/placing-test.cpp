@@ -20,6 +20,8 @@
  */
 
 #include <sys/time.h>
+#include <unistd.h>
+#include <QtConcurrent>
 #include "graph.h"
 #include "layering-floyd.h"
 #include "layering-lazy.h"
@@ -33,12 +35,23 @@ int
 main ( int argc,
        char *argv[] )
 {
-  int i;
+  int c, i;
   struct timeval start, end;
+  bool parallel = false;
 
   std::cout << "\n";
 
-  for ( i=1; i<argc; ++i )
+  /* -j N places with N threads */
+  while ( ( c = getopt(argc, argv, "j:") ) != -1 )
+    {
+      if ( c == 'j' )
+        {
+          QThreadPool::globalInstance()->setMaxThreadCount ( atoi(optarg) );
+          parallel = true;
+        }
+    }
+
+  for ( i=optind; i<argc; ++i )
     {
       Graph *g = new Graph ( );
       EntityList *el = new EntityList ( );
@@ -57,11 +70,10 @@ main ( int argc,
       g->feedListWithActiveNodes ( nodes_list ); /* update the nodes list because of the virtualization */
       OrderingWMedian::applyToNodes ( nodes_list );
 
-      srand ( 7 );
       gettimeofday ( &start, NULL );
-      PlacingGenetic::applyToNodes ( nodes_list );
+      PlacingGenetic::applyToNodes ( nodes_list, 7, parallel );
       std::cout << "final score -> " << placing_score << "\n";
-      PlacingCuckoo::applyToNodes ( nodes_list );
+      PlacingCuckoo::applyToNodes ( nodes_list, 7, parallel );
       gettimeofday ( &end, NULL );
 
       std::cout << "final score -> " << placing_score << "\n";
@@ -0,0 +1,237 @@
+/*
+ * scc-condensation.cpp
+ *
+ * Implementation of the SccCondensation class.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "scc-condensation.h"
+
+
+/*
+ * Finding the components
+ *
+ * This is Pearce's variant of Tarjan's algorithm, without recursion:
+ * the depth first search keeps its own stack of nodes, each one with
+ * the position of the next child to explore. rindex[v] is the visiting
+ * index of v, lowered to the lowest index v reaches; when v completes
+ * a component, its members get the component number instead, counted
+ * down from N-1, so that a single array tells both. Completed
+ * components are found sinks first, which is reverse topological order.
+ *
+ * It runs in O(V+E) and uses a few arrays of N integers.
+ */
+
+
+/*
+ * Assign its component to each node of a snapshot.
+ * Returns the number of components.
+ */
+qint32
+SccCondensation::findComponents ( const GraphCsr &csr,
+                                  qint32 *rindex )
+{
+  const qint32 N = csr.size ( );
+  qint32 *nextChild = new qint32 [ N ];  /* offset of the next child to explore */
+  qint32 *dfs = new qint32 [ N ];        /* depth first search path */
+  qint32 *pending = new qint32 [ N ];    /* visited nodes whose component is not complete */
+  bool *root = new bool [ N ];
+  qint32 dfsSize = 0;
+  qint32 pendingSize = 0;
+  qint32 index = 1;
+  qint32 c = N - 1;
+  qint32 s, v, w;
+
+  for ( v=0; v<N; ++v )
+    rindex[v] = 0;
+
+  for ( s=0; s<N; ++s )
+    {
+      if ( rindex[s] != 0 )
+        continue;
+
+      /* begin visiting s */
+      dfs[dfsSize++] = s;
+      nextChild[s] = 0;
+      root[s] = true;
+      rindex[s] = index++;
+
+      while ( dfsSize > 0 )
+        {
+          v = dfs[dfsSize-1];
+
+          if ( nextChild[v] < csr.nbChildren(v) )
+            {
+              w = csr.children(v)[nextChild[v]];
+
+              if ( rindex[w] == 0 )
+                {
+                  /* begin visiting w, the edge is finished when w is */
+                  dfs[dfsSize++] = w;
+                  nextChild[w] = 0;
+                  root[w] = true;
+                  rindex[w] = index++;
+                  continue;
+                }
+
+              if ( rindex[w] < rindex[v] )
+                {
+                  rindex[v] = rindex[w];
+                  root[v] = false;
+                }
+
+              ++nextChild[v];
+              continue;
+            }
+
+          /* finish visiting v */
+          --dfsSize;
+
+          if ( !root[v] )
+            {
+              pending[pendingSize++] = v;
+              continue;
+            }
+
+          --index;
+
+          while ( ( pendingSize > 0 ) && ( rindex[v] <= rindex[pending[pendingSize-1]] ) )
+            {
+              w = pending[--pendingSize];
+              rindex[w] = c;
+              --index;
+            }
+
+          rindex[v] = c--;
+        }
+    }
+
+  delete [] nextChild;
+  delete [] dfs;
+  delete [] pending;
+  delete [] root;
+
+  return N - 1 - c;
+}
+
+
+/*
+ * Constructor
+ */
+SccCondensation::SccCondensation ( const GraphCsr &csr )
+{
+  qint32 i, c, k, m;
+  const qint32 *child;
+
+  this->nbNodes = csr.size ( );
+  this->component = new qint32 [ this->nbNodes ];
+  this->nbComps = findComponents ( csr, this->component );
+
+  const qint32 N = this->nbNodes;
+  const qint32 C = this->nbComps;
+
+  /* number the components in topological order: c = rindex - (N-C) */
+  for ( i=0; i<N; ++i )
+    this->component[i] -= N - C;
+
+  /* members, in the order of the snapshot */
+  this->memberOffsets = new qint32 [ C+1 ];
+  this->memberNodes = new qint32 [ N+1 ];
+
+  for ( c=0; c<=C; ++c )
+    this->memberOffsets[c] = 0;
+
+  for ( i=0; i<N; ++i )
+    ++this->memberOffsets[this->component[i]+1];
+
+  for ( c=0; c<C; ++c )
+    this->memberOffsets[c+1] += this->memberOffsets[c];
+
+  qint32 *fill = new qint32 [ C+1 ];
+
+  for ( c=0; c<C; ++c )
+    fill[c] = this->memberOffsets[c];
+
+  for ( i=0; i<N; ++i )
+    this->memberNodes[fill[this->component[i]]++] = i;
+
+  /* edges between components, counted then stored */
+  qint32 *lastSource = fill; /* last component that had an edge to each component */
+
+  for ( c=0; c<C; ++c )
+    lastSource[c] = -1;
+
+  this->succOffsets = new qint32 [ C+1 ];
+  this->succOffsets[0] = 0;
+
+  for ( m=0; m<2; ++m )
+    {
+      k = 0;
+
+      for ( c=0; c<C; ++c )
+        {
+          for ( i=this->memberOffsets[c]; i<this->memberOffsets[c+1]; ++i )
+            {
+              const qint32 v = this->memberNodes[i];
+              child = csr.children ( v );
+
+              for ( qint32 j=0; j<csr.nbChildren(v); ++j )
+                {
+                  const qint32 d = this->component[child[j]];
+
+                  if ( ( d == c ) || ( lastSource[d] == c ) )
+                    continue;
+
+                  lastSource[d] = c;
+
+                  if ( m == 1 )
+                    this->succTargets[k] = d;
+
+                  ++k;
+                }
+            }
+
+          if ( m == 0 )
+            this->succOffsets[c+1] = k;
+        }
+
+      if ( m == 0 )
+        {
+          this->succTargets = new qint32 [ k+1 ];
+
+          for ( c=0; c<C; ++c )
+            lastSource[c] = -1;
+        }
+    }
+
+  delete [] fill;
+}
+
+
+/*
+ * Destructor
+ */
+SccCondensation::~SccCondensation ( )
+{
+  delete [] this->component;
+  delete [] this->memberOffsets;
+  delete [] this->memberNodes;
+  delete [] this->succOffsets;
+  delete [] this->succTargets;
+}
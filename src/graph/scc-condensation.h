@@ -0,0 +1,63 @@
+/*
+ * scc-condensation.h
+ *
+ * Declaration of the SccCondensation class.
+ * It finds the strongly connected components of a snapshot and
+ * builds the DAG of the components (the condensation of the graph).
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __SCC_CONDENSATION_H__
+#define __SCC_CONDENSATION_H__
+
+#include <QtCore>
+#include "graph-csr.h"
+
+
+class SccCondensation
+{
+ public:
+  SccCondensation ( const GraphCsr & );
+  ~SccCondensation ( );
+
+  inline qint32 nbComponents ( ) const { return nbComps; }
+  inline qint32 componentOf ( const qint32 i ) const { return component[i]; } /* components are numbered in topological order */
+
+  inline qint32 nbMembers ( const qint32 c ) const { return memberOffsets[c+1] - memberOffsets[c]; }
+  inline const qint32 *members ( const qint32 c ) const { return memberNodes + memberOffsets[c]; }
+
+  inline qint32 nbSuccessors ( const qint32 c ) const { return succOffsets[c+1] - succOffsets[c]; }
+  inline const qint32 *successors ( const qint32 c ) const { return succTargets + succOffsets[c]; } /* all greater than c */
+
+ private:
+  static qint32 findComponents ( const GraphCsr &, qint32 * );
+
+  qint32 nbNodes;
+  qint32 nbComps;
+  qint32 *component;         /* node index -> component */
+
+  qint32 *memberOffsets;     /* nodes of component c are memberNodes[memberOffsets[c] .. memberOffsets[c+1]-1] */
+  qint32 *memberNodes;
+  qint32 *succOffsets;       /* edges of the condensation, without duplicates */
+  qint32 *succTargets;
+
+} ;
+
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * synthetic-graph.h
+ *
+ * Random graphs generator shared by the test programs.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef __SYNTHETIC_GRAPH_H__
+#define __SYNTHETIC_GRAPH_H__
+
+#include "graph.h"
+
+
+/*
+ * Build a random graph with the given number of nodes, made of
+ * nb_subgraphs disconnected subgraphs of about the same size.
+ * Most edges go downward, a few go back up so that cycles exist.
+ */
+static Graph *
+build_synthetic_graph ( const int nb_nodes,
+                        const int nb_subgraphs=1 )
+{
+  Graph *g = new Graph ( );
+  QList<Node *> l;
+  Node *src, *dest;
+  int i, j;
+
+  srand ( 7 );
+
+  for ( i=0; i<nb_nodes; ++i )
+    {
+      Node *n = new Node ( g );
+      g->addNode ( n );
+      l.append ( n );
+    }
+
+  /* node i only links to the nodes before it in its own subgraph */
+  for ( i=nb_subgraphs; i<nb_nodes; ++i )
+    {
+      for ( j=0; j<2; ++j )
+        {
+          src = l[(rand()%(i/nb_subgraphs))*nb_subgraphs + i%nb_subgraphs];
+          dest = l[i];
+
+          if ( (rand() % 16) == 0 ) /* back edge */
+            {
+              dest = src;
+              src = l[i];
+            }
+
+          if ( src->hasChild(dest) )
+            continue;
+
+          src->addChild ( dest );
+          g->addEdge ( new Edge(src,dest) );
+        }
+    }
+
+  return g;
+}
+
+
+/*
+ * Build a layered DAG where each node points to the nb_children nodes
+ * that follow it: a chain when nb_children is 1, dense otherwise.
+ */
+static Graph *
+build_synthetic_dag ( const int nb_nodes,
+                      const int nb_children )
+{
+  Graph *g = new Graph ( );
+  QList<Node *> l;
+  int i, j;
+
+  for ( i=0; i<nb_nodes; ++i )
+    {
+      Node *n = new Node ( g );
+      g->addNode ( n );
+      l.append ( n );
+    }
+
+  for ( i=0; i<nb_nodes; ++i )
+    for ( j=i+1; ( j<=i+nb_children ) && ( j<nb_nodes ); ++j )
+      {
+        l[i]->addChild ( l[j] );
+        g->addEdge ( new Edge(l[i],l[j]) );
+      }
+
+  return g;
+}
+
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * union-find.h
+ *
+ * Declaration of the UnionFind class.
+ * Disjoint sets of node indexes, used to label the connected
+ * components of a graph without any recursion.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __UNION_FIND_H__
+#define __UNION_FIND_H__
+
+#include <QtCore>
+
+
+/*
+ * Flat union-find with path halving and union by rank.
+ * Each operation takes nearly constant amortized time.
+ */
+class UnionFind
+{
+ public:
+  UnionFind ( const qint32 n )
+  {
+    qint32 i;
+
+    this->parent = new qint32 [ n+1 ];
+    this->rank = new quint8 [ n+1 ];
+
+    for ( i=0; i<n; ++i )
+      {
+        this->parent[i] = i;
+        this->rank[i] = 0;
+      }
+  }
+
+  ~UnionFind ( )
+  {
+    delete [] this->parent;
+    delete [] this->rank;
+  }
+
+  /* representative of the set of i */
+  inline qint32 find ( qint32 i )
+  {
+    while ( this->parent[i] != i )
+      {
+        this->parent[i] = this->parent[this->parent[i]];
+        i = this->parent[i];
+      }
+
+    return i;
+  }
+
+  /* merge the sets of i and j */
+  inline void unite ( const qint32 i, const qint32 j )
+  {
+    qint32 a = this->find ( i );
+    qint32 b = this->find ( j );
+
+    if ( a == b )
+      return;
+
+    if ( this->rank[a] < this->rank[b] )
+      qSwap ( a, b );
+
+    this->parent[b] = a;
+
+    if ( this->rank[a] == this->rank[b] )
+      ++this->rank[a];
+  }
+
+ private:
+  qint32 *parent;
+  quint8 *rank;
+
+} ;
+
+
+#endif
@@ -26,6 +26,7 @@
  * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+#include <QtConcurrent>
 #include "application.h"
 #include "parser/entitylist.h"
 #include "parser/defs.h"
@@ -37,6 +38,9 @@
 #include "group-simple.h"
 
 
+bool GraphView::parallelReading = false;
+
+
 /*
  * Constructor
  */
@@ -54,6 +58,11 @@ GraphView::GraphView ( QWidget *parent )
   this->timeline.setCurveShape ( QTimeLine::EaseInOutCurve );
   connect ( &this->timeline, SIGNAL(valueChanged(qreal)), this, SLOT(changeViewPos(qreal)) );
 
+  this->layoutJob = NULL;
+  this->layoutRequested = false;
+  this->layoutCache = NULL;
+  connect ( &this->layoutWatcher, SIGNAL(finished()), this, SLOT(layoutFinished()) );
+
   this->graph = NULL;
 
   this->undoStack = new QUndoStack ( this );
@@ -66,20 +75,185 @@ GraphView::GraphView ( QWidget *parent )
 }
 
 
+/*
+ * Visitor used to build the graph of a view while its file is read.
+ * Edges and group contents that come before their nodes are resolved
+ * once the whole file is read. Edges are only resolved against plain
+ * nodes, since the groups are known before the pending edges are.
+ */
+class GraphViewLoader : public EntityVisitor
+{
+ public:
+  GraphViewLoader ( GraphView *v ) : v(v) { }
+
+  void onInfo ( Entity *e )
+  {
+    const char *attr_v = e->getValueOfAttribute ( NAME_INFO_TITLE );
+
+    if ( attr_v != NULL )
+      v->title = QString::fromLatin1 ( attr_v ); // QString::fromAscii
+  }
+
+  void onNode ( Entity *e )
+  {
+    const char *attr_v = e->getValueOfAttribute ( NAME_NODE_SHAPE );
+    AbstractNodeShape *node;
+
+    if ( attr_v == NULL )
+      node = new NodeEllipse ( v );
+    else if ( strcmp(attr_v,NODE_SHAPE_ELLIPSE) == 0 )
+      node = new NodeEllipse ( v );
+    else if ( strcmp(attr_v,NODE_SHAPE_RECTANGLE)  == 0 )
+      node = new NodeRectangle ( v );
+    else if ( strcmp(attr_v,NODE_SHAPE_CIRCLE)  == 0 )
+      node = new NodeCircle ( v );
+    else
+      {
+        node = new NodeEllipse ( v );
+        std::cerr << "warning: node shape \'" << attr_v << "\' is invalid.\n";
+      }
+
+    node->initFromEntity ( e );
+    v->graph->addNode ( node );
+    v->scene()->addItem ( (AbstractNodeShape *) node );
+    nodes.insert ( node->id, node );
+  }
+
+  void onEdge ( Entity *e )
+  {
+    if ( !addEdge(e,false) )
+      pendingEdges.addCopyOfEntity ( e );
+  }
+
+  void onGroup ( Entity *e )
+  {
+    AbstractGroupShape *group;
+    Attribute *a;
+    AttributeStrings contents;
+    unsigned int i;
+
+    a = e->getAttribute ( NAME_GROUP_CONTENTS );
+
+    if ( a == NULL )
+      return;
+
+    contents = a->getValueAsListOfString ( );
+
+    if ( contents.size() == 0 )
+      return;
+
+    group = new GroupSimple ( v );
+    group->initFromEntity ( e );
+
+    for ( i=0; i<contents.size(); ++i )
+      {
+        const QString qstr ( contents[i] );
+        AbstractNodeShape *node = (AbstractNodeShape *) v->graph->getNode ( qstr );
+
+        if ( node != NULL )
+          {
+            group->addShape ( node );
+            node->setGroup ( group );
+          }
+        else
+          toBeLoaded.insertMulti ( group, qstr ); /* will be loaded after all groups are created */
+      }
+
+    v->graph->addNode ( group );
+    v->scene()->addItem ( group );
+    v->groups.insert ( group->id, group );
+  }
+
+  /*
+   * Add the edges and group contents that came before their nodes.
+   */
+  void finish ( )
+  {
+    EntityList::iterator iter = pendingEdges.iterate ( );
+
+    while ( iter.hasNext() )
+      addEdge ( iter.next(), true );
+
+    pendingEdges.clear ( );
+
+    /* insert the nodes and subgroups */
+    QHashIterator<AbstractGroupShape *, QString> iterContents ( toBeLoaded );
+    AbstractGroupShape *group;
+    AbstractNodeShape *node;
+    QString qstr;
+
+    while ( iterContents.hasNext() )
+      {
+        iterContents.next ( );
+        group = iterContents.key ( );
+        qstr = iterContents.value ( );
+        node = (AbstractNodeShape *) v->graph->getNode ( qstr );
+
+        if ( node != NULL )
+          {
+            group->addShape ( node );
+            node->setGroup ( group );
+          }
+      }
+
+    toBeLoaded.clear ( );
+  }
+
+ private:
+  /*
+   * Add an edge, if its nodes are known (or if it is the last chance).
+   * Returns false if it has to wait for its nodes.
+   */
+  bool addEdge ( Entity *e,
+                 const bool last )
+  {
+    EdgeSimple *edge;
+    AbstractNodeShape *src, *dest;
+    QString qstr;
+
+    qstr = Node::extractNodeName( e->getValueOfAttribute(NAME_EDGE_SRC_PORT) );
+    src = nodes.value ( qstr );
+
+    qstr = Node::extractNodeName( e->getValueOfAttribute(NAME_EDGE_DEST_PORT) );
+    dest = nodes.value ( qstr );
+
+    if ( ( src == NULL ) || ( dest == NULL ) )
+      return last;
+
+    edge = new EdgeSimple ( src, dest );
+    edge->initFromEntity ( e );
+
+    if ( src != dest )
+      {
+        v->scene()->addItem ( edge );
+        v->graph->addEdge ( edge );
+        src->addChild ( dest );
+      }
+    else
+      src->addLoopingEdge ( edge );
+
+    return true;
+  }
+
+  GraphView *v;
+  QHash<QString, AbstractNodeShape *> nodes; /* plain nodes only: edges never end on a group */
+  EntityList pendingEdges;
+  QHash<AbstractGroupShape *, QString> toBeLoaded;
+} ;
+
+
 /*
  * Load a graph from a file.
+ * The file is streamed: its entities are not kept once handled.
+ * It is read in situ, and in parallel if parallelReading is set.
+ * Nodes, edges and groups are added in file order, the edges naming a
+ * node declared after them coming last (see graph-test -o); the same
+ * file, compiled or not, thus always gives the same layout.
  */
 void
 GraphView::loadGraphFromFile ( const char *file_name )
 {
-  EntityList *el;
-  Entity *e;
-  EntityList::iterator iter;
-  const char *attr_v;
-  AbstractNodeShape *node;
-
-  el = new EntityList ( );
-  el->parseFromFile ( file_name );
+  AbstractGroupShape *group;
 
   /* close current graph if any */
   this->closeGraph ( );
@@ -90,141 +264,11 @@ GraphView::loadGraphFromFile ( const char *file_name )
   this->finfo = QFileInfo ( file_name );
   this->title = QString::fromLatin1 ( "untitled" ); // QString::fromAscii ( "untitled" );
 
-  /* info loading */
-  iter = el->iterate ( ENTITY_INFO );
-
-  while ( iter.hasNext() )
-    {
-      e = iter.next ( );
-      attr_v = e->getValueOfAttribute ( ATTR_INFO_TITLE );
-
-      if ( attr_v != NULL )
-        this->title = QString::fromLatin1 ( attr_v ); // QString::fromAscii
-    }
-
-  /* node loading */
-  iter = el->iterate ( ENTITY_NODE );
-
-  while ( iter.hasNext() )
-    {
-      e = iter.next ( );
-      attr_v = e->getValueOfAttribute ( ATTR_NODE_SHAPE );
-
-      if ( attr_v == NULL )
-        node = new NodeEllipse ( this );
-      else if ( strcmp(attr_v,NODE_SHAPE_ELLIPSE) == 0 )
-        node = new NodeEllipse ( this );
-      else if ( strcmp(attr_v,NODE_SHAPE_RECTANGLE)  == 0 )
-        node = new NodeRectangle ( this );
-      else if ( strcmp(attr_v,NODE_SHAPE_CIRCLE)  == 0 )
-        node = new NodeCircle ( this );
-      else
-        {
-          node = new NodeEllipse ( this );
-          std::cerr << "warning: node shape \'" << attr_v << "\' is invalid.\n";
-        }
-
-      node->initFromEntity ( e );
-      this->graph->addNode ( node );
-      this->scene()->addItem ( (AbstractNodeShape *) node );
-    }
-
-  /* edge loading */
-  EdgeSimple *edge;
-  AbstractNodeShape *src, *dest;
-  QString qstr;
-
-  iter = el->iterate ( ENTITY_EDGE );
-
-  while ( iter.hasNext() )
-    {
-      e = iter.next ( );
-
-      qstr = Node::extractNodeName( e->getValueOfAttribute(ATTR_EDGE_SRC_PORT) );
-      src = (AbstractNodeShape *) this->graph->getNode ( qstr );
-
-      if ( src == NULL )
-        continue;
-
-      qstr = Node::extractNodeName( e->getValueOfAttribute(ATTR_EDGE_DEST_PORT) );
-      dest = (AbstractNodeShape *) this->graph->getNode ( qstr );
-
-      if ( dest == NULL )
-        continue;
-
-      edge = new EdgeSimple ( src, dest );
-      edge->initFromEntity ( e );
-
-      if ( src != dest )
-        {
-          this->scene()->addItem ( edge );
-          this->graph->addEdge ( edge );
-          src->addChild ( dest );
-        }
-      else
-        src->addLoopingEdge ( edge );
-    }
-
-  /* group loading */
-  AbstractGroupShape *group;
-  Attribute *a;
-  QStringList *contents;
-  QHash<AbstractGroupShape *, QString> toBeLoaded;
-
-  iter = el->iterate ( ENTITY_GROUP );
-
-  while ( iter.hasNext() )
-    {
-      e = iter.next ( );
-
-      a = e->getAttribute ( ATTR_GROUP_CONTENTS );
-      contents = a->getValueAsListOfString ( );
+  /* info, node, edge and group loading */
+  GraphViewLoader loader ( this );
 
-      if ( contents->size() == 0 )
-        {
-          delete contents;
-          continue;
-        }
-
-      group = new GroupSimple ( this );
-      group->initFromEntity ( e );
-
-      foreach ( qstr, *contents )
-        {
-          node = (AbstractGroupShape *) this->graph->getNode ( qstr );
-
-          if ( node != NULL )
-            {
-              group->addShape ( node );
-              node->setGroup ( group );
-            }
-          else
-            toBeLoaded.insertMulti ( group, qstr ); /* will be loaded after all groups are created */
-        }
-
-      this->graph->addNode ( group );
-      this->scene()->addItem ( group );
-      this->groups.insert ( group->id, group );
-
-      delete contents;
-    }
-
-  /* insert subgroups */
-  QHashIterator<AbstractGroupShape *, QString> iterSubGroups ( toBeLoaded );
-  AbstractGroupShape *subgroup;
-
-  while ( iterSubGroups.hasNext() )
-    {
-      iterSubGroups.next ( );
-      group = iterSubGroups.key ( );
-      subgroup = this->groups.value ( iterSubGroups.value() );
-
-      if ( subgroup != NULL )
-        {
-          group->addShape ( subgroup );
-          subgroup->setGroup ( group );
-        }
-    }
+  EntityList::visitFile ( file_name, &loader, true, GraphView::parallelReading );
+  loader.finish ( );
 
   /* freeze groups content and collapse them */
   QList<AbstractEdgeShape *> *l;
@@ -245,8 +289,11 @@ GraphView::loadGraphFromFile ( const char *file_name )
   /* assign subgraph IDs */
   this->graph->assignSubgraphIDs ( );
 
-  /* destroy parser */
-  delete el;
+  /* layouts computed in this session, and in previous ones if enabled */
+  if ( LayoutCache::enabled )
+    this->layoutCache = new LayoutCache ( LayoutCache::sidecarOf(this->finfo.absoluteFilePath()), this->graph );
+  else
+    this->layoutCache = new LayoutCache ( QString(), this->graph );
 
   /* collapse all the groups without syncing the view */
   this->collapseAll ( false );
@@ -320,15 +367,104 @@ GraphView::computeGridHVSpacing ( const QPair<quint32, quint32> &gridMax )
 
 /*
  * Synchronize the graph and its display.
+ * The layout runs on a snapshot of the graph in a worker thread,
+ * the shapes move when it is over (see layoutFinished).
+ * A fold state whose layout is in the cache is displayed at once.
  */
 void
 GraphView::synchronizeView ( )
 {
-  AbstractNodeShape *node;
   QPair<quint32, quint32> gridMax;
 
-  /* graph layering */
-  gridMax = this->graph->assignGridCoordinates ( );
+  if ( this->graph == NULL )
+    return;
+
+  /* a newer layout supersedes the running one */
+  if ( this->layoutJob != NULL )
+    {
+      this->layoutJob->cancel ( );
+      this->layoutRequested = true;
+      return;
+    }
+
+  if ( this->layoutCache != NULL )
+    {
+      this->layoutKey = this->layoutCache->keyOf ( this->graph );
+
+      if ( this->layoutCache->restore(this->graph,this->layoutKey,gridMax) )
+        {
+          this->displayLayout ( gridMax, true );
+          return;
+        }
+    }
+
+  this->layoutJob = new LayoutJob ( this->graph );
+  this->layoutWatcher.setFuture ( QtConcurrent::run(this->layoutJob, &LayoutJob::run) );
+}
+
+
+/*
+ * Callback for the end of the layout thread.
+ */
+void
+GraphView::layoutFinished ( )
+{
+  LayoutJob *job = this->layoutJob;
+  QString nname;
+
+  if ( ( job == NULL ) || ( !this->layoutWatcher.isFinished() ) )
+    return;
+
+  this->layoutJob = NULL;
+
+  if ( job->apply() )
+    {
+      /* the fold state may have changed without a synchronization */
+      if ( ( this->layoutCache != NULL ) && ( this->layoutCache->keyOf(this->graph) == this->layoutKey ) )
+        this->layoutCache->store ( this->graph, this->layoutKey, job->getGridMax() );
+
+      this->displayLayout ( job->getGridMax() );
+    }
+
+  delete job;
+
+  if ( this->layoutRequested )
+    {
+      this->layoutRequested = false;
+      this->synchronizeView ( ); /* may be displayed at once if cached */
+    }
+
+  if ( ( this->layoutJob == NULL ) && ( this->pendingFocus.size() != 0 ) )
+    {
+      nname = this->pendingFocus;
+      this->pendingFocus.clear ( );
+      this->focusOn ( nname );
+    }
+}
+
+
+/*
+ * Wait for the pending layout (if any) to be displayed.
+ */
+void
+GraphView::waitForLayout ( )
+{
+  while ( this->layoutJob != NULL )
+    {
+      this->layoutWatcher.waitForFinished ( );
+      this->layoutFinished ( );
+    }
+}
+
+
+/*
+ * Move the shapes to the grid coordinates of their node.
+ */
+void
+GraphView::displayLayout ( const QPair<quint32, quint32> &gridMax,
+                           bool cached )
+{
+  AbstractNodeShape *node;
 
   /* compute grid cells size */
   if ( (gridMax.first+1) > gridSize.first )
@@ -368,6 +504,20 @@ GraphView::synchronizeView ( )
   const qreal w = this->gridCellHCenter[gridMax.first]+this->gridCellHSize[gridMax.first]+this->HSpacing();
   const qreal h = this->gridCellVCenter[gridMax.second]+this->gridCellVSize[gridMax.second]+this->VSpacing();
   this->scene()->setSceneRect ( this->HSpacing()/1.7, 0.0, w, h );
+
+  /* layout latency */
+  if ( this->hasApp() )
+    {
+      QString msg;
+
+      if ( cached )
+        msg = QString::fromLatin1 ( "cached layout" );
+      else
+        msg.sprintf ( "%s layout in %lld ms", ( this->graph->wasLastLayoutIncremental() ) ? "incremental" : "full",
+                      (long long) this->graph->getLastLayoutTime() );
+
+      this->app->statusDisplay()->showMessage ( msg, 2000 );
+    }
 }
 
 
@@ -377,6 +527,8 @@ GraphView::synchronizeView ( )
 QImage *
 GraphView::getImage ( )
 {
+  this->waitForLayout ( );
+
   QImage *img = new QImage ( this->width(), this->height(), QImage::Format_ARGB32_Premultiplied );
   img->fill ( 0 );
 
@@ -397,6 +549,8 @@ GraphView::getImage ( )
 void
 GraphView::print ( QPrinter *printer )
 {
+  this->waitForLayout ( );
+
   QPainter *p  = new QPainter ( printer );
   p->setRenderHint ( QPainter::Antialiasing );
   p->setRenderHint ( QPainter::TextAntialiasing );
@@ -454,6 +608,12 @@ GraphView::focusOn ( QString &nname )
 
   AbstractNodeShape *n = (AbstractNodeShape *) this->graph->getNode ( nname );
 
+  if ( ( n != NULL ) && ( this->layoutJob != NULL ) ) /* the node is about to move */
+    {
+      this->pendingFocus = nname;
+      return true;
+    }
+
   if ( n != NULL )
     {
       this->viewPos = QLineF ( this->center(), n->finalCenter() );
@@ -890,6 +1050,24 @@ GraphView::center ( ) const
 void
 GraphView::closeGraph ( )
 {
+  if ( this->layoutJob != NULL )
+    {
+      this->layoutJob->cancel ( );
+      this->layoutWatcher.waitForFinished ( );
+      delete this->layoutJob;
+      this->layoutJob = NULL;
+    }
+
+  this->layoutRequested = false;
+  this->pendingFocus.clear ( );
+
+  if ( this->layoutCache != NULL )
+    {
+      this->layoutCache->save ( );
+      delete this->layoutCache;
+      this->layoutCache = NULL;
+    }
+
   if ( this->graph != NULL )
     delete this->graph;
 
@@ -32,8 +32,11 @@
 #include <QUndoCommand>
 #include <QUndoStack>
 #include <QUndoStack>
+#include <QFutureWatcher>
 
 #include "graph/graph.h"
+#include "graph/layout-job.h"
+#include "graph/layout-cache.h"
 #include "abstractgroupshape.h"
 
 class AppKroket;
@@ -56,6 +59,7 @@ class GraphView : public QGraphicsView
   void loadGraphFromFile ( const char * );          /* open a graph description file */
   inline Graph *getGraph ( ) const { return this->graph; }
   void synchronizeView ( );                         /* synchronize the view with the graph (layout, display, etc.) */
+  void waitForLayout ( );                           /* wait for the pending layout to be displayed */
   QImage *getImage ( );                             /* output the view to an image */
   void print ( QPrinter * );                        /* print the view */
   bool focusOn ( QString & );                       /* focus on the specified node */
@@ -97,8 +101,11 @@ class GraphView : public QGraphicsView
 
   void reset ( );
 
+  static bool parallelReading;      /* read the graph files in parallel chunks, apart from the parallel layout */
+
  public Q_SLOTS:
   void changeViewPos ( qreal ); /* slot for the animations timeline */
+  void layoutFinished ( );      /* slot for the layout thread */
 
  protected:
   virtual void paintEvent ( QPaintEvent * );
@@ -108,6 +115,7 @@ class GraphView : public QGraphicsView
   virtual void mouseReleaseEvent ( QMouseEvent * );
 
   void adaptEdgesWidth ( );    /* adapt the width of edges according to the zoom factor */
+  void displayLayout ( const QPair<quint32, quint32> &, bool cached=false ); /* move the shapes to their grid coordinates */
 
 
   AppKroket *app;
@@ -128,6 +136,18 @@ class GraphView : public QGraphicsView
   /* undo stack */
   QUndoStack *undoStack;
 
+  /* layout thread */
+  LayoutJob *layoutJob;              /* running layout, NULL if none */
+  bool layoutRequested;              /* another layout has to run after it */
+  QString pendingFocus;              /* node to focus on once laid out */
+  QFutureWatcher<void> layoutWatcher;
+
+  /* known layouts */
+  LayoutCache *layoutCache;          /* NULL if no graph is loaded */
+  QByteArray layoutKey;              /* fold state of the running layout */
+
+  friend class GraphViewLoader;
+
 } ;
 
 
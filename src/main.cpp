@@ -23,8 +23,10 @@
  */
 
 #include <QApplication>
+#include <QThreadPool>
 #include <getopt.h>
 
+#include "parser/entitylist.h"
 #include "application.h"
 
 
@@ -34,7 +36,7 @@
 /*
  * options array (used by getopt)
  */
-static const char * options = "vhEe:Cc:f:t:w:W:";
+static const char * options = "vhEe:Cc:f:t:w:W:a:l:Fij:RpS:s";
 
 static struct option long_options[] = {
   {"version",      0, NULL, 'v'},
@@ -47,6 +49,15 @@ static struct option long_options[] = {
   {"trace",        1, NULL, 't'},
   {"with",         1, NULL, 'w'},
   {"without",      1, NULL, 'W' },
+  {"acyclic",      1, NULL, 'a' },
+  {"layering",     1, NULL, 'l' },
+  {"full-layout",  0, NULL, 'F' },
+  {"incremental",  0, NULL, 'i' },
+  {"threads",      1, NULL, 'j' },
+  {"serial-read",  0, NULL, 'R' },
+  {"pack",         0, NULL, 'p' },
+  {"seed",         1, NULL, 'S' },
+  {"save-layouts", 0, NULL, 's' },
   {NULL,           0, NULL,  0 }
 };
 
@@ -57,7 +68,8 @@ static struct option long_options[] = {
 void
 usage ( void )
 {
-  fprintf ( stderr, "\nusage: %s [options] file\n\n", KROKET_BIN );
+  fprintf ( stderr, "\nusage: %s [options] file\n"                    \
+                    "       %s --compile file.kk file.kkb\n\n", KROKET_BIN, KROKET_BIN );
 
   fprintf ( stderr, "General Options:\n\t"                                            \
                     "-h, --help\t\tshow this help\n\t"                                \
@@ -70,7 +82,42 @@ usage ( void )
                      "-f ID, --focus=ID\tfocus on the specified node\n\t"             \
                      "-t ID, --trace=ID\ttrace from the specified node\n\t"           \
                      "-w TAG, --with=TAG\tshow only nodes with the specified tag\n\t" \
-                     "-W TAG, --without=TAG\tshow only nodes without the specified tag\n\n" );
+                     "-W TAG, --without=TAG\tshow only nodes without the specified tag\n\n" \
+                    "Layout Options:\n\t"                                            \
+                     "-a ALGO, --acyclic=ALGO\tcycle removal before the layering: none (default) or greedy\n\t" \
+                     "-l ALGO, --layering=ALGO\tlayering algorithm: bfs (default) or floyd\n\t" \
+                     "-F, --full-layout\tlayout the whole graph on each expand/collapse (default)\n\t" \
+                     "-i, --incremental\tkeep the nodes in place on expand/collapse (the layers are still recomputed)\n\t" \
+                     "-j N, --threads=N\tuse N threads to read the graph, order and place the nodes (default 1)\n\t" \
+                     "-R, --serial-read\tread the graph on one thread, even with -j\n\t" \
+                     "-p, --pack\t\tlayout the unconnected parts apart and pack them side by side\n\t" \
+                     "-S SEED, --seed=SEED\tplace the nodes the same way on each run\n\t" \
+                     "-s, --save-layouts\tkeep the known layouts in a FILE.layout file next to FILE\n\n" );
+}
+
+
+/*
+ * Compile a text file into a binary file that opens faster.
+ */
+static int
+compile ( const char *in,
+          const char *out )
+{
+  EntityList el;
+
+  try
+    {
+      el.parseFromFile ( in, true );
+      el.compileToFile ( out );
+    }
+  catch ( ParserException *e )
+    {
+      fprintf ( stderr, "cannot compile '%s': %s\n", in, e->what() );
+      delete e;
+      return -1;
+    }
+
+  return 0;
 }
 
 
@@ -91,6 +138,20 @@ main ( int argc,
   bool collapseAll = false;
   QStringList collapse;
 
+  bool serialRead = false;
+
+
+  /* compiling needs no display */
+  if ( ( argc > 1 ) && ( strcmp(argv[1],"--compile") == 0 ) )
+    {
+      if ( argc != 4 )
+        {
+          usage ( );
+          return -1;
+        }
+
+      return compile ( argv[2], argv[3] );
+    }
 
   QApplication app ( argc, argv );
 
@@ -164,6 +225,101 @@ main ( int argc,
             break;
           }
 
+        case 'a':
+          {
+            if ( strcmp(optarg,"none") == 0 )
+              Graph::defaultAcyclicMode = ACYCLIC_NONE;
+            else if ( strcmp(optarg,"greedy") == 0 )
+              Graph::defaultAcyclicMode = ACYCLIC_GREEDY;
+            else
+              {
+                fprintf ( stderr, "unknown cycle removal algorithm '%s'\n", optarg );
+                usage ( );
+                return -1;
+              }
+            break;
+          }
+
+        case 'l':
+          {
+            if ( strcmp(optarg,"floyd") == 0 )
+              Graph::defaultLayeringMode = LAYERING_FLOYD;
+            else if ( strcmp(optarg,"bfs") == 0 )
+              Graph::defaultLayeringMode = LAYERING_BFS;
+            else
+              {
+                fprintf ( stderr, "unknown layering algorithm '%s'\n", optarg );
+                usage ( );
+                return -1;
+              }
+            break;
+          }
+
+        case 'F':
+          {
+            Graph::defaultIncrementalLayout = false;
+            break;
+          }
+
+        case 'i':
+          {
+            Graph::defaultIncrementalLayout = true;
+            break;
+          }
+
+        case 'j':
+          {
+            const int nb_threads = atoi ( optarg );
+
+            if ( nb_threads < 1 )
+              {
+                fprintf ( stderr, "invalid number of threads '%s'\n", optarg );
+                usage ( );
+                return -1;
+              }
+
+            Graph::defaultParallelLayout = ( nb_threads > 1 );
+            GraphView::parallelReading = ( nb_threads > 1 ) && !serialRead;
+            QThreadPool::globalInstance()->setMaxThreadCount ( nb_threads );
+            break;
+          }
+
+        case 'R':
+          {
+            serialRead = true;
+            GraphView::parallelReading = false;
+            break;
+          }
+
+        case 'p':
+          {
+            Graph::defaultComponentLayout = true;
+            break;
+          }
+
+        case 'S':
+          {
+            char *end;
+            const unsigned long long seed = strtoull ( optarg, &end, 10 );
+
+            if ( ( *optarg == '\0' ) || ( *end != '\0' ) )
+              {
+                fprintf ( stderr, "invalid seed '%s'\n", optarg );
+                usage ( );
+                return -1;
+              }
+
+            Graph::defaultSeededLayout = true;
+            Graph::defaultLayoutSeed = seed;
+            break;
+          }
+
+        case 's':
+          {
+            LayoutCache::enabled = true;
+            break;
+          }
+
         default:
           break;
         }
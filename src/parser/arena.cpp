@@ -0,0 +1,209 @@
+/*
+ * arena.cpp
+ *
+ * Implementation of the Arena class.
+ *
+ * Memory is requested from the system in blocks of 64 KiB, which
+ * are filled in turn. Larger requests get a block of their own.
+ * Nothing is freed before the arena is reset: the objects carved
+ * from an arena are never destroyed.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "arena.h"
+
+
+#define BLOCK_SIZE  (64*1024)
+#define HEADER_SIZE ((sizeof(block)+7) & ~((size_t) 7))
+
+
+/*
+ * Constructor
+ */
+Arena::Arena ( )
+{
+  this->blocks = NULL;
+  this->ptr = NULL;
+  this->left = 0;
+}
+
+
+/*
+ * Allocate memory in a new block.
+ */
+void *
+Arena::allocateInNewBlock ( const size_t size )
+{
+  block *b;
+  char *data;
+
+  if ( size > BLOCK_SIZE/4 ) /* large request: dedicated block, the current one stays in use */
+    {
+      b = (block *) malloc ( HEADER_SIZE + size );
+
+      if ( b == NULL )
+        throw std::bad_alloc ( );
+
+      if ( this->blocks == NULL )
+        {
+          b->next = NULL;
+          this->blocks = b;
+        }
+      else
+        {
+          b->next = this->blocks->next;
+          this->blocks->next = b;
+        }
+
+      return ((char *) b) + HEADER_SIZE;
+    }
+
+  b = (block *) malloc ( BLOCK_SIZE );
+
+  if ( b == NULL )
+    throw std::bad_alloc ( );
+
+  b->next = this->blocks;
+  this->blocks = b;
+
+  data = ((char *) b) + HEADER_SIZE;
+  this->ptr = data + size;
+  this->left = BLOCK_SIZE - HEADER_SIZE - size;
+
+  return data;
+}
+
+
+/*
+ * Copy a string (which needs not be null-terminated).
+ */
+const char *
+Arena::copy ( const char *str,
+              const size_t length )
+{
+  char *c = (char *) this->allocate ( length + 1 );
+
+  memcpy ( c, str, length );
+  c[length] = '\0';
+
+  return c;
+}
+
+
+/*
+ * Copy a null-terminated string.
+ */
+const char *
+Arena::copy ( const char *str )
+{
+  return this->copy ( str, strlen(str) );
+}
+
+
+/*
+ * Free all the memory allocated from the arena.
+ */
+void
+Arena::reset ( )
+{
+  block *b;
+
+  while ( this->blocks != NULL )
+    {
+      b = this->blocks;
+      this->blocks = b->next;
+      free ( b );
+    }
+
+  this->ptr = NULL;
+  this->left = 0;
+}
+
+
+/*
+ * Free all the memory allocated from the arena,
+ * except the current block which is reused from its start.
+ */
+void
+Arena::rewind ( )
+{
+  block *b;
+
+  if ( this->ptr == NULL ) /* no current block */
+    {
+      this->reset ( );
+      return;
+    }
+
+  while ( this->blocks->next != NULL )
+    {
+      b = this->blocks->next;
+      this->blocks->next = b->next;
+      free ( b );
+    }
+
+  this->ptr = ((char *) this->blocks) + HEADER_SIZE;
+  this->left = BLOCK_SIZE - HEADER_SIZE;
+}
+
+
+/*
+ * Take all the memory of another arena, which is left empty.
+ * It is freed along with the memory of this arena.
+ */
+void
+Arena::adopt ( Arena &other )
+{
+  block *tail;
+
+  if ( other.blocks == NULL )
+    return;
+
+  if ( this->blocks == NULL )
+    {
+      this->blocks = other.blocks;
+      this->ptr = other.ptr;
+      this->left = other.left;
+    }
+  else
+    {
+      /* the current block stays the first one */
+      for ( tail=other.blocks; tail->next!=NULL; tail=tail->next ) ;
+
+      tail->next = this->blocks->next;
+      this->blocks->next = other.blocks;
+    }
+
+  other.blocks = NULL;
+  other.ptr = NULL;
+  other.left = 0;
+}
+
+
+/*
+ * Destructor
+ */
+Arena::~Arena ( )
+{
+  this->reset ( );
+}
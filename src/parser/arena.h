@@ -0,0 +1,79 @@
+/*
+ * arena.h
+ *
+ * Declaration of the Arena class.
+ * It is a bump allocator: objects are carved one after the other
+ * from large blocks, and are all freed at once.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <cstddef>
+
+
+class Arena
+{
+
+ public:
+  Arena ( );
+  ~Arena ( );
+
+  /*
+   * Allocate memory for an object (8 bytes aligned).
+   * The memory is only freed when the arena is reset.
+   */
+  inline void *allocate ( size_t size )
+    {
+      size = ( size + 7 ) & ~((size_t) 7);
+
+      if ( size > this->left )
+        return this->allocateInNewBlock ( size );
+
+      void *ptr = this->ptr;
+      this->ptr += size;
+      this->left -= size;
+
+      return ptr;
+    }
+
+  const char *copy ( const char *, const size_t ); /* null-terminated copy of a string */
+  const char *copy ( const char * );
+
+  void reset ( );                                  /* free everything at once */
+  void rewind ( );                                 /* same, but keep a block for the next objects */
+  void adopt ( Arena & );                          /* take the memory of another arena */
+
+ private:
+  void *allocateInNewBlock ( const size_t );
+
+  struct block
+  {
+    block *next;
+  } ;
+
+  block *blocks;   /* most recent first */
+  char *ptr;       /* free space of the current block */
+  size_t left;
+
+} ;
+
+
+#endif
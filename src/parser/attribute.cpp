@@ -25,28 +25,46 @@
 
 #include <cassert>
 #include <unistd.h>
+#include <cstring>
+#include <charconv>
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <new>
 
 #include "masked_isspace.h"
+#include "nametable.h"
 #include "attribute.h"
 
 
 /*
  * Constructor
+ * The value is copied into the arena of the attribute. In situ, the name
+ * is already interned and the value is not copied: it has to live as
+ * long as the attribute.
  */
-Attribute::Attribute ( const char *name,
-                       const char *value )
+Attribute::Attribute ( Arena *arena,
+                       const char *name,
+                       const char *value,
+                       const bool inSitu )
 {
+  assert ( arena != NULL );
   assert ( name != NULL );
 
-  this->name.assign ( name );
+  this->arena = arena;
+  this->parsed_type = PARSED_NONE;
 
-  if ( value != NULL )
-    this->value.assign ( value );
-  else
-    this->value.assign ( "" );
+  if ( inSitu )
+    {
+      assert ( value != NULL );
+
+      this->name = name;
+      this->value = value;
+      return;
+    }
+
+  this->name = NameTable::intern ( name );
+  this->value = this->arena->copy ( ( value != NULL ) ? value : "" );
 }
 
 
@@ -57,7 +75,7 @@ Attribute::Attribute ( const char *name,
 bool
 Attribute::isNamed ( const char *str ) const
 {
-  return ( this->name.compare(str) == 0 );
+  return ( this->name == str ) || ( strcmp(this->name,str) == 0 );
 }
 
 
@@ -67,7 +85,8 @@ Attribute::isNamed ( const char *str ) const
 void
 Attribute::setValue ( const char *str )
 {
-  this->value.assign ( str );
+  this->value = this->arena->copy ( str );
+  this->parsed_type = PARSED_NONE;
 }
 
 
@@ -80,7 +99,9 @@ Attribute::setValue ( const int v )
   std::ostringstream oss;
 
   oss << v;
-  this->value.assign ( oss.str() );
+  this->value = this->arena->copy ( oss.str().c_str() );
+  this->parsed.i = v;
+  this->parsed_type = PARSED_INT;
 }
 
 
@@ -93,7 +114,8 @@ Attribute::setValue ( const double v )
   std::ostringstream oss;
 
   oss << v;
-  this->value.assign ( oss.str() );
+  this->value = this->arena->copy ( oss.str().c_str() );
+  this->parsed_type = PARSED_NONE;
 }
 
 
@@ -123,7 +145,8 @@ Attribute::setValue ( Douple *d )
 
   oss << ")";
 
-  this->value.assign ( oss.str() );
+  this->value = this->arena->copy ( oss.str().c_str() );
+  this->parsed_type = PARSED_NONE;
 }
 
 
@@ -153,7 +176,8 @@ Attribute::setValue ( QStringList *v )
 
   oss << "]";
 
-  this->value.assign ( oss.str() );
+  this->value = this->arena->copy ( oss.str().c_str() );
+  this->parsed_type = PARSED_NONE;
 }
 
 
@@ -200,17 +224,43 @@ Attribute::setValue ( QList<Douple *> *v )
 
   oss << "]";
 
-  this->value.assign ( oss.str() );
+  this->value = this->arena->copy ( oss.str().c_str() );
+  this->parsed_type = PARSED_NONE;
 }
 
 
 /*
- * Get the attribute's value.
+ * Skip the whitespaces and the plus sign std::from_chars does not accept.
  */
-const char *
-Attribute::getValue ( ) const
+static inline const char *
+skip_to_number ( const char *str,
+                 const char *end )
 {
-  return this->value.c_str();
+  while ( ( str < end ) && _isspace(*str) )
+    ++str;
+
+  if ( ( str+1 < end ) && ( str[0] == '+' ) && ( str[1] != '-' ) )
+    ++str;
+
+  return str;
+}
+
+
+/*
+ * Read a double from a string of the provided length.
+ * Returns 0.0 if the string does not start with a number.
+ */
+static inline double
+parse_double ( const char *str,
+               const size_t length )
+{
+  const char *end = str + length;
+  double v;
+
+  if ( std::from_chars(skip_to_number(str,end),end,v).ec != std::errc() )
+    return 0.0;
+
+  return v;
 }
 
 
@@ -220,13 +270,19 @@ Attribute::getValue ( ) const
 int
 Attribute::getValueAsInt ( ) const
 {
-  int v;
-  std::istringstream iss ( this->value );
+  if ( this->parsed_type != PARSED_INT )
+    {
+      const char *end = this->value + strlen ( this->value );
+      int v;
 
-  if ( (iss >> std::dec >> v).fail() )
-    return 0;
+      if ( std::from_chars(skip_to_number(this->value,end),end,v).ec != std::errc() )
+        v = 0;
 
-  return v;
+      this->parsed.i = v;
+      this->parsed_type = PARSED_INT;
+    }
+
+  return this->parsed.i;
 }
 
 
@@ -236,230 +292,306 @@ Attribute::getValueAsInt ( ) const
 double
 Attribute::getValueAsDouble ( ) const
 {
-  double v;
-
-  std::istringstream iss ( this->value );
-
-  if ( (iss >> std::dec >> v).fail() )
-    return 0.0;
+  if ( this->parsed_type != PARSED_DOUBLE )
+    {
+      this->parsed.d = parse_double ( this->value, strlen(this->value) );
+      this->parsed_type = PARSED_DOUBLE;
+    }
 
-  return v;
+  return this->parsed.d;
 }
 
 
 /*
- * Search for the next separator.
- * This function returns the number of bytes read/skipped.
+ * Value of an hexadecimal digit, -1 if the char is not one.
  */
-std::string::size_type
-find_next_separator ( const std::string &str,
-                      const int start )
+static inline int
+hex_digit ( const char c )
 {
-  const char *c = str.c_str ( );
-  const unsigned int str_len = str.length ( );
-  unsigned int i;
-  bool parentheses = false;
+  if ( ( c >= '0' ) && ( c <= '9' ) )
+    return c - '0';
 
-  for ( i=start; i<str_len; ++i )
-    {
-      if ( c[i] == '(' )
-        parentheses = true;
-      else if ( parentheses )
-        {
-          if ( c[i] == ')' )
-            parentheses = false;
-        }
-      else if ( c[i] == ',' )
-        break;
-    }
+  if ( ( c >= 'a' ) && ( c <= 'f' ) )
+    return c - 'a' + 10;
 
-  if ( i == str_len )
-    return std::string::npos;
+  if ( ( c >= 'A' ) && ( c <= 'F' ) )
+    return c - 'A' + 10;
 
-  return i;
+  return -1;
 }
 
 
 /*
- * Read an element from a string representing a sequence (tuple or list).
- * This function returns the number of bytes read/skipped.
+ * Read a color written as #rgb, #rrggbb or #aarrggbb.
+ * Returns false if the string is not such a color.
  */
-inline static int
-get_next_sequence_elem ( const std::string &str,
-                         const int start,
-                         std::string *elem )
+static bool
+parse_color ( const char *str,
+              unsigned int *argb )
 {
-  std::string::size_type separator;
-  std::string raw_elem;
+  unsigned int v = 0;
+  unsigned int i;
+  int d;
+
+  if ( str[0] != '#' )
+    return false;
 
-  /* we get the full element */
-  separator = find_next_separator ( str, start );
+  for ( i=1; str[i]!='\0'; ++i )
+    {
+      d = hex_digit ( str[i] );
 
-  if ( separator == std::string::npos )
-    separator = str.length() - 1; /* if no separator, then we read until the end of the string */
+      if ( ( d < 0 ) || ( i > 8 ) )
+        return false;
 
-  raw_elem = str.substr ( start, separator-start );
-  const unsigned int raw_elem_len = raw_elem.length ( );
+      v = ( v << 4 ) | d;
+    }
 
-  if ( raw_elem_len == 0 )
+  switch ( i-1 )
     {
-      elem->assign ( "" );
-      return 0;
+    case 3:
+      *argb = 0xff000000 | ((v >> 8) * 0x110000) | (((v >> 4) & 0xf) * 0x1100) | ((v & 0xf) * 0x11);
+      return true;
+
+    case 6:
+      *argb = 0xff000000 | v;
+      return true;
+
+    case 8:
+      *argb = v;
+      return true;
     }
 
-  /* we remove useless whitespaces */
-  int i, j;
+  return false;
+}
 
-  for ( i=0; i<(int)raw_elem_len; ++i )
-    if ( !_isspace(raw_elem[i]) )
-      break;
 
-  for ( j=raw_elem_len-1; j>i; --j )
-    if ( !_isspace(raw_elem[j]) )
-      break;
+/*
+ * Convert the attribute's value into a color (0xAARRGGBB).
+ * Returns false if the value is not written in hexadecimal, color names
+ * are left to the caller.
+ */
+bool
+Attribute::getValueAsColor ( unsigned int *argb ) const
+{
+  if ( ( this->parsed_type != PARSED_COLOR ) && ( this->parsed_type != PARSED_NO_COLOR ) )
+    this->parsed_type = parse_color(this->value,&this->parsed.argb) ? PARSED_COLOR : PARSED_NO_COLOR;
 
-  elem->assign ( raw_elem.substr(i,j-i+1) );
+  if ( this->parsed_type == PARSED_NO_COLOR )
+    return false;
 
-  return (separator-start+1); /* +1 so we skip the separator */
+  *argb = this->parsed.argb;
+  return true;
 }
 
 
 /*
- * Returns true if the provided string represents a list, false either.
+ * Scanner over the elements of a sequence (tuple or list).
  */
-inline static bool
-is_list ( const std::string &str )
+typedef struct
 {
-  return ( ( str[0] == '[' ) && ( str[str.length()-1] == ']' ) );
-}
+  const char *ptr;
+  const char *end;   /* closing char */
+  bool done;
+} sequence_scanner;
 
 
 /*
- * Returns true if the provided string represents a tuple, false either.
+ * Start scanning a sequence delimited by the provided chars.
+ * Returns false if the string does not represent such a sequence.
  */
-inline static bool
-is_tuple ( const std::string &str )
+static bool
+start_sequence ( sequence_scanner *s,
+                 const char *str,
+                 const size_t length,
+                 const char open,
+                 const char close )
 {
-  return ( ( str[0] == '(' ) && ( str[str.length()-1] == ')' ) );
+  if ( ( length < 2 ) || ( str[0] != open ) || ( str[length-1] != close ) )
+    return false;
+
+  s->ptr = str + 1;
+  s->end = str + length - 1;
+
+  while ( ( s->ptr < s->end ) && _isspace(*s->ptr) )
+    ++s->ptr;
+
+  s->done = ( s->ptr == s->end ); /* empty sequence */
+
+  return true;
 }
 
 
 /*
- * Returns a douple built from the provided string.
+ * Read the next element of a sequence, without its surrounding whitespaces.
+ * Commas between parentheses do not separate elements.
+ * Returns false at the end of the sequence.
  */
-inline static Douple *
-build_douple_from_string ( const std::string &str )
+static bool
+next_sequence_elem ( sequence_scanner *s,
+                     const char **elem,
+                     size_t *elem_length )
 {
-  Douple *d = new Douple ( );
-          
-  if ( is_tuple(str) )
-    {
-      int i=1; /* skip the '(' char */
-      int len;
-      double v;
+  const char *c = s->ptr;
+  const char *e;
+  bool parentheses = false;
 
-      std::string *elem = new std::string ( );
+  if ( s->done )
+    return false;
 
-      while ( true )
+  for ( ; c<s->end; ++c )
+    {
+      if ( *c == '(' )
+        parentheses = true;
+      else if ( parentheses )
         {
-          len = get_next_sequence_elem ( str, i, elem );
+          if ( *c == ')' )
+            parentheses = false;
+        }
+      else if ( *c == ',' )
+        break;
+    }
 
-          if ( len == 0 )
-            break;
+  for ( e=c; ( e > s->ptr ) && _isspace(e[-1]); --e ) ;
+  while ( ( s->ptr < e ) && _isspace(*s->ptr) )
+    ++s->ptr;
 
-          i += len;
+  *elem = s->ptr;
+  *elem_length = e - s->ptr;
 
-          std::istringstream iss ( *elem );
-          if ( (iss >> std::dec >> v).fail() )
-            v = 0.0;
+  if ( c == s->end )
+    s->done = true;
+  else
+    s->ptr = c + 1;
 
-          d->append ( v );
-        }
+  return true;
+}
 
-      delete elem;
-    }
 
-  return d;
+/*
+ * Count the elements of a sequence.
+ */
+static unsigned int
+count_sequence_elems ( sequence_scanner s )
+{
+  const char *elem;
+  size_t elem_length;
+  unsigned int count = 0;
+
+  while ( next_sequence_elem(&s,&elem,&elem_length) )
+    ++count;
+
+  return count;
 }
 
 
 /*
- * Convert the attribute's value into a douple.
+ * Build a tuple of doubles in the arena from a string of the provided length.
+ * The tuple is empty if the string does not represent one.
  */
-Douple *
-Attribute::getValueAsDouple ( ) const
+static AttributeTuple
+parse_tuple ( Arena *arena,
+              const char *str,
+              const size_t length )
 {
-  return build_douple_from_string ( this->value );
+  sequence_scanner s;
+  const char *elem;
+  size_t elem_length;
+
+  if ( !start_sequence(&s,str,length,'(',')') )
+    return AttributeTuple ( );
+
+  const unsigned int count = count_sequence_elems ( s );
+  double *items = (double *) arena->allocate ( count * sizeof(double) );
+  unsigned int i = 0;
+
+  while ( next_sequence_elem(&s,&elem,&elem_length) )
+    items[i++] = parse_double ( elem, elem_length );
+
+  return AttributeTuple ( items, count );
 }
 
 
 /*
- * Convert the attribute's value into a vector of string.
+ * Convert the attribute's value into a tuple of doubles.
+ * The tuple lives as long as the attribute.
  */
-QStringList *
-Attribute::getValueAsListOfString ( ) const
+AttributeTuple
+Attribute::getValueAsTuple ( ) const
 {
-  QStringList *l = new QStringList ( );
-
-  if ( is_list(this->value) )
+  if ( this->parsed_type != PARSED_TUPLE )
     {
-      int i=1; /* skip the '[' char */
-      int len;
+      const AttributeTuple t = parse_tuple ( this->arena, this->value, strlen(this->value) );
 
-      std::string *elem = new std::string ( );
+      this->parsed.seq.items = t.begin ( );
+      this->parsed.seq.count = t.size ( );
+      this->parsed_type = PARSED_TUPLE;
+    }
 
-      while ( true )
-        {
-          len = get_next_sequence_elem ( this->value, i, elem );
+  return AttributeTuple ( (const double *) this->parsed.seq.items, this->parsed.seq.count );
+}
 
-          if ( len == 0 )
-            break;
 
-          i += len;
+/*
+ * Convert the attribute's value into a list of strings.
+ * The list lives as long as the attribute.
+ */
+AttributeStrings
+Attribute::getValueAsListOfString ( ) const
+{
+  if ( this->parsed_type != PARSED_STRINGS )
+    {
+      sequence_scanner s;
+      const char *elem;
+      size_t elem_length;
+      const char **items = NULL;
+      unsigned int count = 0;
 
-          l->append ( QString::fromStdString(*elem) );
+      if ( start_sequence(&s,this->value,strlen(this->value),'[',']') )
+        {
+          items = (const char **) this->arena->allocate ( count_sequence_elems(s) * sizeof(const char *) );
+
+          while ( next_sequence_elem(&s,&elem,&elem_length) )
+            items[count++] = this->arena->copy ( elem, elem_length );
         }
 
-      delete elem;
+      this->parsed.seq.items = items;
+      this->parsed.seq.count = count;
+      this->parsed_type = PARSED_STRINGS;
     }
 
-  return l;
+  return AttributeStrings ( (const char * const *) this->parsed.seq.items, this->parsed.seq.count );
 }
 
 
 /*
- * Convert the attribute's value into a vector of douple.
+ * Convert the attribute's value into a list of tuples of doubles.
+ * The list lives as long as the attribute.
  */
-QList<Douple *> *
-Attribute::getValueAsVectorOfDouple ( ) const
+AttributeTuples
+Attribute::getValueAsListOfTuple ( ) const
 {
-  QList<Douple *> *v = new QList<Douple *> ( );
-
-  if ( is_list(this->value) )
+  if ( this->parsed_type != PARSED_TUPLES )
     {
-      int i=1; /* skip the '[' char */
-      int len;
+      sequence_scanner s;
+      const char *elem;
+      size_t elem_length;
+      AttributeTuple *items = NULL;
+      unsigned int count = 0;
 
-      std::string *elem = new std::string ( );
-      Douple *d;
-
-      while ( true )
+      if ( start_sequence(&s,this->value,strlen(this->value),'[',']') )
         {
-          len = get_next_sequence_elem ( this->value, i, elem );
-
-          if ( len == 0 )
-            break;
-
-          i += len;
+          items = (AttributeTuple *) this->arena->allocate ( count_sequence_elems(s) * sizeof(AttributeTuple) );
 
-          d = build_douple_from_string ( *elem );
-          v->append ( d );
+          while ( next_sequence_elem(&s,&elem,&elem_length) )
+            new ( &items[count++] ) AttributeTuple ( parse_tuple(this->arena,elem,elem_length) );
         }
 
-      delete elem;
+      this->parsed.seq.items = items;
+      this->parsed.seq.count = count;
+      this->parsed_type = PARSED_TUPLES;
     }
 
-  return v;
+  return AttributeTuples ( (const AttributeTuple *) this->parsed.seq.items, this->parsed.seq.count );
 }
 
 
@@ -470,7 +602,7 @@ std::ostream &
 operator << ( std::ostream &out,
               Attribute &a )
 {
-  out << a.name << "=\"" << a.value << "\"";
+  out << a.name << "=\"" << a.getValue() << "\"";
   return out;
 }
 
@@ -27,20 +27,57 @@
 #include <string>
 #include <QtCore>
 
+#include "arena.h"
+
 
 /* A Douple is a list (tuple) of double */
 typedef struct QList<double> Douple;
 
 
+/*
+ * A view on a sequence parsed from an attribute's value.
+ * The items live in the arena of the attribute.
+ */
+template <typename T>
+class AttributeSequence
+{
+
+ public:
+  AttributeSequence ( ) : items(NULL), count(0) { }
+  AttributeSequence ( const T *items, const unsigned int count ) : items(items), count(count) { }
+
+  inline unsigned int size ( ) const { return count; }
+  inline const T &operator [] ( const unsigned int i ) const { return items[i]; }
+
+  inline const T *begin ( ) const { return items; }
+  inline const T *end ( ) const { return items+count; }
+
+ private:
+  const T *items;
+  unsigned int count;
+
+} ;
+
+typedef AttributeSequence<double> AttributeTuple;            /* "(1.5, 2)" */
+typedef AttributeSequence<const char *> AttributeStrings;    /* "[n0, n1]" */
+typedef AttributeSequence<AttributeTuple> AttributeTuples;   /* "[(0, 1), (2, 3)]" */
+
+
 class Attribute
 {
 
  public:
-  Attribute ( const char *, const char *value=NULL );
+  Attribute ( Arena *, const char *, const char *value=NULL, const bool inSitu=false );
   ~Attribute ( );
 
   bool isNamed ( const char * ) const;
 
+  /*
+   * Get the attribute's name.
+   */
+  inline const char *getName ( ) const
+    { return this->name; }
+
   void setValue ( const char * );
   void setValue ( const int );
   void setValue ( const double );
@@ -48,18 +85,39 @@ class Attribute
   void setValue ( QStringList * );
   void setValue ( QList<Douple *> * );
 
-  const char *getValue ( ) const;
+  /*
+   * Get the attribute's value.
+   */
+  inline const char *getValue ( ) const
+    { return this->value; }
+
   int getValueAsInt ( ) const;
   double getValueAsDouble ( ) const;
-  Douple *getValueAsDouple ( ) const;
-  QStringList *getValueAsListOfString ( ) const;
-  QList<Douple *> *getValueAsVectorOfDouple ( ) const;
+  bool getValueAsColor ( unsigned int * ) const;          /* #rgb, #rrggbb or #aarrggbb to 0xAARRGGBB */
+  AttributeTuple getValueAsTuple ( ) const;
+  AttributeStrings getValueAsListOfString ( ) const;
+  AttributeTuples getValueAsListOfTuple ( ) const;
 
   friend std::ostream & operator << ( std::ostream &, Attribute & );
 
  private:
-  std::string name;
-  std::string value;
+  /* what the value was last converted to */
+  typedef enum { PARSED_NONE, PARSED_INT, PARSED_DOUBLE, PARSED_COLOR, PARSED_NO_COLOR,
+                 PARSED_TUPLE, PARSED_STRINGS, PARSED_TUPLES } ParsedType ;
+
+  Arena *arena;       /* where the values are copied */
+  const char *name;   /* interned */
+  const char *value;
+
+  /* cache of the typed value, not thread-safe */
+  mutable ParsedType parsed_type;
+  mutable union
+  {
+    int i;
+    double d;
+    unsigned int argb;
+    struct { const void *items; unsigned int count; } seq;
+  } parsed;
 
 } ;
 
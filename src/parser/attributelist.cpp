@@ -3,7 +3,8 @@
  *
  * Implementation of the AttributeList object's methods.
  *
- * Please note that there is no check for duplicate elements.
+ * Please note that there is no check for duplicate elements: the
+ * latest attribute of a name hides the previous ones.
  *
  * This file is distributed as part of Kroket.
  * Copyright (c) 2010 Nicolas BENOIT
@@ -23,22 +24,96 @@
  * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+#include <new>
+#include <cstring>
+
+#include "nametable.h"
 #include "attributelist.h"
 
 
+#define TABLE_INITIAL_SIZE 8
+
+
 /*
  * Constructor
+ * Attributes are carved from the provided arena.
+ */
+AttributeList::AttributeList ( Arena *arena )
+{
+  this->arena = arena;
+  this->head = NULL;
+  this->tail = NULL;
+  this->slots = NULL;
+  this->mask = 0;
+  this->count = 0;
+}
+
+
+/*
+ * Put an attribute in the table, replacing an attribute of the same name.
+ * The table must have a free slot.
+ */
+void
+AttributeList::insert ( attr_chain *ac )
+{
+  unsigned int i;
+
+  for ( i=slot_of(ac->id); this->slots[i]!=NULL; i=(i+1)&this->mask )
+    if ( this->slots[i]->id == ac->id )
+      {
+        this->slots[i] = ac;
+        return;
+      }
+
+  this->slots[i] = ac;
+  ++this->count;
+}
+
+
+/*
+ * Build a new table of the provided size from the chain of attributes.
+ * The old table is only reclaimed with the arena.
+ */
+void
+AttributeList::rebuild ( const unsigned int size )
+{
+  attr_chain *ac;
+
+  this->slots = (attr_chain **) this->arena->allocate ( size * sizeof(attr_chain *) );
+  memset ( this->slots, 0, size * sizeof(attr_chain *) );
+  this->mask = size - 1;
+  this->count = 0;
+
+  for ( ac=this->head; ac!=NULL; ac=ac->next )
+    this->insert ( ac );
+}
+
+
+/*
+ * Chain a new attribute after the others and index it.
  */
-AttributeList::AttributeList ( )
+Attribute *
+AttributeList::append ( Attribute *a )
 {
-  this->list[0] = NULL;
-  this->list[1] = NULL;
-  this->list[2] = NULL;
-  this->list[3] = NULL;
-  this->list[4] = NULL;
-  this->list[5] = NULL;
-  this->list[6] = NULL;
-  this->list[7] = NULL;
+  attr_chain *ac = (attr_chain *) this->arena->allocate ( sizeof(attr_chain) );
+
+  ac->attr = a;
+  ac->id = NameTable::id ( a->getName() );
+  ac->next = NULL;
+
+  if ( this->tail == NULL )
+    this->head = ac;
+  else
+    this->tail->next = ac;
+
+  this->tail = ac;
+
+  if ( 2*(this->count+1) > this->mask+1 )
+    this->rebuild ( ( this->slots == NULL ) ? TABLE_INITIAL_SIZE : 2*(this->mask+1) );
+  else
+    this->insert ( ac );
+
+  return a;
 }
 
 
@@ -50,90 +125,87 @@ Attribute *
 AttributeList::add ( const char *name,
                      const char *value )
 {
-  attr_chain *ac = new attr_chain;
-  attr_chain **l = &this->list[name[0] & 0x07];
+  return this->append ( new ( this->arena->allocate(sizeof(Attribute)) ) Attribute ( this->arena, name, value ) );
+}
 
-  ac->attr = new Attribute ( name, value );
-  ac->next = *l;
-  *l = ac;
 
-  return ac->attr;
+/*
+ * Add a new attribute without copying it.
+ * The name has to be interned and the value has to live as long as the list.
+ * Returns a pointer to the added attribute or NULL if an error occured.
+ */
+Attribute *
+AttributeList::addInSitu ( const char *name,
+                           const char *value )
+{
+  return this->append ( new ( this->arena->allocate(sizeof(Attribute)) ) Attribute ( this->arena, name, value, true ) );
 }
 
 
 /*
  * Access to an attribute.
- * This function should be used parsimionously as it is slow.
+ * Prefer the access by ID when the name is known at compile time.
  * Returns a pointer to the requested attribute or NULL if not found.
  */
 Attribute *
 AttributeList::get ( const char *req ) const
 {
-  attr_chain *ac = this->list[req[0] & 0x07];
+  const char *name;
 
-  while ( ac != NULL )
-    {
-      if ( ac->attr->isNamed(req) )
-        return ac->attr;
+  if ( this->count == 0 )
+    return NULL;
 
-      ac = ac->next;
-    }
+  name = NameTable::find ( req );
+
+  if ( name == NULL )
+    return NULL; /* never interned, no attribute has this name */
 
-  return NULL;
+  return this->get ( NameTable::id(name) );
 }
 
 
 /*
  * Remove an attribute.
- * If the list contains any duplicate element, only one will be removed.
+ * If the list contains any duplicate element, only the latest one is removed.
+ * Its memory is only reclaimed with the arena.
  */
 void
 AttributeList::remove ( const char *req )
 {
-  attr_chain **prev = &this->list[req[0] & 0x07];
-  attr_chain *ac = *prev;
+  Attribute *a = this->get ( req );
+  attr_chain **prev = &this->head;
+  attr_chain *last = NULL;
 
-  while ( ac != NULL )
+  if ( a == NULL )
+    return;
+
+  while ( (*prev)->attr != a )
     {
-      if ( ac->attr->isNamed(req) )
-        {
-          (*prev)->next = ac->next;
+      last = *prev;
+      prev = &(*prev)->next;
+    }
 
-          delete ac->attr;
-          delete ac;
-          return;
-        }
+  *prev = (*prev)->next;
 
-      ac = ac->next;
-    }
+  if ( *prev == NULL )
+    this->tail = last;
+
+  this->rebuild ( this->mask+1 );
 }
 
 
 /*
  * Clear the attributes list.
+ * Their memory is only reclaimed with the arena.
  */
 void
 AttributeList::clear ( )
 {
-  int i;
-  attr_chain *tmp;
-  attr_chain *ac;
-
-  for ( i=0; i<8; ++i )
-    {
-      ac = this->list[0];
-
-      while ( ac != NULL )
-        {
-          tmp = ac;
-          ac = ac->next;
-
-          delete tmp->attr;
-          delete tmp;
-        }
-
-      this->list[i] = NULL;
-    }
+  this->head = NULL;
+  this->tail = NULL;
+  this->slots = NULL;
+  this->mask = 0;
+  this->count = 0;
 }
 
 
@@ -142,5 +214,4 @@ AttributeList::clear ( )
  */
 AttributeList::~AttributeList ( )
 {
-  this->clear ( );
 }
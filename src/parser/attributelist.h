@@ -28,52 +28,82 @@
 #include <iostream>
 #include <string>
 
+#include "arena.h"
 #include "attribute.h"
 
 
 /*
- * Internal structure (chained list)
+ * Internal structure (chained list, in the order of addition)
  */
 typedef struct _attr_chain attr_chain;
 
 struct _attr_chain
 {
   Attribute *attr;
+  unsigned int id;    /* of the name */
   attr_chain *next;
 } ;
 
 
 /*
  * AttributeList
+ * The attributes are found by the ID of their name in a small
+ * open-addressing table, which is carved from the arena too.
  */
 class AttributeList
 {
 
  public:
-  AttributeList ( );
+  AttributeList ( Arena * );
   ~AttributeList ( );
 
   Attribute *add ( const char *, const char * );
+  Attribute *addInSitu ( const char *, const char * ); /* the value is not copied */
   Attribute *get ( const char * ) const;
   void remove ( const char * );
   void clear ( );
 
+  /*
+   * Access to an attribute by the ID of its name (see NameTable).
+   * Returns a pointer to the requested attribute or NULL if not found.
+   */
+  inline Attribute *get ( const unsigned int id ) const
+    {
+      unsigned int i;
+
+      if ( this->count == 0 )
+        return NULL;
+
+      for ( i=slot_of(id); this->slots[i]!=NULL; i=(i+1)&this->mask )
+        if ( this->slots[i]->id == id )
+          return this->slots[i]->attr;
+
+      return NULL;
+    }
+
  private:
-  attr_chain *list[8];
+  Arena *arena;
+  attr_chain *head;
+  attr_chain *tail;
+
+  attr_chain **slots; /* latest attribute of each name */
+  unsigned int mask;  /* number of slots - 1 */
+  unsigned int count;
+
+  inline unsigned int slot_of ( const unsigned int id ) const
+    { return ( ( id * 2654435761u ) >> 16 ) & this->mask; }
+
+  Attribute *append ( Attribute * );
+  void insert ( attr_chain * );
+  void rebuild ( const unsigned int );
 
 
  public:
   class iterator
     {
     public:
-      iterator ( attr_chain **l )
-        {
-          list = l;
-          i = -1;
-
-          do { ptr = list[++i]; }
-          while ( ( ptr==NULL ) && ( i!=7 ) ) ;
-        }
+      iterator ( attr_chain *ac )
+        { ptr = ac; }
 
       ~iterator ( )
         { }
@@ -83,15 +113,6 @@ class AttributeList
           Attribute *a;
           a = ptr->attr;
           ptr = ptr->next;
-
-          while ( i != 7 )
-            {
-              if ( ptr != NULL )
-                break;
-
-              ptr = list[++i];
-            }
-
           return a;
         }
 
@@ -100,12 +121,10 @@ class AttributeList
 
     private:
       attr_chain *ptr;
-      attr_chain **list;
-      int i;
     } ;
 
   inline AttributeList::iterator iterate ( )
-    { return iterator(list); };
+    { return iterator(head); };
 
 } ;
 
@@ -0,0 +1,379 @@
+/*
+ * compiledfile.cpp
+ *
+ * This file implements the methods of the CompiledFile class.
+ * Compiled files hold the entities of a text file as records that
+ * point into a table of strings, so that loading one is only a matter
+ * of mapping it and walking the records.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <cassert>
+#include <new>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "nametable.h"
+#include "compiledfile.h"
+
+
+/*
+ * Sections of a mapped compiled file.
+ */
+typedef struct
+{
+  const kkb_header *header;
+  const uint32_t *names;
+  const kkb_entity *entities;
+  const kkb_attribute *attributes;
+  const char *strings;
+} kkb_sections;
+
+
+/*
+ * Find the sections of a compiled file, checking that they fit in it.
+ * Throws a ParserException if the file is not a valid compiled file.
+ */
+static kkb_sections
+find_sections ( const char *content,
+                const size_t size )
+{
+  kkb_sections s;
+  size_t offset;
+
+  if ( ( size < sizeof(kkb_header) ) || !CompiledFile::isCompiled(content,size) )
+    throw new ParserException ( "not a compiled file" );
+
+  s.header = (const kkb_header *) content;
+
+  if ( ( s.header->version != KKB_VERSION ) || ( s.header->byte_order != KKB_BYTE_ORDER ) )
+    throw new ParserException ( "compiled file of another version or byte order" );
+
+  offset = sizeof ( kkb_header );
+  s.names = (const uint32_t *) ( content + offset );
+  offset += (size_t) s.header->name_count * sizeof(uint32_t);
+  s.entities = (const kkb_entity *) ( content + offset );
+  offset += (size_t) s.header->entity_count * sizeof(kkb_entity);
+  s.attributes = (const kkb_attribute *) ( content + offset );
+  offset += (size_t) s.header->attribute_count * sizeof(kkb_attribute);
+  s.strings = content + offset;
+  offset += s.header->strings_size;
+
+  if ( ( offset != size ) || ( s.header->strings_size == 0 ) ||
+       ( s.strings[s.header->strings_size-1] != '\0' ) )
+    throw new ParserException ( "truncated compiled file" );
+
+  return s;
+}
+
+
+/*
+ * Intern the names of a compiled file.
+ */
+static std::vector<const char *>
+intern_names ( const kkb_sections &s )
+{
+  std::vector<const char *> names ( s.header->name_count );
+  uint32_t i;
+
+  for ( i=0; i<s.header->name_count; ++i )
+    {
+      if ( s.names[i] >= s.header->strings_size )
+        throw new ParserException ( "corrupted compiled file" );
+
+      names[i] = NameTable::intern ( s.strings + s.names[i] );
+    }
+
+  return names;
+}
+
+
+/*
+ * Add the attributes of an entity record to an entity.
+ * Returns the index of the first attribute of the next record.
+ */
+static uint32_t
+add_attributes ( const kkb_sections &s,
+                 const std::vector<const char *> &names,
+                 const kkb_entity *record,
+                 uint32_t first,
+                 Entity *e )
+{
+  const kkb_attribute *a;
+  uint32_t i;
+
+  if ( record->attribute_count > s.header->attribute_count - first )
+    throw new ParserException ( "corrupted compiled file" );
+
+  for ( i=0; i<record->attribute_count; ++i )
+    {
+      a = &s.attributes[first+i];
+
+      if ( ( a->name >= names.size() ) || ( a->value >= s.header->strings_size ) )
+        throw new ParserException ( "corrupted compiled file" );
+
+      e->attributes->addInSitu ( names[a->name], s.strings + a->value );
+    }
+
+  return first + record->attribute_count;
+}
+
+
+/*
+ * Check the type of an entity record.
+ */
+static inline void
+check_type ( const std::vector<const char *> &names,
+             const kkb_entity *record )
+{
+  if ( record->type >= names.size() )
+    throw new ParserException ( "corrupted compiled file" );
+}
+
+
+/*
+ * Tables of a compiled file being written.
+ */
+typedef struct
+{
+  std::vector<uint32_t> names;
+  std::unordered_map<const char *,uint32_t> name_index;     /* names are interned */
+  std::unordered_map<std::string,uint32_t> string_offset;
+  std::string strings;
+} kkb_tables;
+
+
+/*
+ * Get the offset of a string, adding it to the strings if needed.
+ */
+static uint32_t
+add_string ( kkb_tables *t,
+             const char *str )
+{
+  std::unordered_map<std::string,uint32_t>::const_iterator found = t->string_offset.find ( str );
+
+  if ( found != t->string_offset.end() )
+    return found->second;
+
+  const uint32_t offset = t->strings.size ( );
+  t->strings.append ( str, strlen(str)+1 );
+  t->string_offset[str] = offset;
+
+  return offset;
+}
+
+
+/*
+ * Get the index of an interned name, adding it to the names if needed.
+ */
+static uint32_t
+add_name ( kkb_tables *t,
+           const char *name )
+{
+  std::unordered_map<const char *,uint32_t>::const_iterator found = t->name_index.find ( name );
+
+  if ( found != t->name_index.end() )
+    return found->second;
+
+  const uint32_t index = t->names.size ( );
+  t->names.push_back ( add_string(t,name) );
+  t->name_index[name] = index;
+
+  return index;
+}
+
+
+/*
+ * Compare two entities' rank in the file they were read from.
+ */
+static bool
+compare_sequences ( const Entity *e1,
+                    const Entity *e2 )
+{
+  return e1->getSequence() < e2->getSequence();
+}
+
+
+/*
+ * Write an entity list to a compiled file.
+ * The entities are written in the order they were added to the list,
+ * that is the order of the text file they were read from, so that
+ * visiting the compiled file sees them as visiting the text file does.
+ */
+void
+CompiledFile::write ( const EntityList *l,
+                      const char *file_name )
+{
+  std::vector<const Entity *> entities;
+  std::vector<kkb_attribute> attributes;
+  std::vector<kkb_entity> records;
+  kkb_tables t;
+  kkb_header header;
+  struct stat st;
+  unsigned int i;
+
+  assert ( l != NULL );
+  assert ( file_name != NULL );
+
+  /* the list iterates type by type, back to the order they were added in */
+  EntityList::iterator iter = l->iterate ( );
+
+  while ( iter.hasNext() )
+    entities.push_back ( iter.next() );
+
+  std::sort ( entities.begin(), entities.end(), compare_sequences );
+
+  for ( i=0; i<entities.size(); ++i )
+    {
+      AttributeList::iterator attr_iter = entities[i]->iterateOverAttributes ( );
+      kkb_entity record;
+      kkb_attribute ka;
+      Attribute *a;
+
+      record.type = add_name ( &t, entities[i]->getType() );
+      record.attribute_count = 0;
+
+      while ( attr_iter.hasNext() )
+        {
+          a = attr_iter.next ( );
+
+          ka.name = add_name ( &t, a->getName() );
+          ka.value = add_string ( &t, a->getValue() );
+          attributes.push_back ( ka );
+
+          ++record.attribute_count;
+        }
+
+      records.push_back ( record );
+    }
+
+  if ( t.strings.empty() )
+    t.strings.push_back ( '\0' );
+
+  memcpy ( header.magic, KKB_MAGIC, sizeof(header.magic) );
+  header.version = KKB_VERSION;
+  header.byte_order = KKB_BYTE_ORDER;
+  header.name_count = t.names.size ( );
+  header.entity_count = records.size ( );
+  header.attribute_count = attributes.size ( );
+  header.strings_size = t.strings.size ( );
+
+  /* open the output file */
+  std::ofstream fout ( file_name, std::ios::out|std::ios::trunc|std::ios::binary );
+
+  if ( !fout.good() )
+    {
+      std::cerr << __FILE__ << "(" << __LINE__ << "): write(): " << strerror(errno) << std::endl;
+      throw new ParserException ( strerror(errno) );
+    }
+
+  fout.write ( (const char *) &header, sizeof(header) );
+  fout.write ( (const char *) t.names.data(), t.names.size()*sizeof(uint32_t) );
+  fout.write ( (const char *) records.data(), records.size()*sizeof(kkb_entity) );
+  fout.write ( (const char *) attributes.data(), attributes.size()*sizeof(kkb_attribute) );
+  fout.write ( t.strings.data(), t.strings.size() );
+
+  fout.close ( );
+
+  /* a truncated file must not be mistaken for a good one */
+  if ( fout.fail() )
+    {
+      std::cerr << __FILE__ << "(" << __LINE__ << "): write(): " << strerror(errno) << std::endl;
+      if ( ( stat(file_name,&st) == 0 ) && S_ISREG(st.st_mode) )
+        unlink ( file_name );
+
+      throw new ParserException ( "cannot write the compiled file" );
+    }
+}
+
+
+/*
+ * Returns true if the provided content starts like a compiled file.
+ * Text files start with an entity or a blank.
+ */
+bool
+CompiledFile::isCompiled ( const char *content,
+                           const size_t size )
+{
+  return ( size >= sizeof(KKB_MAGIC)-1 ) && ( memcmp(content,KKB_MAGIC,sizeof(KKB_MAGIC)-1) == 0 );
+}
+
+
+/*
+ * Add the entities of a compiled file to a list.
+ * The values of the attributes point into the content, which has to
+ * live as long as the list.
+ */
+void
+CompiledFile::load ( const char *content,
+                     const size_t size,
+                     EntityList *l )
+{
+  const kkb_sections s = find_sections ( content, size );
+  const std::vector<const char *> names = intern_names ( s );
+  const kkb_entity *record;
+  uint32_t i, first = 0;
+  Entity *e;
+
+  for ( i=0; i<s.header->entity_count; ++i )
+    {
+      record = &s.entities[i];
+      check_type ( names, record );
+
+      e = l->addEntityWithType ( names[record->type] );
+      first = add_attributes ( s, names, record, first, e );
+    }
+}
+
+
+/*
+ * Hand the entities of a compiled file to a visitor, one at a time.
+ * The entities are not kept: each one only lives during its callback.
+ */
+void
+CompiledFile::visit ( const char *content,
+                      const size_t size,
+                      EntityVisitor *visitor )
+{
+  const kkb_sections s = find_sections ( content, size );
+  const std::vector<const char *> names = intern_names ( s );
+  const kkb_entity *record;
+  uint32_t i, first = 0;
+  Arena arena;
+  Entity *e;
+
+  for ( i=0; i<s.header->entity_count; ++i )
+    {
+      record = &s.entities[i];
+      check_type ( names, record );
+
+      e = new ( arena.allocate(sizeof(Entity)) ) Entity ( names[record->type], &arena );
+      first = add_attributes ( s, names, record, first, e );
+
+      visitor->visit ( e );
+      arena.rewind ( );
+    }
+}
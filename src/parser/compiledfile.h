@@ -0,0 +1,87 @@
+/*
+ * compiledfile.h
+ *
+ * Declaration of the CompiledFile class.
+ * It writes and reads the binary form of an entity list (.kkb files),
+ * which is mapped in memory and read without any parsing.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __COMPILEDFILE_H__
+#define __COMPILEDFILE_H__
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "entitylist.h"
+#include "entityvisitor.h"
+
+
+/*
+ * Layout of a compiled file, in the byte order of the machine
+ * that wrote it:
+ *
+ *   kkb_header     header
+ *   uint32_t       names[name_count]              offsets in the strings
+ *   kkb_entity     entities[entity_count]         in the order of the text file
+ *   kkb_attribute  attributes[attribute_count]    those of each entity in turn
+ *   char           strings[strings_size]          null-terminated, each stored once
+ */
+#define KKB_MAGIC       "KKB"
+#define KKB_VERSION     1
+#define KKB_BYTE_ORDER  0x01020304u
+
+typedef struct
+{
+  char magic[3];
+  char version;
+  uint32_t byte_order;
+  uint32_t name_count;
+  uint32_t entity_count;
+  uint32_t attribute_count;
+  uint32_t strings_size;
+} kkb_header;
+
+typedef struct
+{
+  uint32_t type;              /* index in the names */
+  uint32_t attribute_count;
+} kkb_entity;
+
+typedef struct
+{
+  uint32_t name;              /* index in the names */
+  uint32_t value;             /* offset in the strings */
+} kkb_attribute;
+
+
+class CompiledFile
+{
+
+ public:
+  static void write ( const EntityList *, const char * );
+
+  static bool isCompiled ( const char *, const size_t );
+  static void load ( const char *, const size_t, EntityList * );      /* attributes point into the content */
+  static void visit ( const char *, const size_t, EntityVisitor * );
+
+} ;
+
+
+#endif
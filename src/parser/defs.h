@@ -78,4 +78,52 @@
 #define ATTR_TEXT         "text"
 
 
+/*
+ * IDs of the names above in the name table, which registers them first
+ * and in this order (see NameTable::id).
+ */
+typedef enum
+{
+  NAME_NONE = 0,
+
+  NAME_ENTITY_INFO,
+  NAME_ENTITY_NODE,
+  NAME_ENTITY_EDGE,
+  NAME_ENTITY_GROUP,
+
+  NAME_INFO_TITLE,
+  NAME_INFO_COMMENTS,
+  NAME_INFO_DATE,
+  NAME_INFO_REVISION,
+
+  NAME_NODE_ID,
+  NAME_NODE_TAGS,
+  NAME_NODE_SHAPE,
+
+  NAME_EDGE_SRC_PORT,
+  NAME_EDGE_SRC_STYLE,
+  NAME_EDGE_SRC_TEXT,
+  NAME_EDGE_DEST_PORT,
+  NAME_EDGE_DEST_STYLE,
+  NAME_EDGE_DEST_TEXT,
+
+  NAME_GROUP_CONTENTS,
+
+  NAME_PEN_COLOR,
+  NAME_PEN_STYLE,
+  NAME_PEN_WIDTH,
+  NAME_BRUSH_COLOR,
+  NAME_BRUSH_STYLE,
+  NAME_FONT_COLOR,
+  NAME_FONT_STYLE,
+  NAME_FONT_SIZE,
+  NAME_TEXT,
+
+  NAME_KNOWN_COUNT,
+
+  NAME_EDGE_ID = NAME_NODE_ID,         /* same names */
+  NAME_GROUP_SHAPE = NAME_NODE_SHAPE
+} NameId ;
+
+
 #endif
@@ -22,21 +22,28 @@
  */
 
 #include <map>
+#include <new>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 
+#include "nametable.h"
 #include "entity.h"
 
 
 /*
  * Constructor
+ * The type has to be interned, the attributes are carved from the arena.
  */
-Entity::Entity ( const char *type )
+Entity::Entity ( const char *type,
+                 Arena *arena )
 {
   assert ( type != NULL );
 
-  this->type.assign ( type );
-  this->attributes = new AttributeList ( );
+  this->type = type;
+  this->arena = arena;
+  this->sequence = 0;
+  this->attributes = new ( arena->allocate(sizeof(AttributeList)) ) AttributeList ( arena );
 }
 
 
@@ -59,6 +66,72 @@ Entity::parseAndAddAttributeFromString ( const std::string *str )
 }
 
 
+/*
+ * Parse an attribute and add it to an existing entity, without copying it.
+ * The value is null-terminated in place of its closing '"', so the
+ * buffer must be writable and live as long as the entity. In a private
+ * mapping of a file, this write copies the page it falls in.
+ */
+void
+Entity::parseAndAddAttributeInSitu ( char *str,
+                                     const unsigned int length )
+{
+  const char *eq;
+  unsigned int i;
+
+  eq = (const char *) memchr ( str, '=', length );
+
+  if ( eq == NULL )
+    {
+      this->attributes->addInSitu ( NameTable::intern(str,length), "" );
+      return;
+    }
+
+  i = eq - str;
+
+  if ( length < i+3 ) /* no room for the two '"' */
+    {
+      this->attributes->addInSitu ( NameTable::intern(str,i), "" );
+      return;
+    }
+
+  str[length-1] = '\0';
+
+  this->attributes->addInSitu ( NameTable::intern(str,i), str+i+2 );
+}
+
+
+/*
+ * Parse an attribute and add it to an existing entity.
+ * The value is copied into the arena of the entity.
+ */
+void
+Entity::parseAndAddAttribute ( const char *str,
+                               const unsigned int length )
+{
+  const char *eq;
+  unsigned int i;
+
+  eq = (const char *) memchr ( str, '=', length );
+
+  if ( eq == NULL )
+    {
+      this->attributes->addInSitu ( NameTable::intern(str,length), "" );
+      return;
+    }
+
+  i = eq - str;
+
+  if ( length < i+3 ) /* no room for the two '"' */
+    {
+      this->attributes->addInSitu ( NameTable::intern(str,i), "" );
+      return;
+    }
+
+  this->attributes->addInSitu ( NameTable::intern(str,i), this->arena->copy(str+i+2,length-i-3) );
+}
+
+
 /*
  * Output an entity to an output stream.
  */
@@ -87,5 +160,4 @@ operator << ( std::ostream &out, Entity &e )
  */
 Entity::~Entity ( )
 {
-  delete this->attributes;
 }
@@ -26,6 +26,7 @@
 
 #include <string>
 #include <iostream>
+#include "defs.h"
 #include "attributelist.h"
 
 
@@ -33,7 +34,7 @@ class Entity
 {
 
  public:
-  Entity ( const char * );
+  Entity ( const char *, Arena * );
   ~Entity ( );
 
   /*
@@ -43,6 +44,21 @@ class Entity
     { attributes->add ( name, val ); }
 
   void parseAndAddAttributeFromString ( const std::string * );
+  void parseAndAddAttributeInSitu ( char *, const unsigned int );
+  void parseAndAddAttribute ( const char *, const unsigned int );
+
+  /*
+   * Get the type of an entity.
+   */
+  inline const char *getType ( ) const
+    { return this->type; }
+
+  /*
+   * Get the rank of an entity in the list it was added to,
+   * which is its rank in the file it was read from.
+   */
+  inline unsigned int getSequence ( ) const
+    { return this->sequence; }
 
   /*
    * Get the attribute with the provided name of an entity.
@@ -51,6 +67,12 @@ class Entity
   inline Attribute *getAttribute ( const char *name ) const
     { return this->attributes->get ( name ); }
 
+  /*
+   * Same, with the ID of a name of defs.h.
+   */
+  inline Attribute *getAttribute ( const NameId id ) const
+    { return this->attributes->get ( (unsigned int) id ); }
+
   /*
    * Get the value of the attribute which has the provided name.
    * Returns NULL if the attribute can not be found.
@@ -61,6 +83,15 @@ class Entity
       return ( a==NULL ) ? NULL : a->getValue() ;
     }
 
+  /*
+   * Same, with the ID of a name of defs.h.
+   */
+  inline const char *getValueOfAttribute ( const NameId id ) const
+    {
+      Attribute *a = getAttribute ( id );
+      return ( a==NULL ) ? NULL : a->getValue() ;
+    }
+
   /*
    * Get an iterator over the attributes of an entity.
    */
@@ -71,7 +102,11 @@ class Entity
   friend std::ostream & operator << ( std::ostream &, Entity & );
 
  private:
-  std::string type;
+  const char *type;   /* interned */
+  Arena *arena;       /* where the attributes are carved from */
+  unsigned int sequence; /* rank in its list */
+
+  friend class EntityList;
 
  public:
   AttributeList *attributes;
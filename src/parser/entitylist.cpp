@@ -5,6 +5,8 @@
  *
  * Handles a set of entities, which are stored according to their type.
  * There is no check for duplicate elements.
+ * Entities and their attributes are carved from an arena owned by the
+ * list, and are all freed at once when the list is cleared.
  *
  * This file is distributed as part of Kroket.
  * Copyright (c) 2010 Nicolas BENOIT
@@ -36,7 +38,18 @@
 #include <fstream>
 #include <cassert>
 #include <cerrno>
+#include <new>
+#include <vector>
+#include <QtConcurrent>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "entitylist.h"
+#include "compiledfile.h"
+#include "nametable.h"
+#include "defs.h"
 #include "masked_isspace.h"
 
 
@@ -46,32 +59,166 @@
 EntityList::EntityList ( )
 {
   this->sets = NULL;
+  this->entity_count = 0;
+  this->content = NULL;
+  this->content_size = 0;
 }
 
 
+#if defined(__AVX2__) || defined(__SSE2__)
+
 /*
- * Read the next un-interrupted sequence of non-space characters
- * and copy it into the provided string.
+ * The vectorized scanner
+ *
+ * Characters are classified a block at a time, into one bit per
+ * character for the whitespaces, the quotes and the backslashes.
+ * A quote is escaped when the character before it is a backslash.
+ * The prefix XOR of the remaining quotes tells which characters are
+ * quoted, so the end of a word is its first unquoted whitespace.
+ * The quoting state and the last backslash are carried over to the
+ * next block. The end of the buffer is scanned one byte at a time.
+ *
+ */
+
+#if defined(__AVX2__)
+#define SCAN_BLOCK 32
+#define SCAN_MASK  0xffffffffu
+#else
+#define SCAN_BLOCK 16
+#define SCAN_MASK  0x0000ffffu
+#endif
+
+
+/*
+ * Classify a block of characters.
+ */
+static inline void
+classify_block ( const char *ptr,
+                 unsigned int *spaces,
+                 unsigned int *quotes,
+                 unsigned int *backslashes )
+{
+#if defined(__AVX2__)
+  const __m256i c = _mm256_loadu_si256 ( (const __m256i *) ptr );
+  __m256i s;
+
+  s = _mm256_cmpeq_epi8 ( c, _mm256_set1_epi8(' ') );
+  s = _mm256_or_si256 ( s, _mm256_cmpeq_epi8(c,_mm256_set1_epi8('\t')) );
+  s = _mm256_or_si256 ( s, _mm256_cmpeq_epi8(c,_mm256_set1_epi8('\n')) );
+  s = _mm256_or_si256 ( s, _mm256_cmpeq_epi8(c,_mm256_set1_epi8('\v')) );
+  s = _mm256_or_si256 ( s, _mm256_cmpeq_epi8(c,_mm256_set1_epi8('\r')) );
+
+  *spaces = (unsigned int) _mm256_movemask_epi8 ( s );
+  *quotes = (unsigned int) _mm256_movemask_epi8 ( _mm256_cmpeq_epi8(c,_mm256_set1_epi8('\"')) );
+  *backslashes = (unsigned int) _mm256_movemask_epi8 ( _mm256_cmpeq_epi8(c,_mm256_set1_epi8('\\')) );
+#else
+  const __m128i c = _mm_loadu_si128 ( (const __m128i *) ptr );
+  __m128i s;
+
+  s = _mm_cmpeq_epi8 ( c, _mm_set1_epi8(' ') );
+  s = _mm_or_si128 ( s, _mm_cmpeq_epi8(c,_mm_set1_epi8('\t')) );
+  s = _mm_or_si128 ( s, _mm_cmpeq_epi8(c,_mm_set1_epi8('\n')) );
+  s = _mm_or_si128 ( s, _mm_cmpeq_epi8(c,_mm_set1_epi8('\v')) );
+  s = _mm_or_si128 ( s, _mm_cmpeq_epi8(c,_mm_set1_epi8('\r')) );
+
+  *spaces = (unsigned int) _mm_movemask_epi8 ( s );
+  *quotes = (unsigned int) _mm_movemask_epi8 ( _mm_cmpeq_epi8(c,_mm_set1_epi8('\"')) );
+  *backslashes = (unsigned int) _mm_movemask_epi8 ( _mm_cmpeq_epi8(c,_mm_set1_epi8('\\')) );
+#endif
+}
+
+
+/*
+ * Set each bit to the XOR of itself and all the lower bits.
+ */
+static inline unsigned int
+prefix_xor ( unsigned int x )
+{
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+
+  return x;
+}
+
+#endif
+
+
+/*
+ * Find the next un-interrupted sequence of non-space characters.
  * This function returns the number of bytes read/skipped.
  */
 inline static int
-get_word ( const char *start,
-           const char *limit,
-           std::string *str )
+get_token ( const char *start,
+            const char *limit,
+            const char **word,
+            unsigned int *length )
 {
   const char *ptr;
-  const char *word;
   char prev;
   bool quoting;
 
-  for ( ptr=start; ptr!=limit; ++ptr )
+  ptr = start;
+
+#ifdef SCAN_BLOCK
+  unsigned int spaces, quotes, backslashes, quoted, ends;
+  unsigned int inside = 0;     /* all ones when the previous block ended quoted */
+  unsigned int escape = 0;     /* 1 when the previous block ended with a backslash */
+
+  /* skip the whitespaces a block at a time */
+  while ( limit-ptr >= SCAN_BLOCK )
+    {
+      classify_block ( ptr, &spaces, &quotes, &backslashes );
+
+      if ( spaces != SCAN_MASK )
+        {
+          ptr += __builtin_ctz ( ~spaces );
+          break;
+        }
+
+      ptr += SCAN_BLOCK;
+    }
+#endif
+
+  for ( ; ptr!=limit; ++ptr )
     if ( !_isspace(*ptr) )
       break;
 
-  word = ptr;
+  *word = ptr;
   quoting = false;
   prev = ' ';
 
+#ifdef SCAN_BLOCK
+  /* find the first unquoted whitespace a block at a time */
+  while ( limit-ptr >= SCAN_BLOCK )
+    {
+      classify_block ( ptr, &spaces, &quotes, &backslashes );
+
+      quotes &= ~( ( backslashes << 1 ) | escape );
+      quoted = ( prefix_xor(quotes) ^ inside ) & SCAN_MASK;
+      ends = spaces & ~quoted;
+
+      if ( ends != 0 )
+        {
+          ptr += __builtin_ctz ( ends );
+          *length = ptr - *word;
+
+          return ptr-start;
+        }
+
+      inside = ( quoted >> (SCAN_BLOCK-1) ) ? ~0u : 0u;
+      escape = ( backslashes >> (SCAN_BLOCK-1) ) & 1;
+      ptr += SCAN_BLOCK;
+    }
+
+  quoting = ( inside != 0 );
+
+  if ( ptr != *word )
+    prev = ptr[-1];
+#endif
+
   while ( ptr!=limit )
     {
       if ( ( *ptr == '\"' ) && ( prev != '\\' ) )
@@ -89,22 +236,425 @@ get_word ( const char *start,
       ++ptr;
     }
 
-  str->assign ( word, ptr-word );
+  *length = ptr - *word;
 
   return ptr-start;
 }
 
 
 /*
- * Read entities from a file.
+ * Read the next un-interrupted sequence of non-space characters
+ * and copy it into the provided string.
+ */
+inline static int
+get_word ( const char *start,
+           const char *limit,
+           std::string *str )
+{
+  const char *word;
+  unsigned int length;
+  int skipped;
+
+  skipped = get_token ( start, limit, &word, &length );
+  str->assign ( word, length );
+
+  return skipped;
+}
+
+
+/*
+ * Read the entities of a part of a file.
  */
 void
-EntityList::parseFromFile ( const char *file_name )
+EntityList::parseRange ( const char *begin,
+                         const char *limit,
+                         const bool inSitu )
 {
-  assert ( file_name != NULL );
+  std::string *str = new std::string ( );
+  const char *word;
+  unsigned int length;
+  const char *ptr = begin;
+  Entity *e;
 
-  this->clear ( );
+  while ( ( ptr = (const char *) memchr(ptr,'<',limit-ptr) ) != NULL ) /* entity start character */
+    {
+      ++ptr;
+
+      if ( inSitu )
+        {
+          ptr += get_token ( ptr, limit, &word, &length );
+          e = this->addEntityWithType ( NameTable::intern(word,length) );
+        }
+      else
+        {
+          ptr += get_word ( ptr, limit, str );
+          e = this->addEntityWithType ( str->c_str() );
+        }
+
+      while ( true )
+        {
+          ptr += get_token ( ptr, limit, &word, &length );
+
+          if ( length == 0 )
+            break;
+
+          if ( ( word[0] == '/' ) && /* entity end */
+               ( length > 1 ) && ( word[1] == '>' ) )
+            break;
+
+          if ( inSitu )
+            e->parseAndAddAttributeInSitu ( (char *) word, length );
+          else
+            {
+              str->assign ( word, length );
+              e->parseAndAddAttributeFromString ( str );
+            }
+        }
+    }
+
+  delete str;
+}
+
+
+/*
+ * Get the set that has the requested name.
+ * Returns NULL if the set couldn't be found.
+ */
+static inline entity_set *
+get_set_with_type ( entity_set *eset,
+                    const char *type )
+{
+  while ( eset != NULL )
+    {
+      if ( ( eset->type == type ) || ( strcmp(eset->type,type) == 0 ) )
+        return eset;
+
+      eset = eset->next;
+    }
+
+  return NULL;
+}
+
+
+/*
+ * Parallel parsing
+ *
+ * A file is split into about as many chunks per thread as
+ * CHUNKS_PER_THREAD, of at least CHUNK_MIN_SIZE bytes each. A chunk
+ * has to start with an entity: at a '<' that is not quoted, and that
+ * comes right after the "/>" of the previous entity. Whether a byte is
+ * quoted depends on the number of quotes before it, so the unescaped
+ * quotes of each chunk are counted first, in parallel. Then each
+ * chunk moves its start to its first safe '<' and is parsed into its
+ * own list. The lists are appended in file order, so the entities of
+ * each type end up in the same order as with a sequential parsing.
+ *
+ */
+
+#define CHUNKS_PER_THREAD 4
+#define CHUNK_MIN_SIZE    (1024*1024)
+
+
+class ParsingChunk
+{
+ public:
+  const char *begin;
+  const char *end;
+  unsigned int quotes;  /* number of unescaped quotes, then quoting state at begin */
+  bool found;           /* a safe start was found */
+  EntityList *list;
+  Arena *arena;         /* entities of a visited chunk, in file order */
+  QList<Entity *> *entities;
+} ;
+
+
+/*
+ * Count the unescaped quotes of a part of a file.
+ */
+static unsigned int
+count_quotes ( const char *file,
+               const char *begin,
+               const char *end )
+{
+  unsigned int n = 0;
+  const char *ptr = begin;
+
+  while ( ( ptr = (const char *) memchr(ptr,'\"',end-ptr) ) != NULL )
+    {
+      if ( ( ptr == file ) || ( ptr[-1] != '\\' ) )
+        ++n;
+
+      ++ptr;
+    }
+
+  return n;
+}
+
+
+/*
+ * Find the first entity start of a part of a file.
+ * Returns NULL if there is none.
+ */
+static const char *
+find_entity_start ( const char *file,
+                    const char *begin,
+                    const char *end,
+                    bool quoting )
+{
+  const char *ptr, *p;
+  char prev;
+
+  prev = ( begin != file ) ? begin[-1] : ' ';
+
+  for ( ptr=begin; ptr!=end; ++ptr )
+    {
+      if ( ( *ptr == '\"' ) && ( prev != '\\' ) )
+        quoting = !quoting;
+      else if ( ( *ptr == '<' ) && !quoting )
+        {
+          /* the previous word has to be an entity end */
+          for ( p=ptr; ( p != file ) && _isspace(p[-1]); --p ) ;
+
+          if ( ( p-file >= 3 ) && ( p[-1] == '>' ) && ( p[-2] == '/' ) && _isspace(p[-3]) && ( p != ptr ) )
+            return ptr;
+        }
+
+      prev = *ptr;
+    }
+
+  return NULL;
+}
+
+
+/*
+ * Functor used to count the quotes of the chunks in parallel.
+ */
+class QuoteCountingKernel
+{
+ public:
+  typedef void result_type;
+
+  QuoteCountingKernel ( const char *file ) : file(file) { }
+
+  void operator() ( ParsingChunk &c ) const
+  {
+    c.quotes = count_quotes ( file, c.begin, c.end );
+  }
+
+ private:
+  const char *file;
+} ;
+
+
+/*
+ * Functor used to find the start of the chunks in parallel.
+ */
+class ChunkStartKernel
+{
+ public:
+  typedef void result_type;
+
+  ChunkStartKernel ( const char *file ) : file(file) { }
+
+  void operator() ( ParsingChunk &c ) const
+  {
+    const char *start;
+
+    if ( c.begin == file )
+      {
+        c.found = true;
+        return;
+      }
+
+    start = find_entity_start ( file, c.begin, c.end, ( c.quotes & 1 ) != 0 );
+    c.found = ( start != NULL );
+
+    if ( c.found )
+      c.begin = start;
+  }
+
+ private:
+  const char *file;
+} ;
+
+
+/*
+ * Functor used to parse the chunks in parallel.
+ */
+class ChunkParsingKernel
+{
+ public:
+  typedef void result_type;
+
+  ChunkParsingKernel ( const bool inSitu ) : inSitu(inSitu) { }
+
+  void operator() ( ParsingChunk &c ) const
+  {
+    c.list = new EntityList ( );
+    c.list->parseRange ( c.begin, c.end, inSitu );
+  }
+
+ private:
+  bool inSitu;
+} ;
+
+
+/*
+ * Split a file in chunks that start at an entity, for parallel reading.
+ * Returns false, leaving the list empty, if the file is too small.
+ */
+static bool
+split_into_chunks ( const char *begin,
+                    const char *limit,
+                    QList<ParsingChunk> &chunks )
+{
+  ParsingChunk c;
+  unsigned int nb, i, quoting;
+  const size_t size = limit - begin;
 
+  chunks.clear ( );
+  nb = QThreadPool::globalInstance()->maxThreadCount() * CHUNKS_PER_THREAD;
+
+  if ( nb > size / CHUNK_MIN_SIZE )
+    nb = size / CHUNK_MIN_SIZE;
+
+  if ( nb < 2 )
+    return false;
+
+  for ( i=0; i<nb; ++i )
+    {
+      c.begin = begin + (size*i)/nb;
+      c.end = begin + (size*(i+1))/nb;
+      c.quotes = 0;
+      c.found = false;
+      c.list = NULL;
+      c.arena = NULL;
+      c.entities = NULL;
+      chunks.append ( c );
+    }
+
+  /* quoting state at the beginning of each chunk */
+  QtConcurrent::blockingMap ( chunks, QuoteCountingKernel(begin) );
+
+  quoting = 0;
+
+  for ( i=0; i<nb; ++i )
+    {
+      const unsigned int n = chunks[i].quotes;
+      chunks[i].quotes = quoting;
+      quoting ^= n & 1;
+    }
+
+  /* a chunk without any entity start is part of the previous one */
+  QtConcurrent::blockingMap ( chunks, ChunkStartKernel(begin) );
+
+  for ( i=nb-1; i>0; --i )
+    {
+      if ( !chunks[i].found )
+        {
+          chunks[i].begin = chunks[i].end;
+          chunks[i-1].end = chunks[i].end;
+        }
+      else
+        chunks[i-1].end = chunks[i].begin;
+    }
+
+  return true;
+}
+
+
+/*
+ * Read the entities of a file, several chunks at the same time.
+ */
+void
+EntityList::parseInChunks ( const char *begin,
+                            const char *limit,
+                            const bool inSitu )
+{
+  QList<ParsingChunk> chunks;
+  int i;
+
+  if ( !split_into_chunks(begin,limit,chunks) )
+    {
+      this->parseRange ( begin, limit, inSitu );
+      return;
+    }
+
+  QtConcurrent::blockingMap ( chunks, ChunkParsingKernel(inSitu) );
+
+  for ( i=0; i<chunks.size(); ++i )
+    {
+      this->append ( *chunks[i].list );
+      delete chunks[i].list;
+    }
+}
+
+
+/*
+ * Move the entities of another list after the ones of this list.
+ * The other list is left empty, its memory now belongs to this list.
+ */
+void
+EntityList::append ( EntityList &other )
+{
+  std::vector<entity_set *> others;
+  entity_set *oset, *eset;
+  entity_chain *ec;
+  int i;
+
+  /* the types of the other list, in the order they appeared,
+     its entities being ranked after the ones of this list */
+  for ( oset=other.sets; oset!=NULL; oset=oset->next )
+    {
+      others.push_back ( oset );
+
+      for ( ec=oset->chain; ec!=NULL; ec=ec->next )
+        ec->entity->sequence += this->entity_count;
+    }
+
+  for ( i=others.size()-1; i>=0; --i )
+    {
+      oset = others[i];
+      eset = get_set_with_type ( this->sets, oset->type );
+
+      if ( eset == NULL )
+        {
+          eset = (entity_set *) this->arena.allocate ( sizeof(entity_set) );
+          eset->type = oset->type;
+          eset->chain = NULL;
+          eset->tail = NULL;
+
+          eset->next = this->sets;
+          this->sets = eset;
+        }
+
+      /* the most recently added entities come first */
+      oset->tail->next = eset->chain;
+
+      if ( eset->chain == NULL )
+        eset->tail = oset->tail;
+
+      eset->chain = oset->chain;
+    }
+
+  this->entity_count += other.entity_count;
+
+  other.sets = NULL;
+  other.entity_count = 0;
+  this->arena.adopt ( other.arena );
+}
+
+
+/*
+ * Map the content of a file in memory
+ * (privately writable if requested, nothing is written back:
+ * the pages that are written to are copied).
+ */
+static char *
+map_file ( const char *file_name,
+           const bool writable,
+           size_t *size )
+{
   /* open the input file and calculate its size */
   int fhandle = open ( file_name, O_RDONLY );
 
@@ -119,7 +669,7 @@ EntityList::parseFromFile ( const char *file_name )
 
   /* mmap file content */
 #ifndef MSWIN
-  char *fmap = (char *) mmap ( 0, fsize, PROT_READ, MAP_PRIVATE, fhandle, 0 );
+  char *fmap = (char *) mmap ( 0, fsize, writable ? PROT_READ|PROT_WRITE : PROT_READ, MAP_PRIVATE, fhandle, 0 );
 
   if ( fmap == MAP_FAILED )
     {
@@ -132,47 +682,241 @@ EntityList::parseFromFile ( const char *file_name )
   read ( fhandle, fmap, fsize );
 #endif
 
+  /* close the input file, the mapping stays */
+  close ( fhandle );
+
+  *size = fsize;
+
+  return fmap;
+}
+
+
+/*
+ * Unmap the content of a file.
+ */
+static void
+unmap_file ( char *fmap,
+             const size_t fsize )
+{
+#ifndef MSWIN
+  munmap ( fmap, fsize );
+#else
+  free ( fmap );
+#endif
+}
+
+
+/*
+ * Read entities from a file.
+ * In situ, the attributes are not copied into the arena: they point
+ * into the content of the file, which is kept by the list until it is
+ * cleared. This is not zero-copy: terminating the values writes into
+ * the private mapping, so nearly every page of a typical file is copied
+ * on write. The resident size ends up close to the copying parser's
+ * (108 MB against 105 MB for a 57 MB file); what is saved is the time
+ * of the copies and the peak, which avoids holding both the mapping
+ * and the copies (111 MB against 165 MB).
+ * In parallel, chunks of the file are read at the same time.
+ * A compiled file is always read in situ, without parsing.
+ */
+void
+EntityList::parseFromFile ( const char *file_name,
+                            const bool inSitu,
+                            const bool parallel )
+{
+  size_t fsize;
+  char *fmap;
+
+  assert ( file_name != NULL );
+
+  this->clear ( );
+
+  /* in situ, values are terminated in place */
+  fmap = map_file ( file_name, inSitu, &fsize );
+
+  if ( CompiledFile::isCompiled(fmap,fsize) )
+    {
+      this->content = fmap;
+      this->content_size = fsize;
+
+      CompiledFile::load ( fmap, fsize, this );
+      return;
+    }
 
   /* parsing */
-  const char *limit = fmap + fsize;
-  std::string *str = new std::string ( );
+  if ( parallel )
+    this->parseInChunks ( fmap, fmap+fsize, inSitu );
+  else
+    this->parseRange ( fmap, fmap+fsize, inSitu );
+
+  /* keep the content if it is pointed to */
+  if ( inSitu )
+    {
+      this->content = fmap;
+      this->content_size = fsize;
+      return;
+    }
+
+  unmap_file ( fmap, fsize );
+}
+
+
+/*
+ * Read the entities of a part of a file and hand them to a visitor.
+ * The entities are allocated in an arena, which is rewound after each
+ * callback if requested.
+ */
+static void
+visit_range ( const char *begin,
+              const char *limit,
+              const bool inSitu,
+              EntityVisitor *visitor,
+              Arena *arena,
+              const bool rewind )
+{
+  const char *type, *word;
+  const char *ptr = begin;
+  unsigned int length;
   Entity *e;
 
-  for ( const char *ptr=fmap; ptr<limit; ++ptr )
+  while ( ( ptr = (const char *) memchr(ptr,'<',limit-ptr) ) != NULL ) /* entity start character */
     {
-      if ( *ptr == '<' ) /* entity start character */
+      ++ptr;
+
+      ptr += get_token ( ptr, limit, &word, &length );
+      type = NameTable::intern ( word, length );
+      e = new ( arena->allocate(sizeof(Entity)) ) Entity ( type, arena );
+
+      while ( true )
         {
-          ++ptr;
+          ptr += get_token ( ptr, limit, &word, &length );
 
-          ptr += get_word ( ptr, limit, str );
+          if ( length == 0 )
+            break;
 
-          e = this->addEntityWithType ( str->c_str() );
+          if ( ( word[0] == '/' ) && /* entity end */
+               ( length > 1 ) && ( word[1] == '>' ) )
+            break;
+
+          if ( inSitu )
+            e->parseAndAddAttributeInSitu ( (char *) word, length );
+          else
+            e->parseAndAddAttribute ( word, length );
+        }
+
+      visitor->visit ( e );
+
+      if ( rewind )
+        arena->rewind ( );
+    }
+}
+
+
+/*
+ * Visitor keeping the entities of a chunk, in file order.
+ */
+class ChunkCollector : public EntityVisitor
+{
+ public:
+  ChunkCollector ( QList<Entity *> *entities ) : entities(entities) { }
+
+  void onInfo ( Entity *e ) { entities->append ( e ); }
+  void onNode ( Entity *e ) { entities->append ( e ); }
+  void onEdge ( Entity *e ) { entities->append ( e ); }
+  void onGroup ( Entity *e ) { entities->append ( e ); }
+
+ private:
+  QList<Entity *> *entities;
+} ;
+
+
+/*
+ * Functor used to read the chunks of a visited file in parallel.
+ */
+class ChunkVisitingKernel
+{
+ public:
+  typedef void result_type;
+
+  ChunkVisitingKernel ( const bool inSitu ) : inSitu(inSitu) { }
+
+  void operator() ( ParsingChunk &c ) const
+  {
+    ChunkCollector collector ( c.entities );
+
+    visit_range ( c.begin, c.end, inSitu, &collector, c.arena, false );
+  }
+
+ private:
+  bool inSitu;
+} ;
+
+
+/*
+ * Read entities from a file and hand them to a visitor, one at a time.
+ * The entities are not kept: each one only lives during its callback.
+ * In situ, the values point into a private mapping of the file (see
+ * parseFromFile). In parallel, as many chunks as the pool has threads
+ * are read at the same time, then visited in file order before the
+ * next ones are read: memory is bounded by these chunks.
+ */
+void
+EntityList::visitFile ( const char *file_name,
+                        EntityVisitor *visitor,
+                        const bool inSitu,
+                        const bool parallel )
+{
+  QList<ParsingChunk> chunks;
+  size_t fsize;
+  char *fmap;
+  Arena arena;
+  int i, j;
+
+  assert ( file_name != NULL );
+  assert ( visitor != NULL );
+
+  fmap = map_file ( file_name, inSitu, &fsize );
+
+  try
+    {
+      if ( CompiledFile::isCompiled(fmap,fsize) )
+        CompiledFile::visit ( fmap, fsize, visitor );
+      else if ( parallel && split_into_chunks(fmap,fmap+fsize,chunks) )
+        {
+          const int batch = QThreadPool::globalInstance()->maxThreadCount ( );
 
-          while ( true )
+          for ( i=0; i<chunks.size(); i+=batch )
             {
-              ptr += get_word ( ptr, limit, str );
+              QList<ParsingChunk> some = chunks.mid ( i, batch );
 
-              if ( str->length() == 0 )
-                break;
+              for ( j=0; j<some.size(); ++j )
+                {
+                  some[j].arena = new Arena ( );
+                  some[j].entities = new QList<Entity *> ( );
+                }
 
-              if ( ( (*str)[0] == '/' ) && /* entity end */
-                   ( (*str)[1] == '>' ) )
-                break;
+              QtConcurrent::blockingMap ( some, ChunkVisitingKernel(inSitu) );
 
-              e->parseAndAddAttributeFromString ( str );
+              for ( j=0; j<some.size(); ++j )
+                {
+                  foreach ( Entity *e, *some[j].entities )
+                    visitor->visit ( e );
+
+                  delete some[j].entities;
+                  delete some[j].arena;
+                }
             }
         }
+      else
+        visit_range ( fmap, fmap+fsize, inSitu, visitor, &arena, true );
+    }
+  catch ( ... )
+    {
+      unmap_file ( fmap, fsize );
+      throw;
     }
 
-  delete str;
-
-  /* close the input file and unmap */
-  close ( fhandle );
-#ifndef MSWIN
-  munmap ( fmap, fsize );
-#else
-  free ( fmap );
-#endif
+  unmap_file ( fmap, fsize );
 }
 
 
@@ -210,22 +954,12 @@ EntityList::unparseToFile ( const char *file_name )
 
 
 /*
- * Get the set that has the requested name.
- * Returns NULL if the set couldn't be found.
+ * Write the entities to a compiled file.
  */
-static inline entity_set *
-get_set_with_type ( entity_set *eset,
-                    const char *type )
+void
+EntityList::compileToFile ( const char *file_name )
 {
-  while ( eset != NULL )
-    {
-      if ( eset->type->compare(type) == 0 )
-        return eset;
-
-      eset = eset->next;
-    }
-
-  return NULL;
+  CompiledFile::write ( this, file_name );
 }
 
 
@@ -240,13 +974,13 @@ EntityList::addEntityWithType ( const char *type )
   entity_chain *ec;
 
   eset = get_set_with_type ( this->sets, type );
-  ec = new entity_chain;
-  ec->entity = new Entity ( type );
+  ec = (entity_chain *) this->arena.allocate ( sizeof(entity_chain) );
 
   if ( eset == NULL )
     {
-      eset = new entity_set;
-      eset->type = new std::string ( type );
+      eset = (entity_set *) this->arena.allocate ( sizeof(entity_set) );
+      eset->type = NameTable::intern ( type );
+      eset->tail = ec;
 
       eset->next = this->sets;
       this->sets = eset;
@@ -256,12 +990,35 @@ EntityList::addEntityWithType ( const char *type )
   else
     ec->next = eset->chain;
 
+  ec->entity = new ( this->arena.allocate(sizeof(Entity)) ) Entity ( eset->type, &this->arena );
+  ec->entity->sequence = this->entity_count++;
   eset->chain = ec;
 
   return ec->entity;
 }
 
 
+/*
+ * Add a copy of an entity (of another list, or handed to a visitor).
+ * Returns a pointer to the added entity.
+ */
+Entity *
+EntityList::addCopyOfEntity ( const Entity *e )
+{
+  Entity *copy = this->addEntityWithType ( e->getType() );
+  AttributeList::iterator iter = e->iterateOverAttributes ( );
+  Attribute *a;
+
+  while ( iter.hasNext() )
+    {
+      a = iter.next ( );
+      copy->addAttribute ( a->getName(), a->getValue() );
+    }
+
+  return copy;
+}
+
+
 /*
  * Build an iterator over entities.
  * A specific type can be provided.
@@ -271,6 +1028,9 @@ EntityList::iterate ( const char *type ) const
 {
   entity_set *eset;
 
+  if ( this->sets == NULL )
+    return iterator();           /* empty list */
+
   if ( type == NULL )
     return iterator(this->sets); /* iterator over all entities */
 
@@ -285,29 +1045,20 @@ EntityList::iterate ( const char *type ) const
 
 /*
  * Clear the entity list.
+ * Everything was carved from the arena, so nothing has to be walked.
  */
 void
 EntityList::clear ( )
 {
-  entity_set *eset;
-  entity_chain *ec;
+  this->sets = NULL;
+  this->entity_count = 0;
+  this->arena.reset ( );
 
-  while ( this->sets != NULL )
+  if ( this->content != NULL )
     {
-      eset = this->sets;
-      this->sets = eset->next;
-
-      while ( eset->chain != NULL )
-        {
-          ec = eset->chain;
-          eset->chain = ec->next;
-
-          delete ec->entity;
-          delete ec;
-        }
-
-      delete eset->type;
-      delete eset;
+      unmap_file ( this->content, this->content_size );
+      this->content = NULL;
+      this->content_size = 0;
     }
 }
 
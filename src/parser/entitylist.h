@@ -30,7 +30,9 @@
 #include <string>
 #include <exception>
 
+#include "arena.h"
 #include "entity.h"
+#include "entityvisitor.h"
 
 
 /*
@@ -48,8 +50,9 @@ typedef struct _entity_set entity_set;
 
 struct _entity_set
 {
-  std::string *type;
+  const char *type;   /* interned */
   entity_chain *chain;
+  entity_chain *tail; /* first added entity */
   entity_set *next;
 } ;
 
@@ -96,15 +99,31 @@ class EntityList
   EntityList ( );
   ~EntityList ( );
 
-  void parseFromFile ( const char * );
+  void parseFromFile ( const char *, const bool inSitu=false, const bool parallel=false ); /* in situ: attributes point into the file content */
   void unparseToFile ( const char * );
+  void compileToFile ( const char * );                          /* binary form, read back by parseFromFile */
+
+  static void visitFile ( const char *, EntityVisitor *,        /* read a file without building a list */
+                          const bool inSitu=false, const bool parallel=false );
 
   Entity *addEntityWithType ( const char * );
+  Entity *addCopyOfEntity ( const Entity * );
   void clear ( );
 
  private:
   entity_set *sets;
-  unsigned int entity_count;
+  unsigned int entity_count; /* entities added so far: the next rank */
+
+  Arena arena;          /* entities, attributes and their chains */
+
+  char *content;        /* file content parsed in situ, NULL if none */
+  size_t content_size;
+
+  void parseRange ( const char *, const char *, const bool );
+  void parseInChunks ( const char *, const char *, const bool );
+  void append ( EntityList & );
+
+  friend class ChunkParsingKernel;
 
 
  public:
@@ -0,0 +1,76 @@
+/*
+ * entityvisitor.h
+ *
+ * Declaration of the EntityVisitor class.
+ * It is handed the entities of a file as they are read, see
+ * EntityList::visitFile(), so that no entity list has to be built.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __ENTITYVISITOR_H__
+#define __ENTITYVISITOR_H__
+
+#include "nametable.h"
+#include "entity.h"
+
+
+class EntityVisitor
+{
+
+ public:
+  virtual ~EntityVisitor ( ) { }
+
+  /*
+   * Callbacks for each type of entity, in the order of the file.
+   * The entity is freed when the callback returns.
+   */
+  virtual void onInfo ( Entity * ) { }
+  virtual void onNode ( Entity * ) { }
+  virtual void onEdge ( Entity * ) { }
+  virtual void onGroup ( Entity * ) { }
+
+  /*
+   * Hand an entity to the callback of its type.
+   */
+  inline void visit ( Entity *e )
+    {
+      switch ( NameTable::id(e->getType()) )
+        {
+        case NAME_ENTITY_NODE:
+          this->onNode ( e );
+          break;
+
+        case NAME_ENTITY_EDGE:
+          this->onEdge ( e );
+          break;
+
+        case NAME_ENTITY_GROUP:
+          this->onGroup ( e );
+          break;
+
+        case NAME_ENTITY_INFO:
+          this->onInfo ( e );
+          break;
+        }
+    }
+
+} ;
+
+
+#endif
@@ -30,7 +30,7 @@
 
 extern char mask_space [ ];
 
-#define masked_isspace(c) (mask_space[(int)c])
+#define masked_isspace(c) (mask_space[(unsigned char)(c)])
 #define _isspace masked_isspace
 
 
@@ -0,0 +1,250 @@
+/*
+ * nametable.cpp
+ *
+ * Implementation of the NameTable class.
+ *
+ * Names are kept in an open-addressing hash table that grows when it
+ * is half full. They are never freed: a graph description only uses
+ * a handful of entity and attribute names. Each thread also keeps
+ * the names it interned in a small cache, so that threads parsing
+ * at the same time seldom wait for the table.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <QtCore>
+
+#include "nametable.h"
+#include "defs.h"
+
+
+#define TABLE_INITIAL_SIZE 64
+#define CACHE_SIZE         64
+
+
+static const char **table = NULL;
+static unsigned int table_size = 0;
+static unsigned int table_count = 0;
+static QMutex table_mutex;
+
+/* registered first, in the order of the NameId enum */
+static const char *known_names[NAME_KNOWN_COUNT] =
+  {
+    NULL,
+    ENTITY_INFO, ENTITY_NODE, ENTITY_EDGE, ENTITY_GROUP,
+    ATTR_INFO_TITLE, ATTR_INFO_COMMENTS, ATTR_INFO_DATE, ATTR_INFO_REVISION,
+    ATTR_NODE_ID, ATTR_NODE_TAGS, ATTR_NODE_SHAPE,
+    ATTR_EDGE_SRC_PORT, ATTR_EDGE_SRC_STYLE, ATTR_EDGE_SRC_TEXT,
+    ATTR_EDGE_DEST_PORT, ATTR_EDGE_DEST_STYLE, ATTR_EDGE_DEST_TEXT,
+    ATTR_GROUP_CONTENTS,
+    ATTR_PEN_COLOR, ATTR_PEN_STYLE, ATTR_PEN_WIDTH,
+    ATTR_BRUSH_COLOR, ATTR_BRUSH_STYLE,
+    ATTR_FONT_COLOR, ATTR_FONT_STYLE, ATTR_FONT_SIZE,
+    ATTR_TEXT
+  };
+
+static thread_local const char *cache[CACHE_SIZE];
+
+
+/*
+ * Hash a name (FNV-1a).
+ */
+static inline unsigned int
+hash_name ( const char *name,
+            const unsigned int length )
+{
+  unsigned int h = 2166136261u;
+  unsigned int i;
+
+  for ( i=0; i<length; ++i )
+    {
+      h ^= (unsigned char) name[i];
+      h *= 16777619u;
+    }
+
+  return h;
+}
+
+
+/*
+ * Compare an interned name with a name (which needs not be null-terminated).
+ */
+static inline bool
+is_name ( const char *interned,
+          const char *name,
+          const unsigned int length )
+{
+  return ( strncmp(interned,name,length) == 0 ) && ( interned[length] == '\0' );
+}
+
+
+/*
+ * Find the slot of a name in the table.
+ * Returns the slot holding the name, or the empty slot where it belongs.
+ */
+static inline unsigned int
+find_slot ( const char *name,
+            const unsigned int length,
+            const unsigned int hash )
+{
+  unsigned int i = hash & ( table_size - 1 );
+
+  while ( table[i] != NULL )
+    {
+      if ( is_name(table[i],name,length) )
+        break;
+
+      i = ( i + 1 ) & ( table_size - 1 );
+    }
+
+  return i;
+}
+
+
+/*
+ * Double the size of the table.
+ */
+static void
+grow_table ( )
+{
+  const char **old_table = table;
+  const unsigned int old_size = table_size;
+  unsigned int i;
+
+  table_size = ( old_size == 0 ) ? TABLE_INITIAL_SIZE : 2*old_size;
+  table = (const char **) calloc ( table_size, sizeof(const char *) );
+
+  for ( i=0; i<old_size; ++i )
+    if ( old_table[i] != NULL )
+      {
+        const unsigned int length = strlen ( old_table[i] );
+        table[find_slot(old_table[i],length,hash_name(old_table[i],length))] = old_table[i];
+      }
+
+  free ( old_table );
+}
+
+
+/*
+ * Add a name to the table, with the next ID.
+ * The table has to be locked.
+ */
+static const char *
+insert_name ( const char *name,
+              const unsigned int length,
+              const unsigned int hash )
+{
+  unsigned int i;
+  char *block;
+
+  if ( 2*(table_count+1) > table_size )
+    grow_table ( );
+
+  i = find_slot ( name, length, hash );
+
+  if ( table[i] == NULL )
+    {
+      block = (char *) malloc ( sizeof(unsigned int) + length + 1 );
+      *((unsigned int *) block) = table_count + 1; /* 0 is no name */
+
+      memcpy ( block+sizeof(unsigned int), name, length );
+      block[sizeof(unsigned int)+length] = '\0';
+
+      table[i] = block + sizeof(unsigned int);
+      ++table_count;
+    }
+
+  return table[i];
+}
+
+
+/*
+ * Register the names of defs.h, so that their IDs are the NameId ones.
+ * The table has to be locked.
+ */
+static void
+register_known_names ( )
+{
+  unsigned int i;
+
+  for ( i=1; i<NAME_KNOWN_COUNT; ++i )
+    {
+      const unsigned int length = strlen ( known_names[i] );
+      const char *interned = insert_name ( known_names[i], length, hash_name(known_names[i],length) );
+
+      assert ( NameTable::id(interned) == i ); /* no duplicate in known_names */
+      (void) interned;
+    }
+}
+
+
+/*
+ * Get the interned copy of a name (which needs not be null-terminated).
+ * The returned string lives as long as the program.
+ */
+const char *
+NameTable::intern ( const char *name,
+                    const unsigned int length )
+{
+  const unsigned int hash = hash_name ( name, length );
+  const char **cached = &cache[hash & (CACHE_SIZE-1)];
+
+  if ( ( *cached != NULL ) && is_name(*cached,name,length) )
+    return *cached;
+
+  QMutexLocker locker ( &table_mutex );
+
+  if ( table == NULL )
+    register_known_names ( );
+
+  *cached = insert_name ( name, length, hash );
+
+  return *cached;
+}
+
+
+/*
+ * Get the interned copy of a name, without interning it.
+ * Returns NULL if the name was never interned, so that looking up
+ * arbitrary names does not fill the table.
+ */
+const char *
+NameTable::find ( const char *name,
+                  const unsigned int length )
+{
+  const unsigned int hash = hash_name ( name, length );
+  const char **cached = &cache[hash & (CACHE_SIZE-1)];
+  const char *found;
+
+  if ( ( *cached != NULL ) && is_name(*cached,name,length) )
+    return *cached;
+
+  QMutexLocker locker ( &table_mutex );
+
+  if ( table == NULL )
+    register_known_names ( );
+
+  found = table[find_slot(name,length,hash)];
+
+  if ( found != NULL )
+    *cached = found;
+
+  return found;
+}
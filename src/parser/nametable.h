@@ -0,0 +1,59 @@
+/*
+ * nametable.h
+ *
+ * Declaration of the NameTable class.
+ * It interns the names of entities and attributes, so that each name
+ * is stored once and can be shared by every entity and attribute.
+ * Each interned name also has a small ID, the names of defs.h having
+ * fixed IDs.
+ *
+ * This file is distributed as part of Kroket.
+ * Copyright (c) 2010 Nicolas BENOIT
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef __NAMETABLE_H__
+#define __NAMETABLE_H__
+
+#include <cstring>
+
+#include "defs.h"
+
+
+class NameTable
+{
+
+ public:
+  static const char *intern ( const char *, const unsigned int ); /* stable copy of a name */
+
+  static inline const char *intern ( const char *name )
+    { return intern ( name, strlen(name) ); }
+
+  static const char *find ( const char *, const unsigned int );   /* interned copy of a name, NULL if it never was */
+
+  static inline const char *find ( const char *name )
+    { return find ( name, strlen(name) ); }
+
+  /*
+   * Get the ID of an interned name, stored right before it.
+   */
+  static inline unsigned int id ( const char *interned )
+    { return ((const unsigned int *) interned)[-1]; }
+
+} ;
+
+
+#endif
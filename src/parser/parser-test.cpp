@@ -20,8 +20,142 @@
  */
 
 #include <unistd.h>
+#include <sys/time.h>
+#include <fstream>
+#include <sstream>
 
 #include "entitylist.h"
+#include "nametable.h"
+
+
+/*
+ * Parse a file (and free the entities) in one of the parsing modes.
+ * Returns the duration in ms, the unparsed entities are saved in out.
+ */
+static double
+run_parsing ( const char *file_name,
+              const bool inSitu,
+              const bool parallel,
+              std::string *out )
+{
+  struct timeval start, end;
+  EntityList *l = new EntityList ( );
+
+  gettimeofday ( &start, NULL );
+  l->parseFromFile ( file_name, inSitu, parallel );
+  l->clear ( );
+  gettimeofday ( &end, NULL );
+
+  l->parseFromFile ( file_name, inSitu, parallel );
+  l->unparseToFile ( "speedtest_out.gd" );
+  delete l;
+
+  std::ifstream fin ( "speedtest_out.gd" );
+  std::ostringstream oss;
+  oss << fin.rdbuf ( );
+  out->assign ( oss.str() );
+  unlink ( "speedtest_out.gd" );
+
+  return ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+}
+
+
+/*
+ * Unparse a list and read back the unparsed file.
+ */
+static std::string
+unparse ( EntityList *l )
+{
+  std::ostringstream oss;
+
+  l->unparseToFile ( "roundtrip_out.gd" );
+
+  std::ifstream fin ( "roundtrip_out.gd" );
+  oss << fin.rdbuf ( );
+  unlink ( "roundtrip_out.gd" );
+
+  return oss.str ( );
+}
+
+
+/*
+ * Visitor writing down the entities and their attributes, in visiting order.
+ */
+class NamingVisitor : public EntityVisitor
+{
+ public:
+  void onInfo ( Entity *e ) { name ( e ); }
+  void onNode ( Entity *e ) { name ( e ); }
+  void onEdge ( Entity *e ) { name ( e ); }
+  void onGroup ( Entity *e ) { name ( e ); }
+
+  std::string names;
+
+ private:
+  void name ( Entity *e )
+  {
+    AttributeList::iterator iter = e->iterateOverAttributes ( );
+    Attribute *a;
+
+    names += e->getType ( );
+
+    while ( iter.hasNext() )
+      {
+        a = iter.next ( );
+        names += ' ';
+        names += a->getName ( );
+        names += '=';
+        names += a->getValue ( );
+      }
+
+    names += '\n';
+  }
+} ;
+
+
+/*
+ * Look up the attributes a styled node is loaded from, as the shapes do.
+ * Returns the duration in ms, the number of found attributes is added to found.
+ */
+static double
+run_lookups ( const EntityList *l,
+              const bool byId,
+              const unsigned int rounds,
+              unsigned long *found )
+{
+  static const NameId ids[] = { NAME_NODE_ID, NAME_NODE_TAGS, NAME_NODE_SHAPE,
+                                NAME_PEN_COLOR, NAME_PEN_STYLE, NAME_PEN_WIDTH,
+                                NAME_BRUSH_COLOR, NAME_BRUSH_STYLE,
+                                NAME_FONT_STYLE, NAME_FONT_SIZE, NAME_TEXT, NAME_FONT_COLOR,
+                                NAME_EDGE_SRC_PORT };  /* not a node attribute */
+  static const char *names[] = { ATTR_NODE_ID, ATTR_NODE_TAGS, ATTR_NODE_SHAPE,
+                                 ATTR_PEN_COLOR, ATTR_PEN_STYLE, ATTR_PEN_WIDTH,
+                                 ATTR_BRUSH_COLOR, ATTR_BRUSH_STYLE,
+                                 ATTR_FONT_STYLE, ATTR_FONT_SIZE, ATTR_TEXT, ATTR_FONT_COLOR,
+                                 ATTR_EDGE_SRC_PORT };
+  struct timeval start, end;
+  unsigned int r, i;
+
+  gettimeofday ( &start, NULL );
+
+  for ( r=0; r<rounds; ++r )
+    {
+      EntityList::iterator iter = l->iterate ( );
+
+      while ( iter.hasNext() )
+        {
+          Entity *e = iter.next ( );
+
+          for ( i=0; i<sizeof(ids)/sizeof(ids[0]); ++i )
+            if ( ( byId ? e->getAttribute(ids[i]) : e->getAttribute(names[i]) ) != NULL )
+              ++(*found);
+        }
+    }
+
+  gettimeofday ( &end, NULL );
+
+  return ((end.tv_sec-start.tv_sec)*1000000.0+(end.tv_usec-start.tv_usec))/1000.0;
+}
 
 
 int
@@ -34,19 +168,20 @@ main ( int argc,
     {
       if ( strcmp("-s",argv[1]) == 0 )
         {
-          /* test speed */
+          /* test speed: copying parser versus in situ parser, sequential and parallel */
           l = new EntityList ( );
 
           char e_name[128];
           char a_names[128][128];
+          unsigned int nb_entities = ( argc > 2 ) ? atoi ( argv[2] ) : 32768;
 
           for ( int i=0; i<64; ++i )
             sprintf ( a_names[i], "attr%d", i );
 
-          for ( unsigned int j=0; j<32768; ++j )
+          for ( unsigned int j=0; j<nb_entities; ++j )
             {
               Entity *e;
-              e = l->addEntityWithType ( "entity" );
+              e = l->addEntityWithType ( ENTITY_NODE );
 
               sprintf ( e_name, "value%d", j );
               e->addAttribute ( "name", e_name );
@@ -60,11 +195,37 @@ main ( int argc,
 
           l->unparseToFile ( "speedtest.gd" );
 
-          l->parseFromFile ( "speedtest.gd" );
-
           delete l;
 
+          std::string copied, in_situ, parallel;
+          double t_copy = run_parsing ( "speedtest.gd", false, false, &copied );
+          double t_in_situ = run_parsing ( "speedtest.gd", true, false, &in_situ );
+          double t_parallel = run_parsing ( "speedtest.gd", true, true, &parallel );
+
+          std::cout << nb_entities << " entities\n";
+          std::cout << "copy              -> " << t_copy << "ms\n";
+          std::cout << "in situ           -> " << t_in_situ << "ms\n";
+          std::cout << "in situ, parallel -> " << t_parallel << "ms (" << QThreadPool::globalInstance()->maxThreadCount() << " threads)\n";
+
+          /* visiting has to see the same nodes in the same order */
+          NamingVisitor visited, visited_parallel;
+
+          EntityList::visitFile ( "speedtest.gd", &visited );
+          EntityList::visitFile ( "speedtest.gd", &visited_parallel, true, true );
+
           unlink ( "speedtest.gd" );
+
+          if ( ( copied != in_situ ) || ( copied != parallel ) )
+            {
+              std::cout << "error: both parsers do not read the same entities\n";
+              return -1;
+            }
+
+          if ( visited.names.empty() || ( visited.names != visited_parallel.names ) )
+            {
+              std::cout << "error: parallel visiting does not see the same entities\n";
+              return -1;
+            }
         }
       else if ( strcmp("-c",argv[1]) == 0 )
         {
@@ -109,12 +270,146 @@ main ( int argc,
               e->attributes->remove ( "afsd" );
               v = e->getValueOfAttribute ( "afsd" );
               std::cout << (v?v:"NULL") << std::endl;
+
+              /* a missed lookup must not intern the name it looked for */
+              v = e->getValueOfAttribute ( "never_used_name" );
+              std::cout << (v?v:"NULL") << std::endl;
+
+              if ( NameTable::find("never_used_name") != NULL )
+                {
+                  std::cout << "error: looking up a name interned it\n";
+                  return -1;
+                }
             }
 
           delete l;
 
           unlink ( "ctest.gd" );
         }
+      else if ( strcmp("-l",argv[1]) == 0 )
+        {
+          /* test speed: attribute lookups by name and by ID */
+          l = new EntityList ( );
+
+          char e_name[128];
+          unsigned int nb_entities = ( argc > 2 ) ? atoi ( argv[2] ) : 16384;
+          const unsigned int rounds = 16;
+          const unsigned long lookups = 13ul * nb_entities * rounds;
+          unsigned long found = 0;
+
+          for ( unsigned int i=0; i<nb_entities; ++i )
+            {
+              Entity *e = l->addEntityWithType ( ENTITY_NODE );
+              sprintf ( e_name, "n%d", i );
+
+              e->addAttribute ( ATTR_NODE_ID, e_name );
+              e->addAttribute ( ATTR_NODE_TAGS, "[a, b]" );
+              e->addAttribute ( ATTR_NODE_SHAPE, "rectangle" );
+              e->addAttribute ( ATTR_PEN_COLOR, "#a9c3c3" );
+              e->addAttribute ( ATTR_PEN_STYLE, "dash" );
+              e->addAttribute ( ATTR_PEN_WIDTH, "2" );
+              e->addAttribute ( ATTR_BRUSH_COLOR, "blue" );
+              e->addAttribute ( ATTR_BRUSH_STYLE, "solid" );
+              e->addAttribute ( ATTR_TEXT, e_name );
+              e->addAttribute ( ATTR_FONT_SIZE, "10" );
+            }
+
+          const double by_name = run_lookups ( l, false, rounds, &found );
+          const double by_id = run_lookups ( l, true, rounds, &found );
+
+          std::cout << lookups << " lookups, " << found/2 << " found" << std::endl;
+          std::cout << "by name: " << by_name << " ms (" << by_name*1e6/lookups << " ns each)" << std::endl;
+          std::cout << "by ID: " << by_id << " ms (" << by_id*1e6/lookups << " ns each)" << std::endl;
+
+          delete l;
+        }
+      else if ( ( strcmp("-b",argv[1]) == 0 ) && ( argc > 2 ) )
+        {
+          /* test the compiled form: it has to unparse and be visited like the text form */
+          int ret = 0;
+
+          for ( int i=2; i<argc; ++i )
+            {
+              EntityList text, compiled;
+              NamingVisitor text_visitor, compiled_visitor;
+
+              text.parseFromFile ( argv[i] );
+              text.compileToFile ( "roundtrip.kkb" );
+              compiled.parseFromFile ( "roundtrip.kkb" );
+
+              EntityList::visitFile ( argv[i], &text_visitor );
+              EntityList::visitFile ( "roundtrip.kkb", &compiled_visitor );
+
+              const bool same = ( unparse(&text) == unparse(&compiled) ) &&
+                                ( text_visitor.names == compiled_visitor.names );
+
+              std::cout << argv[i] << ": " << ( same ? "same" : "DIFFERENT" ) << std::endl;
+
+              if ( !same )
+                ret = 1;
+
+              unlink ( "roundtrip.kkb" );
+            }
+
+          return ret;
+        }
+      else if ( strcmp("-t",argv[1]) == 0 )
+        {
+          /* test typed values */
+          l = new EntityList ( );
+
+          Entity *e = l->addEntityWithType ( "entity" );
+          unsigned int argb, i, j;
+
+          e->addAttribute ( "int", " +42" );
+          e->addAttribute ( "double", "-1.5e2" );
+          e->addAttribute ( "short_color", "#0a3" );
+          e->addAttribute ( "color", "#a9c3c3" );
+          e->addAttribute ( "named_color", "blue" );
+          e->addAttribute ( "tuple", "(1, 2.5 ,-3)" );
+          e->addAttribute ( "ids", "[n0,  n1 , (a, b)]" );
+          e->addAttribute ( "tuples", "[(0, 1), (2, 3), ()]" );
+
+          std::cout << e->getAttribute("int")->getValueAsInt() << std::endl;
+          std::cout << e->getAttribute("double")->getValueAsDouble() << std::endl;
+          std::cout << e->getAttribute("double")->getValueAsInt() << std::endl;
+
+          if ( e->getAttribute("short_color")->getValueAsColor(&argb) )
+            std::cout << std::hex << argb << std::dec << std::endl;
+
+          if ( e->getAttribute("color")->getValueAsColor(&argb) )
+            std::cout << std::hex << argb << std::dec << std::endl;
+
+          if ( !e->getAttribute("named_color")->getValueAsColor(&argb) )
+            std::cout << e->getValueOfAttribute ( "named_color" ) << std::endl;
+
+          const AttributeTuple t = e->getAttribute("tuple")->getValueAsTuple ( );
+
+          for ( i=0; i<t.size(); ++i )
+            std::cout << t[i] << " ";
+          std::cout << std::endl;
+
+          const AttributeStrings ids = e->getAttribute("ids")->getValueAsListOfString ( );
+
+          for ( i=0; i<ids.size(); ++i )
+            std::cout << "'" << ids[i] << "' ";
+          std::cout << std::endl;
+
+          const AttributeTuples tuples = e->getAttribute("tuples")->getValueAsListOfTuple ( );
+
+          for ( i=0; i<tuples.size(); ++i )
+            {
+              std::cout << "(";
+
+              for ( j=0; j<tuples[i].size(); ++j )
+                std::cout << " " << tuples[i][j];
+
+              std::cout << " ) ";
+            }
+          std::cout << std::endl;
+
+          delete l;
+        }
     }
   else
     {
@@ -1,9 +1,16 @@
 # Parser
 
+QT += concurrent
+CONFIG += c++17
+
 HEADERS += $$SRC_DIR/parser/entitylist.h      \
            $$SRC_DIR/parser/entity.h          \
+           $$SRC_DIR/parser/entityvisitor.h   \
+           $$SRC_DIR/parser/compiledfile.h    \
            $$SRC_DIR/parser/attributelist.h   \
            $$SRC_DIR/parser/attribute.h       \
+           $$SRC_DIR/parser/nametable.h       \
+           $$SRC_DIR/parser/arena.h           \
            $$SRC_DIR/parser/masked_isspace.h  \
            $$SRC_DIR/parser/defs.h
 
@@ -11,4 +18,7 @@ SOURCES += $$SRC_DIR/parser/entitylist.cpp    \
            $$SRC_DIR/parser/entity.cpp        \
            $$SRC_DIR/parser/attributelist.cpp \
            $$SRC_DIR/parser/attribute.cpp     \
+           $$SRC_DIR/parser/compiledfile.cpp  \
+           $$SRC_DIR/parser/nametable.cpp     \
+           $$SRC_DIR/parser/arena.cpp         \
            $$SRC_DIR/parser/masked_isspace.cpp